@@ -0,0 +1,84 @@
+
+#ifndef SIMPLE_SOCKET_ASYNC_WRITER_HPP
+#define SIMPLE_SOCKET_ASYNC_WRITER_HPP
+
+#include "simple_socket/SimpleConnection.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ranges>
+#include <span>
+
+namespace simple_socket {
+
+    // What writeAsync() does with a message that would take the queue past the high watermark.
+    enum class OverflowPolicy {
+        Block,     // wait until the writer made room
+        DropOldest,// discard queued messages, oldest first, until it fits
+        Disconnect // give up on the peer: close the writer and the connection
+    };
+
+    struct WriteQueueOptions {
+        // Queued bytes (including the message being written) at which the queue is full.
+        size_t highWatermark{1024 * 1024};
+        // Queued bytes at or below which a full queue counts as drained again.
+        size_t lowWatermark{256 * 1024};
+        OverflowPolicy overflow{OverflowPolicy::DropOldest};
+        // Called with true when the queue fills up and with false when it drained to the low watermark.
+        // Runs on the producer or a writer pool thread with the queue locked, so it must not call into the writer.
+        std::function<void(bool congested)> onBackpressure;
+    };
+
+    // Bounded outbound queue for a connection, so producers (e.g. a broker fanning out to many subscribers) never
+    // wait on a slow peer. Messages are queued and dropped whole. The queues of all writers are drained by a small
+    // pool of shared threads with non-blocking writes; a stalled socket waits for writability, other connections
+    // are retried shortly after. Once a writer exists all writes to the connection must go through it.
+    // The connection must outlive the writer.
+    class AsyncWriter {
+    public:
+        explicit AsyncWriter(SimpleConnection& conn, WriteQueueOptions options = {});
+
+        AsyncWriter(const AsyncWriter&) = delete;
+        AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+        // Queues a copy of the data. Returns false once the writer is closed (write error, Disconnect or close()).
+        bool writeAsync(const uint8_t* data, size_t size);
+
+        // Queues the buffers as one message.
+        bool writeAsync(std::span<const ConstBuffer> buffers);
+
+        bool writeAsync(std::initializer_list<ConstBuffer> buffers) {
+            return writeAsync(std::span(buffers.begin(), buffers.size()));
+        }
+
+        template<class Container>
+            requires std::ranges::contiguous_range<Container> && (sizeof(std::ranges::range_value_t<Container>) == 1)
+        bool writeAsync(const Container& data) {
+            return writeAsync(reinterpret_cast<const uint8_t*>(std::ranges::data(data)), std::ranges::size(data));
+        }
+
+        // Waits until everything queued so far has been written. Returns false if the writer closed instead.
+        bool flush();
+
+        [[nodiscard]] size_t queuedBytes() const;
+
+        // Messages discarded by OverflowPolicy::DropOldest so far.
+        [[nodiscard]] size_t dropped() const;
+
+        [[nodiscard]] bool closed() const;
+
+        // Stops writing and discards queued messages. The connection is left open.
+        void close();
+
+        ~AsyncWriter();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_ASYNC_WRITER_HPP
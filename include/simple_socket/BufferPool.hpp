@@ -0,0 +1,122 @@
+
+#ifndef SIMPLE_SOCKET_BUFFER_POOL_HPP
+#define SIMPLE_SOCKET_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace simple_socket {
+
+    // Slab allocator for message buffers.
+    // Requests are rounded up to power of two size classes (64 bytes to maxBlockSize), blocks are carved out of
+    // larger slabs and recycled through per thread shards, so a steady stream of messages needs no heap allocations.
+    // Larger requests fall back to the heap. All buffers must be released before the pool is destroyed.
+    class BufferPool {
+    public:
+        // RAII handle for a block, returns it to the pool when destroyed.
+        class Buffer {
+        public:
+            Buffer() = default;
+
+            Buffer(const Buffer&) = delete;
+            Buffer& operator=(const Buffer&) = delete;
+
+            Buffer(Buffer&& other) noexcept;
+            Buffer& operator=(Buffer&& other) noexcept;
+
+            [[nodiscard]] uint8_t* data() {
+                return data_;
+            }
+
+            [[nodiscard]] const uint8_t* data() const {
+                return data_;
+            }
+
+            [[nodiscard]] size_t size() const {
+                return size_;
+            }
+
+            [[nodiscard]] size_t capacity() const {
+                return capacity_;
+            }
+
+            [[nodiscard]] bool empty() const {
+                return size_ == 0;
+            }
+
+            uint8_t* begin() {
+                return data_;
+            }
+
+            uint8_t* end() {
+                return data_ + size_;
+            }
+
+            [[nodiscard]] const uint8_t* begin() const {
+                return data_;
+            }
+
+            [[nodiscard]] const uint8_t* end() const {
+                return data_ + size_;
+            }
+
+            uint8_t& operator[](size_t i) {
+                return data_[i];
+            }
+
+            const uint8_t& operator[](size_t i) const {
+                return data_[i];
+            }
+
+            operator std::span<const uint8_t>() const {
+                return {data_, size_};
+            }
+
+            // Growing past the capacity moves the content to a block of a larger size class.
+            void resize(size_t size);
+
+            // Returns the block to the pool early, leaving an empty buffer.
+            void release();
+
+            ~Buffer();
+
+        private:
+            BufferPool* pool_{nullptr};
+            uint8_t* data_{nullptr};
+            size_t size_{0};
+            size_t capacity_{0};
+
+            Buffer(BufferPool* pool, uint8_t* data, size_t size, size_t capacity)
+                : pool_(pool), data_(data), size_(size), capacity_(capacity) {}
+
+            friend class BufferPool;
+        };
+
+        explicit BufferPool(size_t maxBlockSize = 64 * 1024);
+
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        // A buffer of size bytes (uninitialized), with a capacity of the size class it falls into.
+        [[nodiscard]] Buffer acquire(size_t size);
+
+        // Number of heap allocations made so far (slabs and oversized buffers).
+        [[nodiscard]] size_t heapAllocations() const;
+
+        // Process wide pool used by the protocol implementations. Never destroyed.
+        static BufferPool& shared();
+
+        ~BufferPool();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+
+        void recycle(uint8_t* data, size_t capacity);
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_BUFFER_POOL_HPP
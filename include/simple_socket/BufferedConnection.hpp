@@ -0,0 +1,173 @@
+
+#ifndef SIMPLE_SOCKET_BUFFERED_CONNECTION_HPP
+#define SIMPLE_SOCKET_BUFFERED_CONNECTION_HPP
+
+#include "simple_socket/SimpleConnection.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace simple_socket {
+
+    // Read-side buffering decorator for any SimpleConnection.
+    // Small reads (a header byte, a length prefix, a line) are served from an internal buffer that is refilled
+    // with one large read, instead of costing a system call each. Writes are forwarded unchanged.
+    class BufferedConnection: public SimpleConnection {
+    public:
+        explicit BufferedConnection(std::unique_ptr<SimpleConnection> conn, size_t capacity = 4096)
+            : conn_(std::move(conn)), buffer_(capacity == 0 ? 1 : capacity) {}
+
+        using SimpleConnection::read;
+        using SimpleConnection::readUntil;
+        using SimpleConnection::write;
+        using SimpleConnection::writev;
+
+        int read(uint8_t* buffer, size_t size) override {
+
+            if (size == 0) return -1;
+            if (buffered() == 0) {
+                // large reads bypass the buffer
+                if (size >= buffer_.size()) return conn_->read(buffer, size);
+                compact();
+                const int n = conn_->read(buffer_.data() + end_, buffer_.size() - end_);
+                if (n <= 0) return n;// including WouldBlock
+                end_ += static_cast<size_t>(n);
+            }
+            return static_cast<int>(consume(buffer, size));
+        }
+
+        IoResult readUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) override {
+
+            if (buffered() == 0) {
+                if (size >= buffer_.size()) return conn_->readUntil(buffer, size, deadline);
+
+                compact();
+                const auto result = conn_->readUntil(buffer_.data() + end_, buffer_.size() - end_, deadline);
+                if (!result) return result;
+                end_ += result.bytes;
+            }
+            return {IoStatus::Ok, consume(buffer, size)};
+        }
+
+        bool write(const uint8_t* data, size_t size) override {
+            return conn_->write(data, size);
+        }
+
+        bool writev(std::span<const ConstBuffer> buffers) override {
+            return conn_->writev(buffers);
+        }
+
+        IoResult writeUntil(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point deadline) override {
+            return conn_->writeUntil(data, size, deadline);
+        }
+
+        bool writeOwned(std::vector<uint8_t> data, const ReleaseHandler& onRelease = {}) override {
+            return conn_->writeOwned(std::move(data), onRelease);
+        }
+
+        bool enableZeroCopy() override {
+            return conn_->enableZeroCopy();
+        }
+
+        size_t readTxTimestamps(std::span<TxTimestamp> out) override {
+            return conn_->readTxTimestamps(out);
+        }
+
+        void flush() override {
+            conn_->flush();
+        }
+
+        void setMetrics(std::shared_ptr<Metrics> metrics) override {
+            conn_->setMetrics(std::move(metrics));
+        }
+
+        // Returns a view of the next size bytes without consuming them, reading more as needed.
+        // The view is empty if the connection fails first, and is invalidated by the next read.
+        std::span<const uint8_t> peek(size_t size) {
+
+            if (size > buffer_.size()) {
+                compact();
+                buffer_.resize(size);
+            }
+            while (buffered() < size) {
+                if (!fill()) return {};
+            }
+            return {buffer_.data() + pos_, size};
+        }
+
+        // Reads up to and including the delimiter, appending it to out.
+        // Fails if the connection fails or maxSize bytes are read without seeing the delimiter.
+        bool readUntil(std::string_view delimiter, std::string& out, size_t maxSize = 64 * 1024) {
+
+            if (delimiter.empty()) return false;
+
+            size_t searched = 0;// bytes already scanned without a match
+            for (;;) {
+                const std::string_view view(reinterpret_cast<const char*>(buffer_.data() + pos_), buffered());
+                const auto match = view.find(delimiter, searched);
+                if (match != std::string_view::npos) {
+                    const size_t count = match + delimiter.size();
+                    out.append(view.data(), count);
+                    pos_ += count;
+                    return true;
+                }
+                if (view.size() >= maxSize) return false;
+                searched = view.size() >= delimiter.size() ? view.size() - delimiter.size() + 1 : 0;
+
+                if (pos_ == 0 && end_ == buffer_.size()) buffer_.resize(buffer_.size() * 2);
+                if (!fill()) return false;
+            }
+        }
+
+        // Number of bytes received but not yet consumed.
+        [[nodiscard]] size_t buffered() const {
+            return end_ - pos_;
+        }
+
+        [[nodiscard]] SimpleConnection& next() const {
+            return *conn_;
+        }
+
+        void close() override {
+            conn_->close();
+        }
+
+    private:
+        std::unique_ptr<SimpleConnection> conn_;
+        std::vector<uint8_t> buffer_;
+        size_t pos_{0};// next unread byte
+        size_t end_{0};// end of valid data
+
+        size_t consume(uint8_t* buffer, size_t size) {
+            const size_t count = std::min(size, buffered());
+            std::memcpy(buffer, buffer_.data() + pos_, count);
+            pos_ += count;
+            if (pos_ == end_) pos_ = end_ = 0;
+            return count;
+        }
+
+        // move unread bytes to the front, making room at the back
+        void compact() {
+            if (pos_ == 0) return;
+            std::memmove(buffer_.data(), buffer_.data() + pos_, buffered());
+            end_ -= pos_;
+            pos_ = 0;
+        }
+
+        // Appends at least one byte from the underlying connection. Requires free space after compaction.
+        bool fill() {
+            compact();
+            const int n = conn_->read(buffer_.data() + end_, buffer_.size() - end_);
+            if (n <= 0) return false;
+            end_ += static_cast<size_t>(n);
+            return true;
+        }
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_BUFFERED_CONNECTION_HPP
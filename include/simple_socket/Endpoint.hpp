@@ -0,0 +1,57 @@
+
+#ifndef SIMPLE_SOCKET_ENDPOINT_HPP
+#define SIMPLE_SOCKET_ENDPOINT_HPP
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace simple_socket {
+
+    // IPv4 or IPv6 address and port of a datagram peer, parsed once and stored in binary, so that sending to it
+    // or receiving from it does not parse or allocate.
+    class Endpoint {
+    public:
+        // 0.0.0.0:0
+        Endpoint() = default;
+
+        // address must be a numeric IPv4 or IPv6 literal such as "127.0.0.1" or "::1" (optionally with a scope,
+        // "fe80::1%eth0"), throws std::invalid_argument otherwise.
+        Endpoint(const std::string& address, uint16_t port);
+
+        // Looks up a host name (or literal), preferring the first address returned.
+        // Throws std::runtime_error if it does not resolve.
+        static Endpoint resolve(const std::string& host, uint16_t port);
+
+        [[nodiscard]] bool isV6() const {
+            return v6_;
+        }
+
+        [[nodiscard]] std::string address() const;
+
+        [[nodiscard]] uint16_t port() const {
+            return port_;
+        }
+
+        // "address:port", "[address]:port" for IPv6
+        [[nodiscard]] std::string toString() const;
+
+        bool operator==(const Endpoint&) const = default;
+
+    private:
+        friend struct EndpointAccess;
+
+        std::array<uint8_t, 16> address_{};// network byte order, IPv4 uses the first 4 bytes
+        uint32_t scopeId_{0};
+        uint16_t port_{0};
+        bool v6_{false};
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const Endpoint& endpoint) {
+        return os << endpoint.toString();
+    }
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_ENDPOINT_HPP
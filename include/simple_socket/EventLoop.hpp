@@ -0,0 +1,101 @@
+
+#ifndef SIMPLE_SOCKET_EVENT_LOOP_HPP
+#define SIMPLE_SOCKET_EVENT_LOOP_HPP
+
+#include "simple_socket/SimpleConnection.hpp"
+#include "simple_socket/Task.hpp"
+
+#include <memory>
+#include <ranges>
+
+namespace simple_socket {
+
+    // Single threaded scheduler for coroutines doing socket I/O.
+    // All coroutines spawned on a loop (and the async operations they await) run on the thread calling run(),
+    // a suspended coroutine costs a heap frame instead of an OS thread.
+    class EventLoop {
+    public:
+        EventLoop();
+
+        EventLoop(const EventLoop&) = delete;
+        EventLoop& operator=(const EventLoop&) = delete;
+        EventLoop(EventLoop&&) = delete;
+        EventLoop& operator=(EventLoop&&) = delete;
+
+        // Schedules a task to start on the loop thread. Safe to call from any thread.
+        void spawn(Task<> task);
+
+        // Runs the loop on the calling thread until stop() is called.
+        // An exception escaping a spawned task stops the loop and is rethrown here.
+        void run();
+
+        // Makes run() return once the current iteration is done. Safe to call from any thread.
+        void stop();
+
+        // Suspends until the socket behind conn is readable (or writable), for integrating other socket based code.
+        // Resolves to false if conn is not a TCP or Unix domain connection.
+        Task<bool> waitReadable(SimpleConnection& conn);
+        Task<bool> waitWritable(SimpleConnection& conn);
+
+        ~EventLoop();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+
+        friend class AsyncConnection;
+    };
+
+    // A TCP or Unix domain connection driven by an EventLoop. The operations must be awaited on the loop's thread.
+    // At most one read and one write may be outstanding at a time, and the connection must not outlive the loop.
+    class AsyncConnection {
+    public:
+        // Takes over a socket based connection (e.g. from TCPClientContext::connect) and makes it non-blocking.
+        // Throws std::invalid_argument for other transports.
+        AsyncConnection(EventLoop& loop, std::unique_ptr<SimpleConnection> conn);
+
+        AsyncConnection(const AsyncConnection&) = delete;
+        AsyncConnection& operator=(const AsyncConnection&) = delete;
+
+        // Bytes read, or -1 once the peer closed the connection or on error (like SimpleConnection::read).
+        Task<int> asyncRead(uint8_t* buffer, size_t size);
+
+        Task<bool> asyncReadExact(uint8_t* buffer, size_t size);
+
+        // Completes once all bytes are sent, false on error.
+        Task<bool> asyncWrite(const uint8_t* data, size_t size);
+
+        template<class Container>
+            requires std::ranges::contiguous_range<Container>
+        Task<int> asyncRead(Container& buffer) {
+            return asyncRead(reinterpret_cast<uint8_t*>(std::ranges::data(buffer)), std::ranges::size(buffer));
+        }
+
+        template<class Container>
+            requires std::ranges::contiguous_range<Container>
+        Task<bool> asyncReadExact(Container& buffer) {
+            return asyncReadExact(reinterpret_cast<uint8_t*>(std::ranges::data(buffer)), std::ranges::size(buffer));
+        }
+
+        // The data must stay alive until the returned task completes.
+        template<class Container>
+            requires std::ranges::contiguous_range<Container>
+        Task<bool> asyncWrite(const Container& data) {
+            return asyncWrite(reinterpret_cast<const uint8_t*>(std::ranges::data(data)), std::ranges::size(data));
+        }
+
+        // The underlying connection, for synchronous use.
+        [[nodiscard]] SimpleConnection& connection() const;
+
+        void close();
+
+        ~AsyncConnection();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_EVENT_LOOP_HPP
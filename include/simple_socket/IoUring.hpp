@@ -0,0 +1,116 @@
+
+#ifndef SIMPLE_SOCKET_IO_URING_HPP
+#define SIMPLE_SOCKET_IO_URING_HPP
+
+#include "simple_socket/SimpleConnection.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace simple_socket {
+
+    // Result of an asynchronous operation: bytes transferred (> 0), 0 on EOF or a negative errno.
+    using IoCompletion = std::function<void(int result)>;
+
+    class IoUringConnection;
+
+    // Owns a Linux io_uring instance (Linux 5.13+) shared by any number of connections.
+    // Asynchronous operations are queued as SQEs and submitted together by the next run(),
+    // so a batch of sends/receives across many connections costs a single io_uring_enter.
+    // Sockets are registered as fixed files, and synchronous reads/writes go through registered buffers
+    // (both fall back to plain descriptors/buffers when the tables are exhausted).
+    class IoUringContext {
+    public:
+        explicit IoUringContext(unsigned queueDepth = 256,
+                                unsigned maxFixedFiles = 1024,
+                                unsigned numBuffers = 128,
+                                size_t bufferSize = 16 * 1024);
+
+        IoUringContext(const IoUringContext&) = delete;
+        IoUringContext& operator=(const IoUringContext&) = delete;
+        IoUringContext(IoUringContext&&) = delete;
+        IoUringContext& operator=(IoUringContext&&) = delete;
+
+        // Client side connect (blocking), the returned connection performs all I/O through the ring.
+        [[nodiscard]] std::unique_ptr<IoUringConnection> connect(const std::string& ip, uint16_t port);
+
+        // Move an existing TCP or Unix domain connection (e.g. from TCPServer::accept) onto the ring.
+        // Returns nullptr if it is not backed by a plain socket.
+        [[nodiscard]] std::unique_ptr<IoUringConnection> adopt(std::unique_ptr<SimpleConnection> conn);
+
+        // Submits all queued operations, waits for at least one completion if wait is true and
+        // operations are in flight, then invokes the callbacks of everything that completed.
+        // Returns the number of callbacks invoked. Call repeatedly from the thread(s) driving the ring.
+        size_t run(bool wait = true);
+
+        // Number of submitted or queued operations that have not completed yet.
+        [[nodiscard]] size_t inFlight() const;
+
+        // Number of io_uring_enter system calls issued so far.
+        [[nodiscard]] size_t enterCalls() const;
+
+        ~IoUringContext();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+
+        friend class IoUringConnection;
+        friend class IoUringServer;
+    };
+
+    class IoUringConnection: public SimpleConnection {
+    public:
+        using SimpleConnection::read;
+        using SimpleConnection::write;
+
+        // Synchronous interface, each call submits (together with anything queued) and waits for its completion.
+        int read(uint8_t* buffer, size_t size) override;
+        bool write(const uint8_t* data, size_t size) override;
+
+        // Completion based interface. Buffers must stay valid until the callback runs, callbacks run inside
+        // IoUringContext::run() (or a synchronous call on any connection of the same context).
+        void asyncRead(uint8_t* buffer, size_t size, IoCompletion onComplete);
+        // Completes once all bytes are sent (result == size) or on the first error.
+        void asyncWrite(const uint8_t* data, size_t size, IoCompletion onComplete);
+
+        void close() override;
+
+        ~IoUringConnection() override;
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+
+        explicit IoUringConnection(std::unique_ptr<Impl> impl);
+
+        friend struct IoUringContext::Impl;
+    };
+
+    class IoUringServer {
+    public:
+        IoUringServer(IoUringContext& ctx, uint16_t port, int backlog = 128);
+
+        IoUringServer(const IoUringServer&) = delete;
+        IoUringServer& operator=(const IoUringServer&) = delete;
+        IoUringServer(IoUringServer&&) = delete;
+        IoUringServer& operator=(IoUringServer&&) = delete;
+
+        std::unique_ptr<IoUringConnection> accept();
+
+        // The callback receives nullptr if the accept failed (e.g. the server was closed).
+        void asyncAccept(std::function<void(std::unique_ptr<IoUringConnection>)> onAccept);
+
+        void close();
+
+        ~IoUringServer();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_IO_URING_HPP
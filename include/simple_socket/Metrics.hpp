@@ -0,0 +1,117 @@
+
+#ifndef SIMPLE_SOCKET_METRICS_HPP
+#define SIMPLE_SOCKET_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace simple_socket {
+
+    // Distribution of durations in power of two buckets: bucket i counts samples in [2^i, 2^(i+1)) nanoseconds,
+    // the last bucket also everything above.
+    struct LatencyHistogram {
+        static constexpr size_t numBuckets = 32;
+
+        std::array<uint64_t, numBuckets> buckets{};
+        uint64_t count{0};
+        std::chrono::nanoseconds total{0};
+
+        [[nodiscard]] std::chrono::nanoseconds mean() const;
+
+        // Upper bound of the bucket holding the q-quantile (0..1), zero without samples.
+        [[nodiscard]] std::chrono::nanoseconds percentile(double q) const;
+    };
+
+    struct MetricsSnapshot {
+        uint64_t bytesIn{0};
+        uint64_t bytesOut{0};
+        uint64_t readCalls{0};// system calls
+        uint64_t writeCalls{0};
+        uint64_t messagesIn{0};// protocol frames/packets
+        uint64_t messagesOut{0};
+        uint64_t connectionsOpened{0};
+        uint64_t connectionsClosed{0};
+        int64_t queueDepth{0};// buffers handed to the transport and not yet released
+
+        LatencyHistogram readLatency; // per read call, including the wait for data
+        LatencyHistogram writeLatency;// per write call
+    };
+
+    // Counters and latency histograms shared by any number of connections, e.g. one instance per server.
+    // Updates are relaxed atomic adds on a per thread shard (no locks, no shared cache lines between threads),
+    // snapshot() sums the shards. Cheap enough to leave enabled.
+    class Metrics {
+    public:
+        enum class Counter : size_t {
+            BytesIn,
+            BytesOut,
+            ReadCalls,
+            WriteCalls,
+            MessagesIn,
+            MessagesOut,
+            ConnectionsOpened,
+            ConnectionsClosed,
+            QueueDepth
+        };
+
+        enum class Latency {
+            Read,
+            Write
+        };
+
+        Metrics() = default;
+
+        Metrics(const Metrics&) = delete;
+        Metrics& operator=(const Metrics&) = delete;
+
+        void add(Counter counter, int64_t value = 1) noexcept;
+
+        void record(Latency latency, std::chrono::nanoseconds duration) noexcept;
+
+        // Safe to call at any time, concurrent updates may or may not be included.
+        [[nodiscard]] MetricsSnapshot snapshot() const;
+
+        // Records the duration of its own lifetime, does nothing without metrics.
+        class Timer {
+        public:
+            Timer(Metrics* metrics, Latency latency)
+                : metrics_(metrics), latency_(latency) {
+                if (metrics_) start_ = std::chrono::steady_clock::now();
+            }
+
+            Timer(const Timer&) = delete;
+            Timer& operator=(const Timer&) = delete;
+
+            ~Timer() {
+                if (metrics_) metrics_->record(latency_, std::chrono::steady_clock::now() - start_);
+            }
+
+        private:
+            Metrics* metrics_;
+            Latency latency_;
+            std::chrono::steady_clock::time_point start_;
+        };
+
+    private:
+        static constexpr size_t numShards = 8;
+        static constexpr size_t numCounters = static_cast<size_t>(Counter::QueueDepth) + 1;
+
+        struct alignas(64) Shard {
+            std::array<std::atomic<int64_t>, numCounters> counters{};
+            std::array<std::atomic<uint64_t>, LatencyHistogram::numBuckets> readBuckets{};
+            std::array<std::atomic<uint64_t>, LatencyHistogram::numBuckets> writeBuckets{};
+            std::atomic<uint64_t> readTotal{0};
+            std::atomic<uint64_t> writeTotal{0};
+        };
+
+        std::array<Shard, numShards> shards_;
+
+        Shard& shard() noexcept;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_METRICS_HPP
@@ -0,0 +1,67 @@
+
+#ifndef SIMPLE_SOCKET_REACTOR_HPP
+#define SIMPLE_SOCKET_REACTOR_HPP
+
+#include "simple_socket/SimpleConnection.hpp"
+
+#include <functional>
+#include <memory>
+
+namespace simple_socket {
+
+    struct ReactorCallbacks {
+        // Invoked when data (or EOF) is available. Read once; you will be called again while more is pending.
+        // The read may still find nothing (SimpleConnection::WouldBlock), which is not a reason to close.
+        std::function<void(SimpleConnection&)> onReadable;
+        // Invoked when the socket can accept more data, only while enabled through Reactor::setWantWrite.
+        std::function<void(SimpleConnection&)> onWritable;
+        // Invoked once, when the connection is removed from the reactor.
+        std::function<void(SimpleConnection&)> onClose;
+    };
+
+    // Maps each newly accepted connection to the callbacks that should service it.
+    using AcceptHandler = std::function<ReactorCallbacks(SimpleConnection&)>;
+
+    // Event-driven dispatcher for socket based connections (TCP and Unix domain).
+    // A small, fixed pool of threads services any number of non-blocking connections,
+    // instead of one blocking thread per connection.
+    // Callbacks for a given connection are never run concurrently.
+    class Reactor {
+    public:
+        explicit Reactor(size_t numThreads = 1);
+
+        Reactor(const Reactor&) = delete;
+        Reactor& operator=(const Reactor&) = delete;
+        Reactor(Reactor&&) = delete;
+        Reactor& operator=(Reactor&&) = delete;
+
+        // Take ownership of a connection and switch it to non-blocking mode.
+        // Returns false (and drops the connection) if it is not backed by a plain socket.
+        bool add(std::unique_ptr<SimpleConnection> conn, ReactorCallbacks callbacks);
+
+        // Like add(), but the connection remains owned (and eventually closed) by the caller.
+        bool watch(SimpleConnection& conn, ReactorCallbacks callbacks);
+
+        // Toggle onWritable notifications for a registered connection.
+        void setWantWrite(SimpleConnection& conn, bool enable);
+
+        // Deregister a connection, invoking onClose. Owned connections are closed and destroyed.
+        // Safe to call from within the connection's own callbacks.
+        void remove(SimpleConnection& conn);
+
+        [[nodiscard]] size_t size() const;
+
+        void start();
+
+        void stop();
+
+        ~Reactor();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_REACTOR_HPP
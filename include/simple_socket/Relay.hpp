@@ -0,0 +1,48 @@
+
+#ifndef SIMPLE_SOCKET_RELAY_HPP
+#define SIMPLE_SOCKET_RELAY_HPP
+
+#include "simple_socket/SimpleConnection.hpp"
+
+#include <memory>
+
+namespace simple_socket {
+
+    // Forwards everything read from one connection to another until from reaches EOF or either side fails.
+    // When both ends are plain TCP/Unix domain sockets (Linux) the bytes are moved with splice() through a kernel pipe
+    // and never enter user space; anything else (TLS, shared memory, ...) is copied through a buffer of bufferSize.
+    // Returns the number of bytes forwarded.
+    size_t relay(SimpleConnection& from, SimpleConnection& to, size_t bufferSize = 64 * 1024);
+
+    // Bidirectional relay between two connections, e.g. the accepted and the upstream side of a proxy.
+    // EOF in one direction is propagated as a half-close where the transport supports it,
+    // the relay ends once both directions are done (or either fails).
+    class Relay {
+    public:
+        Relay(std::unique_ptr<SimpleConnection> a, std::unique_ptr<SimpleConnection> b, size_t bufferSize = 64 * 1024);
+
+        Relay(const Relay&) = delete;
+        Relay& operator=(const Relay&) = delete;
+        Relay(Relay&&) = delete;
+        Relay& operator=(Relay&&) = delete;
+
+        // Blocks until the relay ends, forwarding b -> a on a helper thread. Closes both connections before returning.
+        void run();
+
+        // Ends a running relay from another thread.
+        void stop();
+
+        // Bytes forwarded so far from a to b and from b to a.
+        [[nodiscard]] size_t bytesForwarded() const;
+        [[nodiscard]] size_t bytesReturned() const;
+
+        ~Relay();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_RELAY_HPP
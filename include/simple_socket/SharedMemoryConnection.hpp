@@ -17,10 +17,20 @@ namespace simple_socket {
         SharedMemoryConnection& operator=(const SharedMemoryConnection&) = delete;
 
         using SimpleConnection::read;
+        using SimpleConnection::readv;
         using SimpleConnection::write;
+        using SimpleConnection::writev;
 
         int read(uint8_t* buffer, size_t size) override;
         bool write(const uint8_t* data, size_t size) override;
+
+        // Messages are transferred whole, so only waiting for the peer is bounded by the deadline.
+        IoResult readUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) override;
+        IoResult writeUntil(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point deadline) override;
+
+        // Copies each buffer straight into/out of the shared segment, without an intermediate join.
+        bool writev(std::span<const ConstBuffer> buffers) override;
+        int readv(std::span<const MutableBuffer> buffers) override;
         void close() override;
 
     private:
@@ -2,16 +2,200 @@
 #ifndef SIMPLE_SOCKET_SIMPLE_CONNECTION_HPP
 #define SIMPLE_SOCKET_SIMPLE_CONNECTION_HPP
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
 #include <ranges>
+#include <span>
+#include <vector>
 
 namespace simple_socket {
 
+    class Metrics;
+
+    // Non-owning view of bytes to be written.
+    struct ConstBuffer {
+        const uint8_t* data{};
+        size_t size{};
+
+        ConstBuffer() = default;
+        ConstBuffer(const uint8_t* data, size_t size)
+            : data(data), size(size) {}
+        ConstBuffer(const char* data, size_t size)
+            : data(reinterpret_cast<const uint8_t*>(data)), size(size) {}
+
+        template<class Container>
+            requires std::ranges::contiguous_range<Container>
+        ConstBuffer(const Container& c)
+            : data(reinterpret_cast<const uint8_t*>(std::ranges::data(c))),
+              size(std::ranges::size(c) * sizeof(std::ranges::range_value_t<Container>)) {}
+    };
+
+    // Non-owning view of writable memory to read into.
+    struct MutableBuffer {
+        uint8_t* data{};
+        size_t size{};
+    };
+
+    enum class IoStatus {
+        Ok,
+        Timeout,// deadline passed; the connection is still usable
+        Closed, // orderly shutdown by the peer
+        Error
+    };
+
+    struct IoResult {
+        IoStatus status{IoStatus::Ok};
+        size_t bytes{};// bytes transferred, also on Timeout
+
+        explicit operator bool() const {
+            return status == IoStatus::Ok;
+        }
+    };
+
+    // Kernel transmit timestamp of a send (SocketOptions::timestamps).
+    struct TxTimestamp {
+        // Which send it belongs to, counting from 0 once timestamps are enabled: the datagram on UDP,
+        // the offset of the last byte of the write in the stream on TCP.
+        uint32_t id{};
+        std::chrono::system_clock::time_point time;// handed to the network device
+    };
+
+    // Receives a buffer handed to SimpleConnection::writeOwned back once the connection no longer references it.
+    using ReleaseHandler = std::function<void(std::vector<uint8_t> buffer)>;
+
     class SimpleConnection {
     public:
+        // Returned by read() and readv() of a non-blocking connection (e.g. one serviced by a Reactor) when no data
+        // is available yet, wait for the next readable notification. -1 means the connection closed or failed.
+        static constexpr int WouldBlock = -2;
+
         virtual int read(uint8_t* buffer, size_t size) = 0;
         virtual bool write(const uint8_t* data, size_t size) = 0;
 
+        // Gather write: all buffers are sent as one logical write (a single message on message based transports).
+        // The default implementation joins the buffers and calls write().
+        virtual bool writev(std::span<const ConstBuffer> buffers) {
+
+            size_t total = 0;
+            for (const auto& b : buffers) total += b.size;
+
+            std::vector<uint8_t> joined(total);
+            size_t offset = 0;
+            for (const auto& b : buffers) {
+                if (b.size == 0) continue;
+                std::memcpy(joined.data() + offset, b.data, b.size);
+                offset += b.size;
+            }
+            return write(joined.data(), joined.size());
+        }
+
+        // Scatter read: fills the buffers in order from a single read, which waits for the first bytes only.
+        // Returns bytes read or -1.
+        // The default implementation reads into a temporary and copies out.
+        virtual int readv(std::span<const MutableBuffer> buffers) {
+
+            size_t total = 0;
+            for (const auto& b : buffers) total += b.size;
+
+            std::vector<uint8_t> tmp(total);
+            const int n = read(tmp.data(), tmp.size());
+            if (n <= 0) return n;
+
+            size_t offset = 0;
+            for (const auto& b : buffers) {
+                if (offset >= static_cast<size_t>(n)) break;
+                const size_t count = std::min(b.size, static_cast<size_t>(n) - offset);
+                std::memcpy(b.data, tmp.data() + offset, count);
+                offset += count;
+            }
+            return n;
+        }
+
+        // Ownership transferring write: the connection keeps data alive for as long as the transport references it
+        // (with zero-copy sends that is until the kernel confirms transmission) and then passes it to onRelease
+        // for reuse. onRelease may run inside a later call on this connection.
+        // The default implementation writes a copy and releases the buffer immediately.
+        virtual bool writeOwned(std::vector<uint8_t> data, const ReleaseHandler& onRelease = {}) {
+            const bool ok = write(data.data(), data.size());
+            if (onRelease) onRelease(std::move(data));
+            return ok;
+        }
+
+        // Opt in to zero-copy sends for large writes where the transport supports it (Linux TCP, MSG_ZEROCOPY).
+        // Returns false if unsupported, in which case writes keep copying.
+        virtual bool enableZeroCopy() {
+            return false;
+        }
+
+        // Waits until no buffer passed to writeOwned() is referenced by the transport any more, releasing them all.
+        virtual void flush() {}
+
+        // Report this connection's I/O (bytes, system calls, latencies) to metrics, which may be shared with other
+        // connections. Set it before the connection is used from several threads. Ignored by transports without
+        // instrumentation.
+        virtual void setMetrics(std::shared_ptr<Metrics>) {}
+
+        // Takes the transmit timestamps reported so far, oldest first, without waiting (SocketOptions::timestamps,
+        // Linux). The kernel reports them shortly after a write returns. Returns how many were stored in out,
+        // transports without timestamps store none.
+        virtual size_t readTxTimestamps(std::span<TxTimestamp>) {
+            return 0;
+        }
+
+        bool writev(std::initializer_list<ConstBuffer> buffers) {
+            return writev(std::span(buffers.begin(), buffers.size()));
+        }
+
+        int readv(std::initializer_list<MutableBuffer> buffers) {
+            return readv(std::span(buffers.begin(), buffers.size()));
+        }
+
+
+        // Single read that gives up at the deadline.
+        // The default implementation can not time out and simply forwards to read().
+        virtual IoResult readUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) {
+            (void) deadline;
+            const int n = read(buffer, size);
+            if (n > 0) return {IoStatus::Ok, static_cast<size_t>(n)};
+            return {n == 0 ? IoStatus::Closed : IoStatus::Error, 0};
+        }
+
+        // Writes all bytes, or gives up at the deadline reporting how many were sent.
+        // The default implementation can not time out and simply forwards to write().
+        virtual IoResult writeUntil(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point deadline) {
+            (void) deadline;
+            if (write(data, size)) return {IoStatus::Ok, size};
+            return {IoStatus::Error, 0};
+        }
+
+        IoResult readFor(uint8_t* buffer, size_t size, std::chrono::milliseconds timeout) {
+            return readUntil(buffer, size, std::chrono::steady_clock::now() + timeout);
+        }
+
+        IoResult writeFor(const uint8_t* data, size_t size, std::chrono::milliseconds timeout) {
+            return writeUntil(data, size, std::chrono::steady_clock::now() + timeout);
+        }
+
+        // Fills the whole buffer unless the deadline passes first.
+        IoResult readExactUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) {
+
+            size_t total = 0;
+            while (total < size) {
+                const auto result = readUntil(buffer + total, size - total, deadline);
+                total += result.bytes;
+                if (!result) return {result.status, total};
+            }
+            return {IoStatus::Ok, total};
+        }
+
+        IoResult readExactFor(uint8_t* buffer, size_t size, std::chrono::milliseconds timeout) {
+            return readExactUntil(buffer, size, std::chrono::steady_clock::now() + timeout);
+        }
 
         bool readExact(uint8_t* buffer, size_t size) {
 
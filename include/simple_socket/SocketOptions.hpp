@@ -0,0 +1,50 @@
+
+#ifndef SIMPLE_SOCKET_SOCKET_OPTIONS_HPP
+#define SIMPLE_SOCKET_SOCKET_OPTIONS_HPP
+
+#include <optional>
+
+namespace simple_socket {
+
+    // Socket level tuning, applied when a socket is created (or accepted). Unset fields keep the OS default,
+    // options a platform or protocol does not support are skipped (e.g. the TCP options on a UDP socket).
+    struct SocketOptions {
+        // TCP_NODELAY: send small writes immediately instead of coalescing them (Nagle's algorithm).
+        // Recommended for request/response protocols.
+        std::optional<bool> noDelay;
+        // SO_SNDBUF / SO_RCVBUF in bytes, the kernel may round (Linux doubles the value).
+        std::optional<int> sendBufferSize;
+        std::optional<int> receiveBufferSize;
+        // TCP_NOTSENT_LOWAT: limit on unsent bytes queued in the kernel before the socket stops being writable
+        // (Linux, macOS). Keeps send queues short for latency sensitive senders.
+        std::optional<int> notSentLowWatermark;
+        // SO_KEEPALIVE: detect dead peers on idle connections.
+        std::optional<bool> keepAlive;
+        // TCP_QUICKACK: acknowledge immediately instead of delaying ACKs (Linux). The kernel may fall back to
+        // delayed ACKs later on, this only sets the initial mode.
+        std::optional<bool> quickAck;
+        // TCP_DEFER_ACCEPT in seconds, listening sockets only (Linux): a connection is only handed to accept()
+        // once the client sent data (or the timeout passed), for protocols where the client speaks first.
+        std::optional<int> deferAccept;
+        // UDP_GRO (Linux, UDP only): let the kernel hand consecutive datagrams from the same sender over as one
+        // buffer. UDPSocket::recvBatch reports the length of the datagrams it consists of (segmentSize), receive
+        // buffers should hold MAX_UDP_PACKET_SIZE bytes.
+        std::optional<bool> udpGro;
+        // SO_REUSEADDR (UDP only): let several sockets bind the same port, e.g. receivers of one multicast group.
+        // Sets SO_REUSEPORT as well where sharing a port requires it (macOS, BSD).
+        std::optional<bool> reuseAddress;
+        // Multicast sending (UDP only). IP_MULTICAST_TTL / IPV6_MULTICAST_HOPS: how many routers a datagram may
+        // cross, the OS default of 1 keeps it on the local network.
+        std::optional<int> multicastTtl;
+        // IP_MULTICAST_LOOP / IPV6_MULTICAST_LOOP: deliver own datagrams to receivers on this host (OS default on).
+        std::optional<bool> multicastLoop;
+        // IP_MULTICAST_IF / IPV6_MULTICAST_IF: index of the interface to send on (if_nametoindex), routed otherwise.
+        std::optional<unsigned int> multicastInterface;
+        // SO_TIMESTAMPING (Linux): software timestamps taken by the kernel. Received datagrams carry their arrival
+        // time (UDPSocket::recvBatch), sends report when they left (readTxTimestamps on UDPSocket and connections).
+        std::optional<bool> timestamps;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_SOCKET_OPTIONS_HPP
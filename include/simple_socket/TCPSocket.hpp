@@ -2,23 +2,68 @@
 #ifndef SIMPLE_SOCKET_TCPSOCKET_HPP
 #define SIMPLE_SOCKET_TCPSOCKET_HPP
 
+#include "simple_socket/EventLoop.hpp"
+#include "simple_socket/Reactor.hpp"
 #include "simple_socket/SocketContext.hpp"
+#include "simple_socket/SocketOptions.hpp"
 
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace simple_socket {
 
+    struct PoolOptions {
+        // Idle connections kept per host:port:tls, more are closed when returned.
+        size_t maxIdlePerHost{4};
+        // Idle plus checked out connections per host:port:tls, 0 for no limit.
+        // At the limit acquire() waits for a connection to be returned (bounded by the connect timeout).
+        size_t maxPerHost{0};
+        // Idle connections older than this are closed instead of reused.
+        std::chrono::milliseconds idleTimeout{30000};
+    };
+
     class TCPClientContext: public SocketContext {
     public:
+        // The options are applied to every connection made through this context.
+        explicit TCPClientContext(const SocketOptions& options = {});
+
+        // Upper bound for establishing a connection, across all resolved addresses. Zero (the default) means no limit
+        // besides the kernel's own SYN timeout per attempt.
+        void setConnectTimeout(std::chrono::milliseconds timeout);
+
+        // Resolves all IPv4 and IPv6 addresses of ip (a hostname or an address literal) and races connection attempts
+        // to them Happy Eyeballs style. Returns nullptr if none could be reached in time.
         [[nodiscard]] std::unique_ptr<SimpleConnection> connect(const std::string& ip, uint16_t port, bool useTLS = false);
 
         [[nodiscard]] std::unique_ptr<SimpleConnection> connect(const std::string& host) override;
+
+        // Pooled variant of connect(): reuses an idle connection to the same host, port and TLS setting when one
+        // passes a health check (not closed by the peer, no unsolicited data), and connects otherwise.
+        // Destroying the returned connection hands it back to the pool, unless it was closed or an I/O operation
+        // on it failed. Close it explicitly when the protocol state does not allow reuse.
+        [[nodiscard]] std::unique_ptr<SimpleConnection> acquire(const std::string& ip, uint16_t port, bool useTLS = false);
+
+        void setPoolOptions(const PoolOptions& options);
+
+        ~TCPClientContext() override;
+
+    private:
+        struct Pool;
+
+        SocketOptions options_;
+        std::chrono::milliseconds connectTimeout_{0};
+        std::shared_ptr<Pool> pool_;
     };
 
     class TCPServer {
     public:
-        explicit TCPServer(uint16_t port, int backlog = 1);
+        // With reusePort several servers may listen on the same port (SO_REUSEPORT, Linux only),
+        // the kernel then load-balances incoming connections between them.
+        // The options are applied to every accepted connection.
+        explicit TCPServer(uint16_t port, int backlog = 1, bool reusePort = false, const SocketOptions& options = {});
 
         TCPServer(const TCPServer&) = delete;
         TCPServer& operator=(const TCPServer&) = delete;
@@ -27,6 +72,20 @@ namespace simple_socket {
 
         std::unique_ptr<SimpleConnection> accept();
 
+        // Waits for at least one connection, then also takes those already pending (up to max) without blocking again,
+        // so a burst of connections costs one wakeup instead of one per connection.
+        std::vector<std::unique_ptr<SimpleConnection>> acceptBatch(size_t max = 64);
+
+        // Let the reactor accept connections instead of a blocking accept() loop.
+        // Each accepted connection is added to the reactor with the callbacks returned by onAccept.
+        // The server must outlive the reactor (or the reactor must be stopped first).
+        void attach(Reactor& reactor, AcceptHandler onAccept);
+
+        // Accept from a coroutine running on loop: co_await server.asyncAccept(loop).
+        // Throws like accept() on failure.
+        Task<std::unique_ptr<AsyncConnection>> asyncAccept(EventLoop& loop);
+
+        // Threads waiting in accept() or acceptBatch() throw, close() returns once they did.
         void close();
 
         ~TCPServer();
@@ -36,6 +95,37 @@ namespace simple_socket {
         std::unique_ptr<Impl> pimpl_;
     };
 
+    // A set of listeners on one port, each with its own accept queue and accept thread,
+    // so bursts of incoming connections are spread across cores instead of queueing behind a single accept loop.
+    // On Linux every listener is a separate SO_REUSEPORT socket. Elsewhere the threads share one listening socket.
+    class TCPServerGroup {
+    public:
+        // numListeners = 0 opens one per hardware thread. The backlog applies to each listener (capped by the OS).
+        explicit TCPServerGroup(uint16_t port, size_t numListeners = 0, int backlog = 1024, const SocketOptions& options = {});
+
+        TCPServerGroup(const TCPServerGroup&) = delete;
+        TCPServerGroup& operator=(const TCPServerGroup&) = delete;
+        TCPServerGroup(TCPServerGroup&&) = delete;
+        TCPServerGroup& operator=(TCPServerGroup&&) = delete;
+
+        // Runs one accept loop per listener, onAccept is invoked on the accepting thread until close().
+        void start(std::function<void(std::unique_ptr<SimpleConnection>)> onAccept);
+
+        // Alternatively let a reactor accept on all listeners.
+        void attach(Reactor& reactor, const AcceptHandler& onAccept);
+
+        // Number of accept loops.
+        [[nodiscard]] size_t size() const;
+
+        void close();
+
+        ~TCPServerGroup();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+    };
+
 }// namespace simple_socket
 
 #endif// SIMPLE_SOCKET_TCPSOCKET_HPP
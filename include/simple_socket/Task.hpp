@@ -0,0 +1,139 @@
+
+#ifndef SIMPLE_SOCKET_TASK_HPP
+#define SIMPLE_SOCKET_TASK_HPP
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace simple_socket {
+
+    template<class T = void>
+    class Task;
+
+    namespace detail {
+
+        // resumes whoever awaited the finished coroutine (symmetric transfer, no stack growth)
+        struct FinalAwaiter {
+            bool await_ready() noexcept {
+                return false;
+            }
+            template<class P>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+                const auto continuation = h.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+
+        struct PromiseBase {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr exception;
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            FinalAwaiter final_suspend() noexcept {
+                return {};
+            }
+
+            void unhandled_exception() noexcept {
+                exception = std::current_exception();
+            }
+        };
+
+        template<class T>
+        struct Promise: PromiseBase {
+            std::optional<T> value;
+
+            Task<T> get_return_object() noexcept;
+
+            template<class U>
+            void return_value(U&& v) {
+                value.emplace(std::forward<U>(v));
+            }
+
+            T result() {
+                if (exception) std::rethrow_exception(exception);
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct Promise<void>: PromiseBase {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void result() {
+                if (exception) std::rethrow_exception(exception);
+            }
+        };
+
+    }// namespace detail
+
+    // Lazily started coroutine producing a T. It runs when awaited (co_await task) and resumes the awaiting
+    // coroutine when it finishes, rethrowing any exception there. Top level tasks are started by EventLoop::spawn.
+    template<class T>
+    class Task {
+    public:
+        using promise_type = detail::Promise<T>;
+
+        Task() = default;
+
+        explicit Task(std::coroutine_handle<promise_type> handle)
+            : handle_(handle) {}
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        Task(Task&& other) noexcept
+            : handle_(std::exchange(other.handle_, {})) {}
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (handle_) handle_.destroy();
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+
+        bool await_ready() const noexcept {
+            return !handle_ || handle_.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle_.promise().continuation = awaiting;
+            return handle_;
+        }
+
+        T await_resume() {
+            return handle_.promise().result();
+        }
+
+        ~Task() {
+            if (handle_) handle_.destroy();
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    namespace detail {
+
+        template<class T>
+        Task<T> Promise<T>::get_return_object() noexcept {
+            return Task<T>{std::coroutine_handle<Promise>::from_promise(*this)};
+        }
+
+        inline Task<void> Promise<void>::get_return_object() noexcept {
+            return Task<void>{std::coroutine_handle<Promise>::from_promise(*this)};
+        }
+
+    }// namespace detail
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_TASK_HPP
@@ -0,0 +1,52 @@
+
+#ifndef SIMPLE_SOCKET_TIMER_WHEEL_HPP
+#define SIMPLE_SOCKET_TIMER_WHEEL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace simple_socket {
+
+    // Hierarchical timer wheel (4 levels of 256 slots) for large numbers of coarse deadlines such as idle timeouts
+    // and keepalives. Scheduling, cancelling and rescheduling are O(1), callbacks run on the wheel's own thread.
+    // Deadlines are rounded up to whole ticks.
+    class TimerWheel {
+    public:
+        // Identifies a scheduled timer, 0 is never used.
+        using TimerId = uint64_t;
+
+        explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(10));
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        // Runs callback once after delay. Callbacks should be short, they hold up all other timers.
+        TimerId schedule(std::chrono::milliseconds delay, std::function<void()> callback);
+
+        // Returns false if the timer already fired or was cancelled. If its callback is running right now on the
+        // wheel's thread, waits for it to finish first, so whatever it references may be released afterwards.
+        bool cancel(TimerId id);
+
+        // Moves a pending timer to now + delay, keeping its callback (e.g. an idle timeout on activity).
+        // Returns false if the timer already fired or was cancelled.
+        bool reschedule(TimerId id, std::chrono::milliseconds delay);
+
+        [[nodiscard]] size_t pending() const;
+
+        // Process wide wheel used by the protocol implementations. Never destroyed.
+        static TimerWheel& shared();
+
+        // Pending timers are dropped without running.
+        ~TimerWheel();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_TIMER_WHEEL_HPP
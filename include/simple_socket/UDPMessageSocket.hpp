@@ -0,0 +1,69 @@
+
+#ifndef SIMPLE_SOCKET_UDP_MESSAGE_SOCKET_HPP
+#define SIMPLE_SOCKET_UDP_MESSAGE_SOCKET_HPP
+
+#include "simple_socket/Endpoint.hpp"
+#include "simple_socket/UDPSocket.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <vector>
+
+namespace simple_socket {
+
+    struct UDPMessageOptions {
+        // Size of each datagram, header included. Keep it below the path MTU (1400 fits Ethernet with room for
+        // tunnels), so that IP never fragments and a lost packet costs one fragment rather than the datagram.
+        size_t maxDatagramSize{1400};
+        // Larger messages are not sent, and not reassembled when received.
+        size_t maxMessageSize{16 * 1024 * 1024};
+        // Memory for incomplete messages. When a new message does not fit, the oldest incomplete ones are dropped.
+        size_t maxPendingBytes{64 * 1024 * 1024};
+        // Incomplete messages that received no new fragment for this long are dropped, their missing fragments are
+        // assumed lost. A message taking longer to send (e.g. a large paced one) is kept as long as fragments arrive.
+        std::chrono::milliseconds reassemblyTimeout{2000};
+        // Send rate limit of each send() in bytes per second, 0 for none. A large message sent in one burst can
+        // overflow the receiver's socket buffer (see SocketOptions::receiveBufferSize) and so be lost.
+        size_t maxBytesPerSecond{0};
+    };
+
+    // Message framing over a UDPSocket: messages of any size up to maxMessageSize are split into datagrams of
+    // maxDatagramSize with a small sequence header and put back together by the receiver. Delivery is what UDP
+    // offers: a message arrives whole or not at all (a single lost fragment loses it), and possibly out of order.
+    // Both ends need the same layer. The socket must outlive it.
+    class UDPMessageSocket {
+    public:
+        explicit UDPMessageSocket(UDPSocket& socket, UDPMessageOptions options = {});
+
+        UDPMessageSocket(const UDPMessageSocket&) = delete;
+        UDPMessageSocket& operator=(const UDPMessageSocket&) = delete;
+
+        // Returns false if the message is empty or too large, or sending a fragment failed. Thread safe.
+        bool send(const Endpoint& to, const uint8_t* data, size_t size);
+
+        template<class Container>
+            requires std::ranges::contiguous_range<Container> && (sizeof(std::ranges::range_value_t<Container>) == 1)
+        bool send(const Endpoint& to, const Container& data) {
+            return send(to, reinterpret_cast<const uint8_t*>(std::ranges::data(data)), std::ranges::size(data));
+        }
+
+        // Waits for the next complete message. Datagrams that are not fragments of this layer are skipped.
+        // Returns false if receiving fails, e.g. once the socket is closed. Call from one thread at a time.
+        bool receive(std::vector<uint8_t>& message, Endpoint& from);
+
+        // Incomplete messages given up on so far (timed out, or evicted for room).
+        [[nodiscard]] size_t dropped() const;
+
+        ~UDPMessageSocket();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> pimpl_;
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_UDP_MESSAGE_SOCKET_HPP
@@ -2,11 +2,16 @@
 #ifndef SIMPLE_SOCKET_UDPSOCKET_HPP
 #define SIMPLE_SOCKET_UDPSOCKET_HPP
 
+#include <chrono>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "simple_socket/Endpoint.hpp"
 #include "simple_socket/SimpleConnection.hpp"
+#include "simple_socket/SocketContext.hpp"
+#include "simple_socket/SocketOptions.hpp"
 
 #ifndef MAX_UDP_PACKET_SIZE
 #define MAX_UDP_PACKET_SIZE 65507
@@ -14,24 +19,94 @@
 
 namespace simple_socket {
 
+    // A datagram for UDPSocket::sendBatch. The data is not copied.
+    struct OutgoingDatagram {
+        const uint8_t* data{nullptr};
+        size_t size{0};
+        Endpoint to;
+    };
+
+    // A receive buffer for UDPSocket::recvBatch, which fills in size, from and truncated.
+    struct IncomingDatagram {
+        uint8_t* data{nullptr};
+        size_t capacity{0};
+        size_t size{0};
+        Endpoint from;
+        bool truncated{false};// the datagram did not fit, the rest of it is lost
+        // Length of the datagrams the data consists of, the last one may be shorter. Equals size unless
+        // SocketOptions::udpGro coalesced several datagrams into this buffer.
+        size_t segmentSize{0};
+        // When the kernel received the datagram, with SocketOptions::timestamps (Linux) only.
+        std::chrono::system_clock::time_point timestamp;
+
+        IncomingDatagram() = default;
+        IncomingDatagram(uint8_t* data, size_t capacity)
+            : data(data), capacity(capacity) {}
+    };
+
     class UDPSocket {
     public:
-        explicit UDPSocket(int localPort);
+        // The TCP level options (noDelay, keepAlive, ...) do not apply to UDP.
+        explicit UDPSocket(int localPort, const SocketOptions& options = {});
+
+        // IPv4 endpoints are reached over the dual stack socket as well where IPv6 is available.
+        bool sendTo(const Endpoint& to, const uint8_t* data, size_t size);
+
+        bool sendTo(const Endpoint& to, const std::vector<uint8_t>& data);
 
+        bool sendTo(const Endpoint& to, const std::string& data);
+
+        // Parses the address on every call, prefer the Endpoint overloads for repeated sends.
         bool sendTo(const std::string& address, uint16_t remotePort, const std::string& data);
 
         bool sendTo(const std::string& address, uint16_t remotePort, const std::vector<uint8_t>& data);
 
         bool sendTo(const std::string& address, uint16_t remotePort, const uint8_t* data, size_t size);
 
+        // Receives the next datagram from any sender and reports who sent it. Returns its length or -1 on error.
+        int recvFromAny(uint8_t* buffer, size_t size, Endpoint& from);
+
+        int recvFromAny(std::vector<uint8_t>& buffer, Endpoint& from);
+
+        // The address and port do not filter anything, datagrams from any sender are returned (see recvFromAny).
         int recvFrom(const std::string& address, uint16_t remotePort, std::vector<uint8_t>& buffer);
 
         int recvFrom(const std::string& address, uint16_t remotePort, uint8_t* buffer, size_t size);
 
         [[nodiscard]] std::string recvFrom(const std::string& address, uint16_t remotePort);
 
+        // Sends the datagrams in order with as few system calls as possible (sendmmsg on Linux).
+        // Returns how many were sent; fewer than datagrams.size() when one fails (e.g. too large).
+        size_t sendBatch(std::span<const OutgoingDatagram> datagrams);
+
+        // Sends data as consecutive datagrams of segmentSize bytes (the last may be shorter). On Linux the kernel
+        // splits the buffer (UDP_SEGMENT), so up to 64 datagrams take one system call, elsewhere this is a sendBatch.
+        // Segments the kernel refuses to split (e.g. larger than the route's MTU) are sent one by one instead.
+        // Returns false if segmentSize is 0 or too large, or sending failed.
+        bool sendSegmented(const Endpoint& to, const uint8_t* data, size_t size, size_t segmentSize);
+
+        // Waits for a datagram, then also takes whatever else is queued, up to datagrams.size(), in the same
+        // system call (recvmmsg on Linux). Returns the number received, filled from the front, or -1 on error.
+        int recvBatch(std::span<IncomingDatagram> datagrams);
+
+        // Takes the transmit timestamps of sends reported so far, oldest first, without waiting
+        // (SocketOptions::timestamps, Linux). Every datagram counts as one send, a sendSegmented() system call as one.
+        // Returns how many were stored in out.
+        size_t readTxTimestamps(std::span<TxTimestamp> out);
+
+        // Receives the datagrams sent to an IPv4 or IPv6 multicast group (e.g. "239.1.2.3" or "ff15::1") on the
+        // interface with the given index (if_nametoindex), 0 lets the OS choose. Every receiver of a group binds the
+        // group's port, more than one socket per host needs SocketOptions::reuseAddress.
+        // Throws std::invalid_argument if group is not an IP literal, std::system_error if joining fails.
+        void joinGroup(const std::string& group, unsigned int interfaceIndex = 0);
+
+        void leaveGroup(const std::string& group, unsigned int interfaceIndex = 0);
+
+        // Throws std::invalid_argument if address is not an IP literal.
         std::unique_ptr<SimpleConnection> makeConnection(const std::string& address, uint16_t remotePort);
 
+        std::unique_ptr<SimpleConnection> makeConnection(const Endpoint& remote);
+
         void close();
 
         ~UDPSocket();
@@ -41,6 +116,24 @@ namespace simple_socket {
         std::unique_ptr<Impl> pimpl_;
     };
 
+    // Connected UDP: every connection owns a socket connect()ed to a single peer, so the kernel looks the route up
+    // once and drops datagrams from anyone else. read() and readv() receive one datagram, write() and writev() send
+    // one. A peer that is not listening may make a later read() or write() fail (ICMP port unreachable).
+    class UDPClientContext: public SocketContext {
+    public:
+        // The options are applied to every connection made through this context.
+        explicit UDPClientContext(const SocketOptions& options = {});
+
+        // Binds localPort (0 picks a free one) and connects to remote. Returns nullptr if that fails.
+        [[nodiscard]] std::unique_ptr<SimpleConnection> connect(const Endpoint& remote, uint16_t localPort = 0);
+
+        // "address:port", the address may be a host name, resolved once.
+        [[nodiscard]] std::unique_ptr<SimpleConnection> connect(const std::string& host) override;
+
+    private:
+        SocketOptions options_;
+    };
+
 }// namespace simple_socket
 
 #endif//SIMPLE_SOCKET_UDPSOCKET_HPP
@@ -2,6 +2,7 @@
 #ifndef SIMPLE_SOCKET_UNIXDOMAINSOCKET_HPP
 #define SIMPLE_SOCKET_UNIXDOMAINSOCKET_HPP
 
+#include "simple_socket/Reactor.hpp"
 #include "simple_socket/SocketContext.hpp"
 
 #include <memory>
@@ -20,6 +21,10 @@ namespace simple_socket {
 
         [[nodiscard]] std::unique_ptr<SimpleConnection> accept();
 
+        // Let the reactor accept connections instead of a blocking accept() loop.
+        // The server must outlive the reactor (or the reactor must be stopped first).
+        void attach(Reactor& reactor, AcceptHandler onAccept);
+
         void close();
 
         ~UnixDomainServer();
@@ -4,6 +4,8 @@
 
 #include "HoldingRegister.hpp"
 
+#include "simple_socket/Metrics.hpp"
+
 
 #include <memory>
 
@@ -23,6 +25,9 @@ namespace simple_socket {
 
         void stop();
 
+        // Traffic of all clients so far, one message per request and response.
+        [[nodiscard]] MetricsSnapshot metrics() const;
+
         ~ModbusServer();
 
     private:
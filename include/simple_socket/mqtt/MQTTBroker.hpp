@@ -2,6 +2,8 @@
 #ifndef SIMPLE_SOCKET_MQTTSERVER_HPP
 #define SIMPLE_SOCKET_MQTTSERVER_HPP
 
+#include "simple_socket/Metrics.hpp"
+
 #include <memory>
 
 namespace simple_socket {
@@ -17,6 +19,9 @@ namespace simple_socket {
 
         void stop();
 
+        // Traffic of all TCP clients so far (WebSocket clients count packets only).
+        [[nodiscard]] MetricsSnapshot metrics() const;
+
         ~MQTTBroker();
 
     private:
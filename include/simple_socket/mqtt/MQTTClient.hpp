@@ -2,6 +2,7 @@
 #ifndef SIMPLE_SOCKET_MQTTCLIENT_HPP
 #define SIMPLE_SOCKET_MQTTCLIENT_HPP
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
@@ -10,7 +11,9 @@ namespace simple_socket {
 
     class MQTTClient {
     public:
-        MQTTClient(const std::string& host, int port, const std::string& clientId);
+        // keepAlive is announced to the broker. Once run() is called the client pings when the connection was quiet
+        // for half of it, and closes the connection when a ping goes unanswered for another half.
+        MQTTClient(const std::string& host, int port, const std::string& clientId, std::chrono::seconds keepAlive = std::chrono::seconds(60));
 
         void connect(bool tls = false);
 
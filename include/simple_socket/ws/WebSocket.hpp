@@ -2,6 +2,9 @@
 #ifndef SIMPLE_SOCKET_WEBSOCKET_HPP
 #define SIMPLE_SOCKET_WEBSOCKET_HPP
 
+#include "simple_socket/Metrics.hpp"
+
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <string>
@@ -34,10 +37,17 @@ namespace simple_socket {
 
         explicit WebSocket(uint16_t port);
 
+        // How often connections ping their peer, and how long they wait for any traffic (pongs included) before
+        // closing. 30 and 75 seconds by default. Call before start().
+        void setKeepAlive(std::chrono::milliseconds pingInterval, std::chrono::milliseconds idleTimeout);
+
         void start();
 
         void stop();
 
+        // Traffic of all connections accepted so far.
+        [[nodiscard]] MetricsSnapshot metrics() const;
+
         ~WebSocket();
 
     private:
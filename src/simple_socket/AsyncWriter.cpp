@@ -0,0 +1,422 @@
+#include "simple_socket/AsyncWriter.hpp"
+
+#include "simple_socket/BufferPool.hpp"
+#include "simple_socket/BufferedConnection.hpp"
+#include "simple_socket/Poller.hpp"
+#include "simple_socket/SocketConnection.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace simple_socket;
+
+namespace {
+
+    // The socket under any read buffering, INVALID_SOCKET if the connection is not socket based (e.g. TLS).
+    SOCKET socketOf(SimpleConnection& conn) {
+
+        SimpleConnection* next = &conn;
+        while (const auto buffered = dynamic_cast<BufferedConnection*>(next)) next = &buffered->next();
+        const auto socket = dynamic_cast<SocketConnection*>(next);
+        return socket ? static_cast<SOCKET>(*socket) : INVALID_SOCKET;
+    }
+
+    // A few threads shared by all writers drain their queues. A writer whose socket has no room left waits in the
+    // poller for it to become writable instead of holding on to a thread. Connections without a socket to poll are
+    // retried every retryInterval instead.
+    class WriterPool {
+    public:
+        enum class Progress {
+            Idle,   // nothing left to write, or closed
+            Stalled,// the connection can not take more right now
+            Yield   // more to write, but other writers get their turn first
+        };
+
+        struct Queue {
+            // Marks the queue as being drained, unless it is closed or already being drained.
+            virtual bool claim() = 0;
+            virtual Progress drain() = 0;
+
+            virtual ~Queue() = default;
+        };
+
+        // Leaked on purpose, like the shared timer wheel: writers may still close during static destruction.
+        static WriterPool& shared() {
+            static auto pool = new WriterPool();
+            return *pool;
+        }
+
+        uint64_t add(Queue& queue, SOCKET fd) {
+
+            std::lock_guard lock(mutex_);
+            const uint64_t key = nextKey_++;
+            if (fd != INVALID_SOCKET && !poller_.add(fd, key, 0)) fd = INVALID_SOCKET;
+            queues_[key] = {&queue, fd};
+            return key;
+        }
+
+        // Once this returns no thread starts draining the queue any more.
+        void remove(uint64_t key) {
+
+            std::lock_guard lock(mutex_);
+            const auto it = queues_.find(key);
+            if (it == queues_.end()) return;
+            if (it->second.fd != INVALID_SOCKET) poller_.remove(it->second.fd, key);
+            queues_.erase(it);
+        }
+
+        // Has the queue drained as soon as its connection can take data.
+        void schedule(uint64_t key, bool stalled) {
+
+            std::lock_guard lock(mutex_);
+            const auto it = queues_.find(key);
+            if (it == queues_.end()) return;// removed in the meantime
+            if (it->second.fd != INVALID_SOCKET) {
+                poller_.rearm(it->second.fd, key, Poller::Writable);
+                return;
+            }
+            (stalled ? retry_ : ready_).push_back(key);
+            poller_.wakeup();
+        }
+
+    private:
+        struct Entry {
+            Queue* queue;
+            SOCKET fd;
+        };
+
+        static constexpr size_t numThreads = 2;
+        static constexpr std::chrono::milliseconds retryInterval{10};
+
+        Poller poller_;
+        std::mutex mutex_;
+        uint64_t nextKey_{1};
+        std::unordered_map<uint64_t, Entry> queues_;
+        std::vector<uint64_t> ready_;// without a socket, drained on the next turn
+        std::vector<uint64_t> retry_;// without a socket and stalled, drained after retryInterval
+
+        WriterPool() {
+            for (size_t i = 0; i < numThreads; ++i) std::thread([this] { run(); }).detach();
+        }
+
+        void run() {
+
+            std::vector<Poller::Event> events;
+            std::vector<uint64_t> due;
+            for (;;) {
+                bool retrying;
+                {
+                    std::lock_guard lock(mutex_);
+                    retrying = !retry_.empty();
+                }
+                poller_.wait(events, retrying ? static_cast<int>(retryInterval.count()) : -1);
+                for (const auto& ev : events) drain(ev.key);
+                {
+                    std::lock_guard lock(mutex_);
+                    due.swap(ready_);
+                    if (retrying) {
+                        due.insert(due.end(), retry_.begin(), retry_.end());
+                        retry_.clear();
+                    }
+                }
+                for (const auto key : due) drain(key);
+                due.clear();
+            }
+        }
+
+        void drain(uint64_t key) {
+
+            Queue* queue;
+            {
+                // claimed with the lock held, so that remove() can not return in between
+                std::lock_guard lock(mutex_);
+                const auto it = queues_.find(key);
+                if (it == queues_.end() || !it->second.queue->claim()) return;
+                queue = it->second.queue;
+            }
+            // the queue may be gone once drain() returned
+            const auto progress = queue->drain();
+            if (progress != Progress::Idle) schedule(key, progress == Progress::Stalled);
+        }
+    };
+
+}// namespace
+
+struct AsyncWriter::Impl: WriterPool::Queue {
+
+    Impl(SimpleConnection& conn, WriteQueueOptions options)
+        : conn_(conn), options_(std::move(options)), ring_(16) {
+
+        key_ = WriterPool::shared().add(*this, socketOf(conn));
+    }
+
+    bool enqueue(BufferPool::Buffer message) {
+
+        const size_t size = message.size();
+        const auto fits = [&] {
+            return queued_ == 0 || queued_ + size <= options_.highWatermark;
+        };
+
+        std::unique_lock lock(mutex_);
+        if (closed_) return false;
+
+        if (!fits()) {
+            setCongested(true);
+            switch (options_.overflow) {
+                case OverflowPolicy::Block:
+                    cv_.wait(lock, [&] { return closed_ || fits(); });
+                    if (closed_) return false;
+                    break;
+                case OverflowPolicy::DropOldest:
+                    // the message being written is counted but can not be dropped, so this may still not fit
+                    while (!fits() && count_ > 0) {
+                        queued_ -= pop().size();
+                        ++dropped_;
+                    }
+                    break;
+                case OverflowPolicy::Disconnect:
+                    shutdown();
+                    lock.unlock();
+                    cv_.notify_all();
+                    conn_.close();
+                    return false;
+            }
+        }
+
+        push(std::move(message));
+        queued_ += size;
+        if (queued_ >= options_.highWatermark) setCongested(true);
+        const bool schedule = !scheduled_;
+        scheduled_ = true;
+        lock.unlock();
+        cv_.notify_all();
+        // without the lock, the pool locks the writer while holding its own
+        if (schedule) WriterPool::shared().schedule(key_, false);
+        return true;
+    }
+
+    bool flush() {
+
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, [&] { return closed_ || queued_ == 0; });
+        return !closed_;
+    }
+
+    void close() {
+
+        {
+            std::lock_guard lock(mutex_);
+            shutdown();
+        }
+        cv_.notify_all();
+        WriterPool::shared().remove(key_);
+        // a write in progress does not block, it is finished shortly
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, [&] { return !draining_; });
+    }
+
+    [[nodiscard]] size_t queuedBytes() const {
+        std::lock_guard lock(mutex_);
+        return queued_;
+    }
+
+    [[nodiscard]] size_t dropped() const {
+        std::lock_guard lock(mutex_);
+        return dropped_;
+    }
+
+    [[nodiscard]] bool closed() const {
+        return closed_;
+    }
+
+    bool claim() override {
+
+        std::lock_guard lock(mutex_);
+        if (closed_ || draining_) return false;
+        draining_ = true;
+        return true;
+    }
+
+    // Writes without blocking until the queue is empty, the connection is full or the turn is over.
+    WriterPool::Progress drain() override {
+
+        auto progress = WriterPool::Progress::Yield;
+        std::unique_lock lock(mutex_);
+        for (size_t i = 0; i < messagesPerTurn; ++i) {
+            if (closed_) {
+                progress = WriterPool::Progress::Idle;
+                break;
+            }
+            if (!current_.data()) {
+                if (count_ == 0) {
+                    scheduled_ = false;
+                    progress = WriterPool::Progress::Idle;
+                    break;
+                }
+                current_ = pop();
+                offset_ = 0;
+            }
+
+            lock.unlock();
+            const auto result = conn_.writeUntil(current_.data() + offset_, current_.size() - offset_,
+                                                 std::chrono::steady_clock::now());
+            lock.lock();
+
+            offset_ += result.bytes;
+            if (result.status == IoStatus::Timeout) {
+                progress = WriterPool::Progress::Stalled;
+                break;
+            }
+            queued_ -= current_.size();
+            current_.release();
+            if (!result) {
+                shutdown();
+                progress = WriterPool::Progress::Idle;
+                break;
+            }
+            if (queued_ <= options_.lowWatermark) setCongested(false);
+            cv_.notify_all();
+        }
+        if (closed_ && current_.data()) {
+            queued_ -= current_.size();
+            current_.release();
+        }
+        draining_ = false;
+        lock.unlock();
+        cv_.notify_all();
+        return progress;
+    }
+
+    ~Impl() override {
+        close();
+    }
+
+private:
+    // messages written in one go before other writers get their turn
+    static constexpr size_t messagesPerTurn = 16;
+
+    SimpleConnection& conn_;
+    const WriteQueueOptions options_;
+    uint64_t key_{0};// with the writer pool
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;// new message, room, drained, closed or done draining
+
+    // FIFO of queued messages, a ring instead of a deque so that a steady stream does not allocate
+    std::vector<BufferPool::Buffer> ring_;
+    size_t head_{0};
+    size_t count_{0};
+
+    // the message being written, taken off the ring, and how much of it is out
+    BufferPool::Buffer current_;
+    size_t offset_{0};
+
+    size_t queued_{0};
+    size_t dropped_{0};
+    bool congested_{false};
+    bool scheduled_{false};// handed to the pool, which drains it until empty
+    bool draining_{false}; // a pool thread is writing
+    std::atomic_bool closed_{false};
+
+    void push(BufferPool::Buffer message) {
+
+        if (count_ == ring_.size()) {
+            std::vector<BufferPool::Buffer> larger(ring_.size() * 2);
+            for (size_t i = 0; i < count_; ++i) larger[i] = std::move(ring_[(head_ + i) % ring_.size()]);
+            ring_ = std::move(larger);
+            head_ = 0;
+        }
+        ring_[(head_ + count_) % ring_.size()] = std::move(message);
+        ++count_;
+    }
+
+    BufferPool::Buffer pop() {
+
+        auto message = std::move(ring_[head_]);
+        head_ = (head_ + 1) % ring_.size();
+        --count_;
+        return message;
+    }
+
+    // with the lock held
+    void setCongested(bool congested) {
+
+        if (congested_ == congested) return;
+        congested_ = congested;
+        if (options_.onBackpressure) options_.onBackpressure(congested);
+    }
+
+    // with the lock held
+    void shutdown() {
+
+        closed_ = true;
+        while (count_ > 0) queued_ -= pop().size();
+        // a message a pool thread is writing right now is released by that thread
+        if (!draining_ && current_.data()) {
+            queued_ -= current_.size();
+            current_.release();
+        }
+    }
+};
+
+AsyncWriter::AsyncWriter(SimpleConnection& conn, WriteQueueOptions options)
+    : pimpl_(std::make_unique<Impl>(conn, std::move(options))) {}
+
+bool AsyncWriter::writeAsync(const uint8_t* data, size_t size) {
+
+    if (size == 0) return !pimpl_->closed();
+
+    auto message = BufferPool::shared().acquire(size);
+    std::memcpy(message.data(), data, size);
+    return pimpl_->enqueue(std::move(message));
+}
+
+bool AsyncWriter::writeAsync(std::span<const ConstBuffer> buffers) {
+
+    size_t total = 0;
+    for (const auto& b : buffers) total += b.size;
+    if (total == 0) return !pimpl_->closed();
+
+    auto message = BufferPool::shared().acquire(total);
+    size_t offset = 0;
+    for (const auto& b : buffers) {
+        if (b.size == 0) continue;
+        std::memcpy(message.data() + offset, b.data, b.size);
+        offset += b.size;
+    }
+    return pimpl_->enqueue(std::move(message));
+}
+
+bool AsyncWriter::flush() {
+
+    return pimpl_->flush();
+}
+
+size_t AsyncWriter::queuedBytes() const {
+
+    return pimpl_->queuedBytes();
+}
+
+size_t AsyncWriter::dropped() const {
+
+    return pimpl_->dropped();
+}
+
+bool AsyncWriter::closed() const {
+
+    return pimpl_->closed();
+}
+
+void AsyncWriter::close() {
+
+    pimpl_->close();
+}
+
+AsyncWriter::~AsyncWriter() = default;
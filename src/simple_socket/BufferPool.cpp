@@ -0,0 +1,205 @@
+
+#include "simple_socket/BufferPool.hpp"
+
+#include "simple_socket/util/thread_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace simple_socket;
+
+namespace {
+
+    constexpr size_t minBlockShift = 6;// 64 bytes
+    constexpr size_t slabSize = 64 * 1024;
+    constexpr size_t numShards = 16;
+
+    // Threads are spread round robin over the shards, so a thread mostly locks a mutex nobody else holds.
+    size_t currentShard() {
+        return threadIndex() % numShards;
+    }
+
+}// namespace
+
+struct BufferPool::Impl {
+
+    explicit Impl(size_t maxBlockSize)
+        : maxBlockSize(std::bit_ceil(std::max<size_t>(maxBlockSize, size_t(1) << minBlockShift))),
+          numClasses(std::countr_zero(this->maxBlockSize) - minBlockShift + 1) {
+
+        for (auto& shard : shards) shard.free.resize(numClasses, nullptr);
+    }
+
+    const size_t maxBlockSize;
+    const size_t numClasses;
+
+    std::atomic_size_t heapAllocations{0};
+
+    [[nodiscard]] static size_t classOf(size_t capacity) {
+        return std::countr_zero(capacity) - minBlockShift;
+    }
+
+    uint8_t* take(size_t sizeClass) {
+
+        const size_t home = currentShard();
+        if (const auto block = pop(shards[home], sizeClass, false)) return block;
+
+        // blocks released on other threads (e.g. a consumer thread) pile up in their shards, take those before
+        // growing; otherwise a producer/consumer pair would keep allocating slabs forever
+        for (size_t i = 1; i < numShards; ++i) {
+            if (const auto block = pop(shards[(home + i) % numShards], sizeClass, true)) return block;
+        }
+        return grow(sizeClass, home);
+    }
+
+    void give(uint8_t* block, size_t sizeClass) {
+
+        auto& shard = shards[currentShard()];
+        std::lock_guard lock(shard.mutex);
+        push(shard, sizeClass, block);
+    }
+
+    ~Impl() {
+        for (auto slab : slabs) delete[] slab;
+    }
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::vector<uint8_t*> free;// intrusive free list heads, one per size class
+    };
+
+    std::array<Shard, numShards> shards;
+
+    std::mutex slabMutex;
+    std::vector<uint8_t*> slabs;
+
+    // the free list link lives in the first bytes of the free block
+    static void push(Shard& shard, size_t sizeClass, uint8_t* block) {
+        std::memcpy(block, &shard.free[sizeClass], sizeof(uint8_t*));
+        shard.free[sizeClass] = block;
+    }
+
+    static uint8_t* pop(Shard& shard, size_t sizeClass, bool tryOnly) {
+
+        std::unique_lock lock(shard.mutex, std::defer_lock);
+        if (tryOnly) {
+            if (!lock.try_lock()) return nullptr;
+        } else {
+            lock.lock();
+        }
+
+        uint8_t* block = shard.free[sizeClass];
+        if (block) std::memcpy(&shard.free[sizeClass], block, sizeof(uint8_t*));
+        return block;
+    }
+
+    // Carves a new slab into blocks, keeps one and files the rest under the calling thread's shard.
+    uint8_t* grow(size_t sizeClass, size_t home) {
+
+        const size_t blockSize = size_t(1) << (sizeClass + minBlockShift);
+        const size_t count = std::max<size_t>(1, slabSize / blockSize);
+
+        const auto slab = new uint8_t[blockSize * count];
+        ++heapAllocations;
+        {
+            std::lock_guard lock(slabMutex);
+            slabs.push_back(slab);
+        }
+
+        auto& shard = shards[home];
+        std::lock_guard lock(shard.mutex);
+        for (size_t i = 1; i < count; ++i) {
+            push(shard, sizeClass, slab + i * blockSize);
+        }
+        return slab;
+    }
+};
+
+BufferPool::BufferPool(size_t maxBlockSize)
+    : pimpl_(std::make_unique<Impl>(maxBlockSize)) {}
+
+BufferPool::Buffer BufferPool::acquire(size_t size) {
+
+    if (size > pimpl_->maxBlockSize) {
+        ++pimpl_->heapAllocations;
+        return {this, new uint8_t[size], size, size};
+    }
+
+    const size_t capacity = std::bit_ceil(std::max<size_t>(size, size_t(1) << minBlockShift));
+    return {this, pimpl_->take(Impl::classOf(capacity)), size, capacity};
+}
+
+size_t BufferPool::heapAllocations() const {
+
+    return pimpl_->heapAllocations;
+}
+
+BufferPool& BufferPool::shared() {
+
+    // leaked on purpose: buffers may still be released by threads outliving static destruction
+    static auto pool = new BufferPool();
+    return *pool;
+}
+
+void BufferPool::recycle(uint8_t* data, size_t capacity) {
+
+    if (capacity > pimpl_->maxBlockSize || !std::has_single_bit(capacity)) {
+        delete[] data;
+        return;
+    }
+    pimpl_->give(data, Impl::classOf(capacity));
+}
+
+BufferPool::~BufferPool() = default;
+
+
+BufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool_(std::exchange(other.pool_, nullptr)),
+      data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      capacity_(std::exchange(other.capacity_, 0)) {}
+
+BufferPool::Buffer& BufferPool::Buffer::operator=(Buffer&& other) noexcept {
+
+    if (this != &other) {
+        release();
+        pool_ = std::exchange(other.pool_, nullptr);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+    }
+    return *this;
+}
+
+void BufferPool::Buffer::resize(size_t size) {
+
+    if (size <= capacity_) {
+        size_ = size;
+        return;
+    }
+
+    auto& pool = pool_ ? *pool_ : shared();
+    auto larger = pool.acquire(size);
+    if (size_ > 0) std::memcpy(larger.data(), data_, size_);
+    *this = std::move(larger);
+}
+
+void BufferPool::Buffer::release() {
+
+    if (data_) pool_->recycle(data_, capacity_);
+    pool_ = nullptr;
+    data_ = nullptr;
+    size_ = capacity_ = 0;
+}
+
+BufferPool::Buffer::~Buffer() {
+
+    release();
+}
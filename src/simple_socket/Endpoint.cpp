@@ -0,0 +1,53 @@
+
+#include "simple_socket/Endpoint.hpp"
+
+#include "simple_socket/socket_common.hpp"
+
+#include <stdexcept>
+
+using namespace simple_socket;
+
+Endpoint::Endpoint(const std::string& address, uint16_t port) {
+
+    if (!EndpointAccess::parse(address, port, *this)) {
+
+        throw std::invalid_argument("Not an IP address: " + address);
+    }
+}
+
+Endpoint Endpoint::resolve(const std::string& host, uint16_t port) {
+
+#ifdef _WIN32
+    WSASession session;
+#endif
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || !res) {
+
+        throw std::runtime_error("Unable to resolve " + host);
+    }
+    sockaddr_storage addr{};
+    std::memcpy(&addr, res->ai_addr, std::min<size_t>(res->ai_addrlen, sizeof(addr)));
+    freeaddrinfo(res);
+
+    auto endpoint = EndpointAccess::fromSockaddr(addr);
+    endpoint.port_ = port;
+    return endpoint;
+}
+
+std::string Endpoint::address() const {
+
+    char buffer[INET6_ADDRSTRLEN];
+    if (!inet_ntop(v6_ ? AF_INET6 : AF_INET, address_.data(), buffer, sizeof(buffer))) return {};
+    return buffer;
+}
+
+std::string Endpoint::toString() const {
+
+    if (v6_) return "[" + address() + "]:" + std::to_string(port_);
+    return address() + ":" + std::to_string(port_);
+}
@@ -0,0 +1,417 @@
+
+#include "simple_socket/EventLoop.hpp"
+
+#include "simple_socket/Poller.hpp"
+#include "simple_socket/SocketConnection.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace simple_socket;
+
+struct EventLoop::Impl {
+
+    // A socket known to the poller and the coroutines suspended on it, one registration is shared by all of them.
+    struct Io {
+        Impl& loop;
+        SOCKET fd;
+        uint64_t key{};
+        bool registered{false};
+        size_t users{};// waits holding a loop owned Io alive
+        std::vector<std::coroutine_handle<>> readers;
+        std::vector<std::coroutine_handle<>> writers;
+
+        Io(Impl& loop, SOCKET fd)
+            : loop(loop), fd(fd) {}
+
+        Io(const Io&) = delete;
+        Io& operator=(const Io&) = delete;
+
+        ~Io() {
+            loop.detach(*this);
+        }
+    };
+
+    // co_await loop.wait(io, write): suspends until the socket is ready, resolves to false if it could not be watched.
+    struct IoAwaiter {
+        Io& io;
+        bool write;
+        bool ok{true};
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            auto& waiters = write ? io.writers : io.readers;
+            waiters.push_back(h);
+            if (io.loop.arm(io)) return true;
+            waiters.pop_back();
+            ok = false;
+            return false;
+        }
+
+        bool await_resume() const noexcept {
+            return ok;
+        }
+    };
+
+    // Top level coroutine wrapping a spawned task, parks itself on the finished list when done.
+    struct Root {
+        struct promise_type {
+            Impl& loop;
+
+            promise_type(Impl& loop, Task<>&)
+                : loop(loop) {}
+
+            Root get_return_object() noexcept {
+                return {std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            auto final_suspend() noexcept {
+                struct FinalAwaiter {
+                    bool await_ready() noexcept {
+                        return false;
+                    }
+                    void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                        h.promise().loop.finished_.push_back(h);
+                    }
+                    void await_resume() noexcept {}
+                };
+                return FinalAwaiter{};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept {
+                if (!loop.error_) loop.error_ = std::current_exception();
+            }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    static Root start([[maybe_unused]] Impl& loop, Task<> task) {
+        co_await task;
+    }
+
+    void spawn(Task<> task) {
+
+        const auto root = start(*this, std::move(task)).handle;
+        {
+            std::lock_guard lock(mutex_);
+            spawned_.push_back(root);
+        }
+        poller_.wakeup();
+    }
+
+    void run() {
+
+        std::vector<Poller::Event> events;
+        while (!stop_) {
+            startSpawned();
+            std::vector<std::coroutine_handle<>> ready;
+            ready.swap(ready_);
+            for (auto h : ready) h.resume();
+            reapFinished();
+            if (error_ || stop_) break;
+
+            poller_.wait(events, ready_.empty() ? -1 : 0);
+            for (const auto& ev : events) {
+                dispatch(ev);
+            }
+            reapFinished();
+            if (error_) break;
+        }
+        stop_ = false;
+
+        if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    void stop() {
+
+        stop_ = true;
+        poller_.wakeup();
+    }
+
+    IoAwaiter wait(Io& io, bool write) {
+        return {io, write};
+    }
+
+    Task<bool> wait(SimpleConnection& conn, bool write) {
+
+        const auto socket = dynamic_cast<SocketConnection*>(&conn);
+        if (!socket || *socket == INVALID_SOCKET) co_return false;
+
+        // concurrent waits on one socket (e.g. several coroutines accepting on a server) share its registration
+        Io& io = acquire(*socket);
+        const bool ok = co_await wait(io, write);
+        release(io);
+        co_return ok;
+    }
+
+    // Resume on the next iteration instead of from the caller's stack.
+    void schedule(std::coroutine_handle<> h) {
+        if (h) ready_.push_back(h);
+    }
+
+    void detach(Io& io) {
+
+        if (!io.registered) return;
+        poller_.remove(io.fd, io.key);
+        ios_.erase(io.key);
+        byFd_.erase(io.fd);
+        io.registered = false;
+    }
+
+    ~Impl() {
+
+        // destroying the frames also destroys the Io registrations they hold, which still need this instance
+        std::vector<std::coroutine_handle<>> spawned;
+        {
+            std::lock_guard lock(mutex_);
+            spawned.swap(spawned_);
+        }
+        for (auto h : spawned) h.destroy();
+        for (auto address : roots_) std::coroutine_handle<>::from_address(address).destroy();
+    }
+
+private:
+    Poller poller_;
+    std::atomic_bool stop_{false};
+    std::exception_ptr error_;
+
+    std::mutex mutex_;
+    std::vector<std::coroutine_handle<>> spawned_;// guarded by mutex_, the rest is owned by the loop thread
+
+    std::unordered_set<void*> roots_;
+    std::vector<std::coroutine_handle<>> finished_;
+    std::vector<std::coroutine_handle<>> ready_;
+
+    uint64_t nextKey_{1};
+    std::unordered_map<uint64_t, Io*> ios_;
+    std::unordered_map<SOCKET, Io*> byFd_;// registered sockets
+    std::unordered_map<SOCKET, std::unique_ptr<Io>> shared_;// Io created for waitReadable()/waitWritable()
+
+    // The Io already registered for the socket (possibly an AsyncConnection's), or a loop owned one.
+    Io& acquire(SOCKET fd) {
+
+        Io* io;
+        if (const auto it = byFd_.find(fd); it != byFd_.end()) {
+            io = it->second;
+        } else {
+            auto& owned = shared_[fd];
+            if (!owned) owned = std::make_unique<Io>(*this, fd);
+            io = owned.get();
+        }
+        ++io->users;
+        return *io;
+    }
+
+    void release(Io& io) {
+
+        if (--io.users > 0) return;
+        // no waiters left, drop the registration before the socket can be closed and its number reused
+        if (const auto it = shared_.find(io.fd); it != shared_.end() && it->second.get() == &io) shared_.erase(it);
+    }
+
+    bool arm(Io& io) {
+
+        uint32_t interest = 0;
+        if (!io.readers.empty()) interest |= Poller::Readable;
+        if (!io.writers.empty()) interest |= Poller::Writable;
+        if (io.registered) return poller_.rearm(io.fd, io.key, interest);
+
+        io.key = nextKey_++;
+        if (!poller_.add(io.fd, io.key, interest)) return false;
+        ios_[io.key] = &io;
+        byFd_[io.fd] = &io;
+        io.registered = true;
+        return true;
+    }
+
+    void dispatch(const Poller::Event& ev) {
+
+        const auto it = ios_.find(ev.key);
+        if (it == ios_.end()) return;
+        auto& io = *it->second;
+
+        // on hangup (or an event we do not classify) wake everyone, their next system call reports the state
+        const bool all = (ev.events & Poller::Hangup) || !(ev.events & (Poller::Readable | Poller::Writable));
+        std::vector<std::coroutine_handle<>> resume;
+        if (all || (ev.events & Poller::Readable)) resume.swap(io.readers);
+        if (all || (ev.events & Poller::Writable)) {
+            resume.insert(resume.end(), io.writers.begin(), io.writers.end());
+            io.writers.clear();
+        }
+        if (!io.readers.empty() || !io.writers.empty()) arm(io);
+
+        // io may be gone once a resumed coroutine finishes, waiters finding nothing to do wait again
+        for (auto h : resume) h.resume();
+    }
+
+    void startSpawned() {
+
+        std::vector<std::coroutine_handle<>> spawned;
+        {
+            std::lock_guard lock(mutex_);
+            spawned.swap(spawned_);
+        }
+        for (auto h : spawned) {
+            roots_.insert(h.address());
+            h.resume();
+        }
+    }
+
+    void reapFinished() {
+
+        for (auto h : finished_) {
+            roots_.erase(h.address());
+            h.destroy();
+        }
+        finished_.clear();
+    }
+};
+
+EventLoop::EventLoop()
+    : pimpl_(std::make_unique<Impl>()) {}
+
+void EventLoop::spawn(Task<> task) {
+
+    pimpl_->spawn(std::move(task));
+}
+
+void EventLoop::run() {
+
+    pimpl_->run();
+}
+
+void EventLoop::stop() {
+
+    pimpl_->stop();
+}
+
+Task<bool> EventLoop::waitReadable(SimpleConnection& conn) {
+
+    return pimpl_->wait(conn, false);
+}
+
+Task<bool> EventLoop::waitWritable(SimpleConnection& conn) {
+
+    return pimpl_->wait(conn, true);
+}
+
+EventLoop::~EventLoop() = default;
+
+
+struct AsyncConnection::Impl {
+
+    Impl(EventLoop::Impl& loop, std::unique_ptr<SimpleConnection> conn, SocketConnection& socket)
+        : conn(std::move(conn)), socket(socket), io(loop, socket) {}
+
+    std::unique_ptr<SimpleConnection> conn;
+    SocketConnection& socket;
+    EventLoop::Impl::Io io;
+};
+
+namespace {
+
+    SocketConnection& requireSocket(const std::unique_ptr<SimpleConnection>& conn) {
+
+        const auto socket = dynamic_cast<SocketConnection*>(conn.get());
+        if (!socket || *socket == INVALID_SOCKET) {
+            throw std::invalid_argument("AsyncConnection requires an open TCP or Unix domain connection");
+        }
+        if (!setNonBlocking(*socket)) throwSocketError("Failed to make socket non-blocking");
+        return *socket;
+    }
+
+}// namespace
+
+AsyncConnection::AsyncConnection(EventLoop& loop, std::unique_ptr<SimpleConnection> conn) {
+
+    auto& socket = requireSocket(conn);
+    pimpl_ = std::make_unique<Impl>(*loop.pimpl_, std::move(conn), socket);
+}
+
+Task<int> AsyncConnection::asyncRead(uint8_t* buffer, size_t size) {
+
+    auto& impl = *pimpl_;
+    for (;;) {
+        const SOCKET fd = impl.socket;
+        if (fd == INVALID_SOCKET || size == 0) co_return -1;
+
+#ifdef _WIN32
+        const auto n = ::recv(fd, reinterpret_cast<char*>(buffer), static_cast<int>(size), 0);
+#else
+        const auto n = ::recv(fd, buffer, size, 0);
+#endif
+        if (n > 0) co_return static_cast<int>(n);
+        if (n == 0) co_return -1;
+#ifndef _WIN32
+        if (errno == EINTR) continue;
+#endif
+        if (!socketWouldBlock() || !co_await impl.io.loop.wait(impl.io, false)) co_return -1;
+    }
+}
+
+Task<bool> AsyncConnection::asyncReadExact(uint8_t* buffer, size_t size) {
+
+    size_t total = 0;
+    while (total < size) {
+        const int n = co_await asyncRead(buffer + total, size - total);
+        if (n <= 0) co_return false;
+        total += static_cast<size_t>(n);
+    }
+    co_return true;
+}
+
+Task<bool> AsyncConnection::asyncWrite(const uint8_t* data, size_t size) {
+
+    auto& impl = *pimpl_;
+    size_t total = 0;
+    while (total < size) {
+        const SOCKET fd = impl.socket;
+        if (fd == INVALID_SOCKET) co_return false;
+
+#ifdef _WIN32
+        const auto n = ::send(fd, reinterpret_cast<const char*>(data + total), static_cast<int>(size - total), 0);
+#else
+        const auto n = ::send(fd, data + total, size - total, MSG_NOSIGNAL);
+#endif
+        if (n != SOCKET_ERROR) {
+            total += static_cast<size_t>(n);
+            continue;
+        }
+#ifndef _WIN32
+        if (errno == EINTR) continue;
+#endif
+        if (!socketWouldBlock() || !co_await impl.io.loop.wait(impl.io, true)) co_return false;
+    }
+    co_return true;
+}
+
+SimpleConnection& AsyncConnection::connection() const {
+
+    return *pimpl_->conn;
+}
+
+void AsyncConnection::close() {
+
+    auto& io = pimpl_->io;
+    io.loop.detach(io);
+    pimpl_->conn->close();
+    // pending operations observe the closed socket when resumed
+    for (auto h : std::exchange(io.readers, {})) io.loop.schedule(h);
+    for (auto h : std::exchange(io.writers, {})) io.loop.schedule(h);
+}
+
+AsyncConnection::~AsyncConnection() = default;
@@ -0,0 +1,708 @@
+
+#include "simple_socket/IoUring.hpp"
+
+#include "simple_socket/SocketConnection.hpp"
+#include "simple_socket/TCPSocket.hpp"
+
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace simple_socket;
+
+namespace {
+
+    // liburing is not required, the few system calls are issued directly.
+    int ioUringSetup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        int rc;
+        do {
+            rc = static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+        } while (rc < 0 && errno == EINTR);
+        return rc;
+    }
+
+    int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned numArgs) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, numArgs));
+    }
+
+    template<class T>
+    T loadAcquire(T* ptr) {
+        return std::atomic_ref<T>(*ptr).load(std::memory_order_acquire);
+    }
+
+    template<class T>
+    void storeRelease(T* ptr, T value) {
+        std::atomic_ref<T>(*ptr).store(value, std::memory_order_release);
+    }
+
+    // The memory mapped submission and completion queues of one io_uring instance. Not thread safe.
+    class Ring {
+    public:
+        explicit Ring(unsigned entries) {
+
+            io_uring_params params{};
+            fd_ = ioUringSetup(entries, &params);
+            if (fd_ < 0) throwSocketError("io_uring_setup failed");
+
+            sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (singleMmap) sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+            sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+
+            sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+            cqRing_ = singleMmap ? sqRing_ : mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+            if (sqRing_ == MAP_FAILED || cqRing_ == MAP_FAILED || sqes == MAP_FAILED) {
+                const int err = errno;
+                if (sqes != MAP_FAILED) munmap(sqes, sqesSize_);
+                release();
+                throw std::system_error(err, std::generic_category(), "io_uring mmap failed");
+            }
+            sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+            auto* sq = static_cast<uint8_t*>(sqRing_);
+            sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            sqEntries_ = params.sq_entries;
+            localTail_ = *sqTail_;
+
+            auto* cq = static_cast<uint8_t*>(cqRing_);
+            cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        }
+
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+
+        [[nodiscard]] int fd() const {
+            return fd_;
+        }
+
+        // Returns a zeroed SQE, or nullptr if the submission queue is full.
+        io_uring_sqe* getSqe() {
+            if (localTail_ - loadAcquire(sqHead_) >= sqEntries_) return nullptr;
+
+            const unsigned index = localTail_ & sqMask_;
+            auto* sqe = &sqes_[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqArray_[index] = index;
+            ++localTail_;
+            return sqe;
+        }
+
+        // Publishes prepared SQEs to the kernel and returns how many have not been consumed yet.
+        unsigned flush() {
+            storeRelease(sqTail_, localTail_);
+            return localTail_ - loadAcquire(sqHead_);
+        }
+
+        int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+            ++enterCalls_;
+            return ioUringEnter(fd_, toSubmit, minComplete, flags);
+        }
+
+        template<class Fn>
+        size_t reap(Fn&& onCompletion) {
+            unsigned head = *cqHead_;
+            const unsigned tail = loadAcquire(cqTail_);
+            size_t count = 0;
+            for (; head != tail; ++head, ++count) {
+                onCompletion(cqes_[head & cqMask_]);
+            }
+            storeRelease(cqHead_, head);
+            return count;
+        }
+
+        [[nodiscard]] size_t enterCalls() const {
+            return enterCalls_;
+        }
+
+        ~Ring() {
+            if (sqes_) munmap(sqes_, sqesSize_);
+            release();
+        }
+
+    private:
+        int fd_{-1};
+        void* sqRing_{MAP_FAILED};
+        void* cqRing_{MAP_FAILED};
+        size_t sqRingSize_{};
+        size_t cqRingSize_{};
+        size_t sqesSize_{};
+
+        unsigned* sqHead_{};
+        unsigned* sqTail_{};
+        unsigned* sqArray_{};
+        unsigned sqMask_{};
+        unsigned sqEntries_{};
+        unsigned localTail_{};
+        io_uring_sqe* sqes_{};
+
+        unsigned* cqHead_{};
+        unsigned* cqTail_{};
+        unsigned cqMask_{};
+        io_uring_cqe* cqes_{};
+
+        std::atomic_size_t enterCalls_{0};
+
+        void release() {
+            if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+            if (sqRing_ != MAP_FAILED) munmap(sqRing_, sqRingSize_);
+            if (fd_ >= 0) ::close(fd_);
+            sqRing_ = cqRing_ = MAP_FAILED;
+            fd_ = -1;
+        }
+    };
+
+}// namespace
+
+
+struct IoUringContext::Impl {
+
+    // Where an SQE is directed: a fixed file index, or a plain descriptor.
+    struct Target {
+        int fd{-1};
+        int fileIndex{-1};
+    };
+
+    Impl(unsigned queueDepth, unsigned maxFixedFiles, unsigned numBuffers, size_t bufferSize)
+        : ring_(queueDepth), bufferSize_(bufferSize) {
+
+        // sparse table, slots are filled in as connections are created
+        if (maxFixedFiles > 0) {
+            std::vector<int> fds(maxFixedFiles, -1);
+            if (ioUringRegister(ring_.fd(), IORING_REGISTER_FILES, fds.data(), maxFixedFiles) == 0) {
+                for (int i = static_cast<int>(maxFixedFiles) - 1; i >= 0; --i) freeFiles_.push_back(i);
+            }
+        }
+
+        if (numBuffers > 0 && bufferSize > 0) {
+            bufferMemory_ = std::make_unique<uint8_t[]>(numBuffers * bufferSize);
+            std::vector<iovec> iov(numBuffers);
+            for (unsigned i = 0; i < numBuffers; ++i) {
+                iov[i] = {bufferMemory_.get() + i * bufferSize, bufferSize};
+            }
+            if (ioUringRegister(ring_.fd(), IORING_REGISTER_BUFFERS, iov.data(), numBuffers) == 0) {
+                for (int i = static_cast<int>(numBuffers) - 1; i >= 0; --i) freeBuffers_.push_back(i);
+            } else {
+                bufferMemory_.reset();// e.g. RLIMIT_MEMLOCK, fall back to plain recv/send
+            }
+        }
+    }
+
+    std::unique_ptr<IoUringConnection> wrap(int fd);
+
+    int registerFile(int fd) {
+
+        std::lock_guard lock(mutex_);
+        if (freeFiles_.empty()) return -1;
+        const int index = freeFiles_.back();
+        if (!updateFile(index, fd)) return -1;
+        freeFiles_.pop_back();
+        return index;
+    }
+
+    void unregisterFile(int& index) {
+
+        std::lock_guard lock(mutex_);
+        if (index < 0) return;
+        updateFile(index, -1);
+        freeFiles_.push_back(index);
+        index = -1;
+    }
+
+    int acquireBuffer() {
+
+        std::lock_guard lock(mutex_);
+        if (freeBuffers_.empty()) return -1;
+        const int index = freeBuffers_.back();
+        freeBuffers_.pop_back();
+        return index;
+    }
+
+    void releaseBuffer(int index) {
+
+        if (index < 0) return;
+        std::lock_guard lock(mutex_);
+        freeBuffers_.push_back(index);
+    }
+
+    [[nodiscard]] uint8_t* buffer(int index) const {
+        return bufferMemory_.get() + static_cast<size_t>(index) * bufferSize_;
+    }
+
+    [[nodiscard]] size_t bufferSize() const {
+        return bufferSize_;
+    }
+
+    // Queue an operation, completed by a later run() or synchronous call.
+    template<class Prep>
+    void submitAsync(const Target& target, Prep&& prep, IoCompletion onComplete, const uint8_t* writeData = nullptr, size_t writeSize = 0) {
+
+        auto op = std::make_unique<Operation>();
+        op->callback = onComplete ? std::move(onComplete) : [](int) {};
+        op->target = target;
+        op->data = writeData;
+        op->size = writeSize;
+
+        std::lock_guard lock(mutex_);
+        auto* sqe = nextSqe();
+        setTarget(sqe, target);
+        prep(sqe);
+        sqe->user_data = reinterpret_cast<uint64_t>(op.release());
+    }
+
+    // Submit an operation (along with everything queued) and block until it completes. Returns the CQE result.
+    template<class Prep>
+    int submitAndWait(const Target& target, Prep&& prep) {
+
+        Operation op;
+        std::vector<std::unique_ptr<Operation>> ready;
+
+        std::unique_lock lock(mutex_);
+        auto* sqe = nextSqe();
+        setTarget(sqe, target);
+        prep(sqe);
+        sqe->user_data = reinterpret_cast<uint64_t>(&op);
+
+        while (!op.done) {
+            if (reaping_) {
+                // another thread is waiting in the kernel and will pick up our completion, just make sure our SQE is submitted
+                if (const auto pending = ring_.flush()) ring_.enter(pending, 0, 0);
+                cv_.wait(lock);
+                continue;
+            }
+            reap(lock, true, ready);
+            if (!ready.empty()) {
+                lock.unlock();
+                dispatch(ready);
+                lock.lock();
+            }
+        }
+        return op.result;
+    }
+
+    size_t run(bool wait) {
+
+        std::vector<std::unique_ptr<Operation>> ready;
+        {
+            std::unique_lock lock(mutex_);
+            if (reaping_) {
+                if (const auto pending = ring_.flush()) ring_.enter(pending, 0, 0);
+                if (wait) cv_.wait(lock);
+                return 0;
+            }
+            reap(lock, wait && inFlight_ > 0, ready);
+        }
+        dispatch(ready);
+        return ready.size();
+    }
+
+    [[nodiscard]] size_t inFlight() const {
+
+        std::lock_guard lock(mutex_);
+        return inFlight_;
+    }
+
+    [[nodiscard]] size_t enterCalls() const {
+
+        return ring_.enterCalls();
+    }
+
+    static void prepRecv(io_uring_sqe* sqe, uint8_t* buffer, size_t size) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->len = static_cast<uint32_t>(size);
+    }
+
+    static void prepSend(io_uring_sqe* sqe, const uint8_t* data, size_t size) {
+        sqe->opcode = IORING_OP_SEND;
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->len = static_cast<uint32_t>(size);
+        sqe->msg_flags = MSG_NOSIGNAL;
+    }
+
+    static void prepFixed(io_uring_sqe* sqe, uint8_t opcode, const uint8_t* data, size_t size, int bufferIndex) {
+        sqe->opcode = opcode;
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->len = static_cast<uint32_t>(size);
+        sqe->buf_index = static_cast<uint16_t>(bufferIndex);
+    }
+
+    static void prepAccept(io_uring_sqe* sqe) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+    }
+
+private:
+    struct Operation {
+        IoCompletion callback;// empty for synchronous operations
+        int result{0};
+        bool done{false};
+
+        // asyncWrite keeps sending until everything is written
+        Target target;
+        const uint8_t* data{};
+        size_t size{};
+        size_t sent{};
+    };
+
+    Ring ring_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool reaping_{false};
+    size_t inFlight_{0};
+
+    std::vector<int> freeFiles_;
+
+    size_t bufferSize_;
+    std::unique_ptr<uint8_t[]> bufferMemory_;
+    std::vector<int> freeBuffers_;
+
+    // requires mutex_
+    bool updateFile(int index, int fd) {
+        io_uring_files_update update{};
+        update.offset = static_cast<uint32_t>(index);
+        update.fds = reinterpret_cast<uint64_t>(&fd);
+        return ioUringRegister(ring_.fd(), IORING_REGISTER_FILES_UPDATE, &update, 1) == 1;
+    }
+
+    // requires mutex_
+    io_uring_sqe* nextSqe() {
+        auto* sqe = ring_.getSqe();
+        if (!sqe) {
+            // queue full, hand what we have to the kernel
+            ring_.enter(ring_.flush(), 0, 0);
+            sqe = ring_.getSqe();
+            if (!sqe) throw std::runtime_error("io_uring submission queue is full");
+        }
+        ++inFlight_;
+        return sqe;
+    }
+
+    static void setTarget(io_uring_sqe* sqe, const Target& target) {
+        if (target.fileIndex >= 0) {
+            sqe->fd = target.fileIndex;
+            sqe->flags |= IOSQE_FIXED_FILE;
+        } else {
+            sqe->fd = target.fd;
+        }
+    }
+
+    // Submits pending SQEs, optionally blocks for a completion, then collects completions.
+    // Requires mutex_ (held by lock), which is released while blocked in the kernel.
+    void reap(std::unique_lock<std::mutex>& lock, bool wait, std::vector<std::unique_ptr<Operation>>& ready) {
+
+        const unsigned pending = ring_.flush();
+        if (wait) {
+            reaping_ = true;
+            lock.unlock();
+            ring_.enter(pending, 1, IORING_ENTER_GETEVENTS);
+            lock.lock();
+            reaping_ = false;
+        } else if (pending > 0) {
+            ring_.enter(pending, 0, 0);
+        }
+
+        ring_.reap([&](const io_uring_cqe& cqe) {
+            auto* op = reinterpret_cast<Operation*>(cqe.user_data);
+            --inFlight_;
+
+            if (op->data) {
+                if (cqe.res > 0 && op->sent + cqe.res < op->size) {
+                    // short send, continue with the remainder
+                    op->sent += cqe.res;
+                    auto* sqe = nextSqe();
+                    setTarget(sqe, op->target);
+                    prepSend(sqe, op->data + op->sent, op->size - op->sent);
+                    sqe->user_data = cqe.user_data;
+                    return;
+                }
+                op->result = cqe.res > 0 ? static_cast<int>(op->size) : (cqe.res == 0 ? -EPIPE : cqe.res);
+            } else {
+                op->result = cqe.res;
+            }
+
+            if (op->callback) {
+                ready.emplace_back(op);
+            } else {
+                op->done = true;
+            }
+        });
+        cv_.notify_all();
+    }
+
+    static void dispatch(std::vector<std::unique_ptr<Operation>>& ready) {
+        for (auto& op : ready) {
+            op->callback(op->result);
+        }
+    }
+};
+
+
+struct IoUringConnection::Impl {
+
+    Impl(IoUringContext::Impl& ctx, int fd)
+        : ctx(ctx), fd(fd), fileIndex(ctx.registerFile(fd)),
+          readBuffer(ctx.acquireBuffer()), writeBuffer(ctx.acquireBuffer()) {
+
+        if (readBuffer < 0 || writeBuffer < 0) {
+            // registered buffers are used pairwise, or not at all
+            ctx.releaseBuffer(readBuffer);
+            ctx.releaseBuffer(writeBuffer);
+            readBuffer = writeBuffer = -1;
+        }
+    }
+
+    [[nodiscard]] IoUringContext::Impl::Target target() const {
+        return {fd, fileIndex};
+    }
+
+    int read(uint8_t* buffer, size_t size) {
+
+        if (fd < 0 || size == 0) return -1;
+
+        int result;
+        if (readBuffer >= 0) {
+            uint8_t* fixed = ctx.buffer(readBuffer);
+            const size_t count = std::min(size, ctx.bufferSize());
+            result = ctx.submitAndWait(target(), [&](io_uring_sqe* sqe) {
+                IoUringContext::Impl::prepFixed(sqe, IORING_OP_READ_FIXED, fixed, count, readBuffer);
+            });
+            if (result > 0) std::memcpy(buffer, fixed, result);
+        } else {
+            result = ctx.submitAndWait(target(), [&](io_uring_sqe* sqe) {
+                IoUringContext::Impl::prepRecv(sqe, buffer, size);
+            });
+        }
+        return result > 0 ? result : -1;
+    }
+
+    bool write(const uint8_t* data, size_t size) {
+
+        if (fd < 0) return false;
+
+        size_t total = 0;
+        while (total < size) {
+            if (writeBuffer >= 0) {
+                uint8_t* fixed = ctx.buffer(writeBuffer);
+                const size_t count = std::min(size - total, ctx.bufferSize());
+                std::memcpy(fixed, data + total, count);
+
+                size_t written = 0;
+                while (written < count) {
+                    const int result = ctx.submitAndWait(target(), [&](io_uring_sqe* sqe) {
+                        IoUringContext::Impl::prepFixed(sqe, IORING_OP_WRITE_FIXED, fixed + written, count - written, writeBuffer);
+                    });
+                    if (result <= 0) return false;
+                    written += static_cast<size_t>(result);
+                }
+                total += count;
+            } else {
+                const int result = ctx.submitAndWait(target(), [&](io_uring_sqe* sqe) {
+                    IoUringContext::Impl::prepSend(sqe, data + total, size - total);
+                });
+                if (result <= 0) return false;
+                total += static_cast<size_t>(result);
+            }
+        }
+        return true;
+    }
+
+    void close() {
+
+        const int closing = fd.exchange(-1);
+        if (closing < 0) return;
+
+        // wakes up pending operations, which still hold a reference to the file
+        ::shutdown(closing, SHUT_RDWR);
+        ctx.unregisterFile(fileIndex);
+        ::close(closing);
+    }
+
+    ~Impl() {
+
+        close();
+        ctx.releaseBuffer(readBuffer);
+        ctx.releaseBuffer(writeBuffer);
+    }
+
+    IoUringContext::Impl& ctx;
+    std::atomic_int fd;
+    int fileIndex;
+    int readBuffer;
+    int writeBuffer;
+};
+
+std::unique_ptr<IoUringConnection> IoUringContext::Impl::wrap(int fd) {
+
+    return std::unique_ptr<IoUringConnection>(new IoUringConnection(std::make_unique<IoUringConnection::Impl>(*this, fd)));
+}
+
+
+IoUringContext::IoUringContext(unsigned queueDepth, unsigned maxFixedFiles, unsigned numBuffers, size_t bufferSize)
+    : pimpl_(std::make_unique<Impl>(queueDepth, maxFixedFiles, numBuffers, bufferSize)) {}
+
+std::unique_ptr<IoUringConnection> IoUringContext::connect(const std::string& ip, uint16_t port) {
+
+    TCPClientContext ctx;
+    return adopt(ctx.connect(ip, port));
+}
+
+std::unique_ptr<IoUringConnection> IoUringContext::adopt(std::unique_ptr<SimpleConnection> conn) {
+
+    const auto socket = dynamic_cast<SocketConnection*>(conn.get());
+    if (!socket) return nullptr;
+
+    return pimpl_->wrap(socket->release());
+}
+
+size_t IoUringContext::run(bool wait) {
+
+    return pimpl_->run(wait);
+}
+
+size_t IoUringContext::inFlight() const {
+
+    return pimpl_->inFlight();
+}
+
+size_t IoUringContext::enterCalls() const {
+
+    return pimpl_->enterCalls();
+}
+
+IoUringContext::~IoUringContext() = default;
+
+
+IoUringConnection::IoUringConnection(std::unique_ptr<Impl> impl)
+    : pimpl_(std::move(impl)) {}
+
+int IoUringConnection::read(uint8_t* buffer, size_t size) {
+
+    return pimpl_->read(buffer, size);
+}
+
+bool IoUringConnection::write(const uint8_t* data, size_t size) {
+
+    return pimpl_->write(data, size);
+}
+
+void IoUringConnection::asyncRead(uint8_t* buffer, size_t size, IoCompletion onComplete) {
+
+    pimpl_->ctx.submitAsync(pimpl_->target(), [&](io_uring_sqe* sqe) {
+        IoUringContext::Impl::prepRecv(sqe, buffer, size);
+    }, std::move(onComplete));
+}
+
+void IoUringConnection::asyncWrite(const uint8_t* data, size_t size, IoCompletion onComplete) {
+
+    pimpl_->ctx.submitAsync(pimpl_->target(), [&](io_uring_sqe* sqe) {
+        IoUringContext::Impl::prepSend(sqe, data, size);
+    }, std::move(onComplete), data, size);
+}
+
+void IoUringConnection::close() {
+
+    pimpl_->close();
+}
+
+IoUringConnection::~IoUringConnection() = default;
+
+
+struct IoUringServer::Impl {
+
+    Impl(IoUringContext::Impl& ctx, uint16_t port, int backlog)
+        : ctx(ctx) {
+
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+        if (fd < 0) throwSocketError("Failed to create socket");
+
+        const int optval = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(port);
+
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, backlog) < 0) {
+            const int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "Bind/listen failed");
+        }
+        fileIndex = ctx.registerFile(fd);
+    }
+
+    std::unique_ptr<IoUringConnection> accept() {
+
+        const int result = ctx.submitAndWait({fd, fileIndex}, IoUringContext::Impl::prepAccept);
+        if (result < 0) throw std::system_error(-result, std::generic_category(), "Accept failed");
+        return ctx.wrap(result);
+    }
+
+    void asyncAccept(std::function<void(std::unique_ptr<IoUringConnection>)> onAccept) {
+
+        ctx.submitAsync({fd, fileIndex}, IoUringContext::Impl::prepAccept, [this, onAccept = std::move(onAccept)](int result) {
+            onAccept(result >= 0 ? ctx.wrap(result) : nullptr);
+        });
+    }
+
+    void close() {
+
+        const int closing = fd.exchange(-1);
+        if (closing < 0) return;
+
+        // makes pending accepts fail
+        ::shutdown(closing, SHUT_RDWR);
+        ctx.unregisterFile(fileIndex);
+        ::close(closing);
+    }
+
+    ~Impl() {
+
+        close();
+    }
+
+    IoUringContext::Impl& ctx;
+    std::atomic_int fd{-1};
+    int fileIndex{-1};
+};
+
+IoUringServer::IoUringServer(IoUringContext& ctx, uint16_t port, int backlog)
+    : pimpl_(std::make_unique<Impl>(*ctx.pimpl_, port, backlog)) {}
+
+std::unique_ptr<IoUringConnection> IoUringServer::accept() {
+
+    return pimpl_->accept();
+}
+
+void IoUringServer::asyncAccept(std::function<void(std::unique_ptr<IoUringConnection>)> onAccept) {
+
+    pimpl_->asyncAccept(std::move(onAccept));
+}
+
+void IoUringServer::close() {
+
+    pimpl_->close();
+}
+
+IoUringServer::~IoUringServer() = default;
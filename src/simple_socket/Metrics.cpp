@@ -0,0 +1,88 @@
+
+#include "simple_socket/Metrics.hpp"
+
+#include "simple_socket/util/thread_index.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+using namespace simple_socket;
+
+std::chrono::nanoseconds LatencyHistogram::mean() const {
+
+    return count == 0 ? std::chrono::nanoseconds(0) : total / static_cast<int64_t>(count);
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double q) const {
+
+    if (count == 0) return std::chrono::nanoseconds(0);
+
+    const auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < numBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= std::max<uint64_t>(rank, 1)) return std::chrono::nanoseconds(int64_t(1) << (i + 1));
+    }
+    return std::chrono::nanoseconds(int64_t(1) << numBuckets);
+}
+
+Metrics::Shard& Metrics::shard() noexcept {
+
+    return shards_[threadIndex() % numShards];
+}
+
+void Metrics::add(Counter counter, int64_t value) noexcept {
+
+    shard().counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+void Metrics::record(Latency latency, std::chrono::nanoseconds duration) noexcept {
+
+    const auto ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 1));
+    const size_t bucket = std::min<size_t>(std::bit_width(ns) - 1, LatencyHistogram::numBuckets - 1);
+
+    auto& s = shard();
+    if (latency == Latency::Read) {
+        s.readBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        s.readTotal.fetch_add(ns, std::memory_order_relaxed);
+    } else {
+        s.writeBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        s.writeTotal.fetch_add(ns, std::memory_order_relaxed);
+    }
+}
+
+MetricsSnapshot Metrics::snapshot() const {
+
+    std::array<int64_t, numCounters> counters{};
+    MetricsSnapshot snapshot;
+    for (const auto& s : shards_) {
+        for (size_t i = 0; i < numCounters; ++i) {
+            counters[i] += s.counters[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < LatencyHistogram::numBuckets; ++i) {
+            const auto reads = s.readBuckets[i].load(std::memory_order_relaxed);
+            const auto writes = s.writeBuckets[i].load(std::memory_order_relaxed);
+            snapshot.readLatency.buckets[i] += reads;
+            snapshot.readLatency.count += reads;
+            snapshot.writeLatency.buckets[i] += writes;
+            snapshot.writeLatency.count += writes;
+        }
+        snapshot.readLatency.total += std::chrono::nanoseconds(s.readTotal.load(std::memory_order_relaxed));
+        snapshot.writeLatency.total += std::chrono::nanoseconds(s.writeTotal.load(std::memory_order_relaxed));
+    }
+
+    const auto get = [&](Counter c) {
+        return counters[static_cast<size_t>(c)];
+    };
+    snapshot.bytesIn = get(Counter::BytesIn);
+    snapshot.bytesOut = get(Counter::BytesOut);
+    snapshot.readCalls = get(Counter::ReadCalls);
+    snapshot.writeCalls = get(Counter::WriteCalls);
+    snapshot.messagesIn = get(Counter::MessagesIn);
+    snapshot.messagesOut = get(Counter::MessagesOut);
+    snapshot.connectionsOpened = get(Counter::ConnectionsOpened);
+    snapshot.connectionsClosed = get(Counter::ConnectionsClosed);
+    snapshot.queueDepth = get(Counter::QueueDepth);
+    return snapshot;
+}
@@ -0,0 +1,230 @@
+
+#ifndef SIMPLE_SOCKET_POLLER_HPP
+#define SIMPLE_SOCKET_POLLER_HPP
+
+#include "simple_socket/socket_common.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace simple_socket {
+
+    // Readiness notification over a set of sockets.
+    // epoll on Linux, poll()/WSAPoll elsewhere. Registrations are one-shot: after an event is
+    // reported for a socket it stays disarmed until rearm() is called, which makes it safe for
+    // several threads to call wait() on the same Poller.
+    class Poller {
+    public:
+        enum : uint32_t {
+            Readable = 1,
+            Writable = 2,
+            Hangup = 4
+        };
+
+        struct Event {
+            uint64_t key;
+            uint32_t events;
+        };
+
+        Poller() {
+#ifdef __linux__
+            epfd_ = epoll_create1(EPOLL_CLOEXEC);
+            if (epfd_ < 0) throwSocketError("Failed to create epoll instance");
+            wakefd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC | EFD_SEMAPHORE);
+            if (wakefd_ < 0) throwSocketError("Failed to create eventfd");
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = wakeKey;
+            epoll_ctl(epfd_, EPOLL_CTL_ADD, wakefd_, &ev);
+#elif !defined(_WIN32)
+            if (::pipe(wakePipe_) != 0) throwSocketError("Failed to create wakeup pipe");
+            setNonBlocking(wakePipe_[0]);
+            setNonBlocking(wakePipe_[1]);
+#endif
+        }
+
+        Poller(const Poller&) = delete;
+        Poller& operator=(const Poller&) = delete;
+
+        bool add(SOCKET fd, uint64_t key, uint32_t interest) {
+#ifdef __linux__
+            epoll_event ev{};
+            ev.events = toEpoll(interest);
+            ev.data.u64 = key;
+            return epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+#else
+            {
+                std::lock_guard lock(mutex_);
+                entries_[key] = {fd, interest, true};
+            }
+            wakeup();
+            return true;
+#endif
+        }
+
+        // Re-enable a registration after its event has been consumed, optionally with new interest.
+        bool rearm(SOCKET fd, uint64_t key, uint32_t interest) {
+#ifdef __linux__
+            epoll_event ev{};
+            ev.events = toEpoll(interest);
+            ev.data.u64 = key;
+            return epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+#else
+            {
+                std::lock_guard lock(mutex_);
+                const auto it = entries_.find(key);
+                if (it == entries_.end()) return false;
+                it->second.interest = interest;
+                it->second.armed = true;
+            }
+            wakeup();
+            return true;
+#endif
+        }
+
+        void remove(SOCKET fd, uint64_t key) {
+#ifdef __linux__
+            (void) key;
+            epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+#else
+            (void) fd;
+            std::lock_guard lock(mutex_);
+            entries_.erase(key);
+#endif
+        }
+
+        // Blocks until at least one registered socket is ready, wakeup() is called or the timeout (ms, -1 = infinite) expires.
+        void wait(std::vector<Event>& events, int timeoutMs = -1) {
+            events.clear();
+#ifdef __linux__
+            epoll_event evs[64];
+            int n;
+            do {
+                n = epoll_wait(epfd_, evs, 64, timeoutMs);
+            } while (n < 0 && errno == EINTR);
+            for (int i = 0; i < n; ++i) {
+                if (evs[i].data.u64 == wakeKey) {
+                    uint64_t count;
+                    (void) !::read(wakefd_, &count, sizeof(count));
+                    continue;
+                }
+                events.push_back({evs[i].data.u64, fromEpoll(evs[i].events)});
+            }
+#else
+            std::vector<pollfd> fds;
+            std::vector<uint64_t> keys;
+            {
+                std::lock_guard lock(mutex_);
+                for (const auto& [key, e] : entries_) {
+                    if (!e.armed) continue;
+                    pollfd pfd{};
+                    pfd.fd = e.fd;
+                    pfd.events = static_cast<short>(((e.interest & Readable) ? POLLIN : 0) | ((e.interest & Writable) ? POLLOUT : 0));
+                    fds.push_back(pfd);
+                    keys.push_back(key);
+                }
+            }
+#ifdef _WIN32
+            // No portable self-pipe on Windows; cap the wait so registration changes are picked up.
+            constexpr int maxWait = 50;
+            const int timeout = (timeoutMs < 0 || timeoutMs > maxWait) ? maxWait : timeoutMs;
+#else
+            pollfd wake{};
+            wake.fd = wakePipe_[0];
+            wake.events = POLLIN;
+            fds.push_back(wake);
+            const int timeout = timeoutMs;
+#endif
+            const int n = pollSockets(fds.data(), fds.size(), timeout);
+#ifndef _WIN32
+            if (fds.back().revents & POLLIN) {
+                char drain[64];
+                while (::read(wakePipe_[0], drain, sizeof(drain)) > 0) {}
+            }
+            fds.pop_back();
+#endif
+            if (n <= 0) return;
+
+            std::lock_guard lock(mutex_);
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (fds[i].revents == 0) continue;
+                const auto it = entries_.find(keys[i]);
+                // another thread may already have consumed this one-shot event
+                if (it == entries_.end() || !it->second.armed) continue;
+                uint32_t ev = 0;
+                if (fds[i].revents & POLLIN) ev |= Readable;
+                if (fds[i].revents & POLLOUT) ev |= Writable;
+                if (fds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) ev |= Hangup;
+                it->second.armed = false;
+                events.push_back({keys[i], ev});
+            }
+#endif
+        }
+
+        // Interrupt one thread blocked in wait().
+        void wakeup() {
+#ifdef __linux__
+            const uint64_t one = 1;
+            (void) !::write(wakefd_, &one, sizeof(one));
+#elif !defined(_WIN32)
+            const char c = 0;
+            (void) !::write(wakePipe_[1], &c, 1);
+#endif
+        }
+
+        ~Poller() {
+#ifdef __linux__
+            ::close(wakefd_);
+            ::close(epfd_);
+#elif !defined(_WIN32)
+            ::close(wakePipe_[0]);
+            ::close(wakePipe_[1]);
+#endif
+        }
+
+    private:
+        static constexpr uint64_t wakeKey = UINT64_MAX;
+
+#ifdef __linux__
+        int epfd_;
+        int wakefd_;
+
+        static uint32_t toEpoll(uint32_t interest) {
+            uint32_t ev = EPOLLONESHOT | EPOLLRDHUP;
+            if (interest & Readable) ev |= EPOLLIN;
+            if (interest & Writable) ev |= EPOLLOUT;
+            return ev;
+        }
+
+        static uint32_t fromEpoll(uint32_t ev) {
+            uint32_t out = 0;
+            if (ev & EPOLLIN) out |= Readable;
+            if (ev & EPOLLOUT) out |= Writable;
+            if (ev & (EPOLLHUP | EPOLLERR)) out |= Hangup;
+            return out;
+        }
+#else
+        struct Entry {
+            SOCKET fd;
+            uint32_t interest;
+            bool armed;
+        };
+
+        std::mutex mutex_;
+        std::unordered_map<uint64_t, Entry> entries_;
+#ifndef _WIN32
+        int wakePipe_[2]{-1, -1};
+#endif
+#endif
+    };
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_POLLER_HPP
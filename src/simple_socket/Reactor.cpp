@@ -0,0 +1,253 @@
+
+#include "simple_socket/Reactor.hpp"
+
+#include "simple_socket/Poller.hpp"
+#include "simple_socket/SocketConnection.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace simple_socket;
+
+struct Reactor::Impl {
+
+    explicit Impl(size_t numThreads)
+        : numThreads_(numThreads == 0 ? 1 : numThreads) {}
+
+    bool add(std::unique_ptr<SimpleConnection> owned, SimpleConnection& conn, ReactorCallbacks callbacks) {
+
+        const auto socket = dynamic_cast<SocketConnection*>(&conn);
+        if (!socket) return false;
+
+        const SOCKET fd = *socket;
+        if (fd == INVALID_SOCKET || !setNonBlocking(fd)) return false;
+
+        auto entry = std::make_shared<Entry>();
+        entry->fd = fd;
+        entry->conn = &conn;
+        entry->owned = std::move(owned);
+        entry->callbacks = std::move(callbacks);
+
+        std::lock_guard lock(mutex_);
+        entry->key = nextKey_++;
+        if (!poller_.add(fd, entry->key, Poller::Readable)) return false;
+        byKey_[entry->key] = entry;
+        byConn_[&conn] = entry;
+        return true;
+    }
+
+    void setWantWrite(SimpleConnection& conn, bool enable) {
+
+        std::lock_guard lock(mutex_);
+        const auto it = byConn_.find(&conn);
+        if (it == byConn_.end()) return;
+        auto& entry = *it->second;
+        entry.wantWrite = enable;
+        // while a callback is running the registration is disarmed; it is re-armed with the new interest afterwards
+        if (!entry.inCallback) poller_.rearm(entry.fd, entry.key, entry.interest());
+    }
+
+    void remove(SimpleConnection& conn) {
+
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard lock(mutex_);
+            const auto it = byConn_.find(&conn);
+            if (it == byConn_.end()) return;
+            entry = it->second;
+            entry->closing = true;
+            if (entry->inCallback) return;// finalized by the dispatching thread
+            unregister(*entry);
+        }
+        finalize(*entry);
+    }
+
+    [[nodiscard]] size_t size() const {
+
+        std::lock_guard lock(mutex_);
+        return byKey_.size();
+    }
+
+    void start() {
+
+        stop_ = false;
+        for (size_t i = 0; i < numThreads_; ++i) {
+            threads_.emplace_back([this] { loop(); });
+        }
+    }
+
+    void stop() {
+
+        stop_ = true;
+        for (size_t i = 0; i < threads_.size(); ++i) {
+            poller_.wakeup();
+        }
+        for (auto& t : threads_) {
+            if (t.joinable()) t.join();
+        }
+        threads_.clear();
+
+        std::unordered_map<uint64_t, std::shared_ptr<Entry>> remaining;
+        {
+            std::lock_guard lock(mutex_);
+            for (auto& [key, entry] : byKey_) {
+                poller_.remove(entry->fd, key);
+            }
+            remaining.swap(byKey_);
+            byConn_.clear();
+        }
+        for (auto& [key, entry] : remaining) {
+            finalize(*entry);
+        }
+    }
+
+    ~Impl() {
+
+        stop();
+    }
+
+private:
+    struct Entry {
+        uint64_t key{};
+        SOCKET fd{INVALID_SOCKET};
+        SimpleConnection* conn{};
+        std::unique_ptr<SimpleConnection> owned;
+        ReactorCallbacks callbacks;
+
+        bool wantWrite{false};
+        bool inCallback{false};
+        bool closing{false};
+
+        [[nodiscard]] uint32_t interest() const {
+            uint32_t interest = Poller::Readable;
+            if (wantWrite) interest |= Poller::Writable;
+            return interest;
+        }
+    };
+
+    size_t numThreads_;
+    std::atomic_bool stop_{false};
+    std::vector<std::thread> threads_;
+
+    Poller poller_;
+    mutable std::mutex mutex_;
+    uint64_t nextKey_{1};
+    std::unordered_map<uint64_t, std::shared_ptr<Entry>> byKey_;
+    std::unordered_map<SimpleConnection*, std::shared_ptr<Entry>> byConn_;
+
+    // requires mutex_
+    void unregister(Entry& entry) {
+        poller_.remove(entry.fd, entry.key);
+        byKey_.erase(entry.key);
+        byConn_.erase(entry.conn);
+    }
+
+    static void finalize(Entry& entry) {
+        if (entry.callbacks.onClose) entry.callbacks.onClose(*entry.conn);
+        if (entry.owned) {
+            entry.owned->close();
+            entry.owned.reset();
+        }
+    }
+
+    void loop() {
+
+        std::vector<Poller::Event> events;
+        while (!stop_) {
+            poller_.wait(events);
+            for (const auto& ev : events) {
+                if (stop_) break;
+                dispatch(ev);
+            }
+        }
+    }
+
+    void dispatch(const Poller::Event& ev) {
+
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard lock(mutex_);
+            const auto it = byKey_.find(ev.key);
+            if (it == byKey_.end()) return;// removed while the event was in flight
+            entry = it->second;
+            entry->inCallback = true;
+        }
+
+        try {
+            if (ev.events & Poller::Readable) {
+                if (entry->callbacks.onReadable) {
+                    entry->callbacks.onReadable(*entry->conn);
+                } else {
+                    // nobody consumes input; treat as a request to close on EOF
+                    uint8_t scratch[256];
+                    const int n = entry->conn->read(scratch, sizeof(scratch));
+                    if (n <= 0 && n != SimpleConnection::WouldBlock) entry->closing = true;
+                }
+            } else if (ev.events & Poller::Hangup) {
+                entry->closing = true;
+            }
+            if (!entry->closing && (ev.events & Poller::Writable) && entry->callbacks.onWritable) {
+                entry->callbacks.onWritable(*entry->conn);
+            }
+        } catch (const std::exception&) {
+            entry->closing = true;
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            entry->inCallback = false;
+            if (!entry->closing) {
+                poller_.rearm(entry->fd, entry->key, entry->interest());
+                return;
+            }
+            // may already have been unregistered by stop()
+            if (byKey_.contains(entry->key)) unregister(*entry);
+        }
+        finalize(*entry);
+    }
+};
+
+Reactor::Reactor(size_t numThreads)
+    : pimpl_(std::make_unique<Impl>(numThreads)) {}
+
+bool Reactor::add(std::unique_ptr<SimpleConnection> conn, ReactorCallbacks callbacks) {
+
+    if (!conn) return false;
+    auto& ref = *conn;
+    return pimpl_->add(std::move(conn), ref, std::move(callbacks));
+}
+
+bool Reactor::watch(SimpleConnection& conn, ReactorCallbacks callbacks) {
+
+    return pimpl_->add(nullptr, conn, std::move(callbacks));
+}
+
+void Reactor::setWantWrite(SimpleConnection& conn, bool enable) {
+
+    pimpl_->setWantWrite(conn, enable);
+}
+
+void Reactor::remove(SimpleConnection& conn) {
+
+    pimpl_->remove(conn);
+}
+
+size_t Reactor::size() const {
+
+    return pimpl_->size();
+}
+
+void Reactor::start() {
+
+    pimpl_->start();
+}
+
+void Reactor::stop() {
+
+    pimpl_->stop();
+}
+
+Reactor::~Reactor() = default;
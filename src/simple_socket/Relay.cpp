@@ -0,0 +1,207 @@
+
+#include "simple_socket/Relay.hpp"
+
+#include "simple_socket/BufferedConnection.hpp"
+#include "simple_socket/SocketConnection.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
+using namespace simple_socket;
+
+namespace {
+
+    constexpr auto noDeadline = std::chrono::steady_clock::time_point::max();
+
+    // Looks through read buffering decorators for the socket underneath, if any.
+    SocketConnection* underlyingSocket(SimpleConnection& conn) {
+
+        auto* c = &conn;
+        while (const auto buffered = dynamic_cast<BufferedConnection*>(c)) {
+            c = &buffered->next();
+        }
+        return dynamic_cast<SocketConnection*>(c);
+    }
+
+    bool shutdownSocket(SimpleConnection& conn, bool both) {
+
+        const auto socket = underlyingSocket(conn);
+        if (!socket || *socket == INVALID_SOCKET) return false;
+#ifdef _WIN32
+        return ::shutdown(*socket, both ? SD_BOTH : SD_SEND) == 0;
+#else
+        return ::shutdown(*socket, both ? SHUT_RDWR : SHUT_WR) == 0;
+#endif
+    }
+
+#ifdef __linux__
+    struct Pipe {
+        int readEnd{-1};
+        int writeEnd{-1};
+
+        bool open(size_t size) {
+            int fds[2];
+            if (::pipe2(fds, O_CLOEXEC) != 0) return false;
+            readEnd = fds[0];
+            writeEnd = fds[1];
+            // best effort, the default (64 KiB) works too
+            ::fcntl(writeEnd, F_SETPIPE_SZ, static_cast<int>(size));
+            return true;
+        }
+
+        ~Pipe() {
+            if (readEnd != -1) ::close(readEnd);
+            if (writeEnd != -1) ::close(writeEnd);
+        }
+    };
+
+    // Socket -> pipe -> socket, the payload stays in kernel pages. Returns true if from reached EOF.
+    bool spliceRelay(SOCKET from, SOCKET to, Pipe& pipe, size_t chunkSize, std::atomic_size_t& total) {
+
+        for (;;) {
+            const auto n = ::splice(from, nullptr, pipe.writeEnd, nullptr, chunkSize, SPLICE_F_MOVE);
+            if (n == 0) return true;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (socketWouldBlock() && waitSocket(from, POLLIN, noDeadline) > 0) continue;
+                return false;
+            }
+
+            // drain the pipe completely, so the next splice into it can never block
+            auto pending = static_cast<size_t>(n);
+            while (pending > 0) {
+                const auto m = ::splice(pipe.readEnd, nullptr, to, nullptr, pending, SPLICE_F_MOVE);
+                if (m < 0) {
+                    if (errno == EINTR) continue;
+                    if (socketWouldBlock() && waitSocket(to, POLLOUT, noDeadline) > 0) continue;
+                    return false;
+                }
+                pending -= static_cast<size_t>(m);
+                total += static_cast<size_t>(m);
+            }
+        }
+    }
+#endif
+
+    bool copyRelay(SimpleConnection& from, SimpleConnection& to, size_t bufferSize, std::atomic_size_t& total) {
+
+        std::vector<uint8_t> buffer(bufferSize);
+        for (;;) {
+            const auto result = from.readUntil(buffer.data(), buffer.size(), noDeadline);
+            if (!result) return result.status == IoStatus::Closed;
+            if (!to.write(buffer.data(), result.bytes)) return false;
+            total += result.bytes;
+        }
+    }
+
+    bool relayImpl(SimpleConnection& from, SimpleConnection& to, size_t bufferSize, std::atomic_size_t& total) {
+
+        if (bufferSize == 0) bufferSize = 64 * 1024;
+
+        // bytes a decorator already pulled off the socket have to go first
+        auto* source = &from;
+        while (const auto buffered = dynamic_cast<BufferedConnection*>(source)) {
+            std::vector<uint8_t> pending(buffered->buffered());
+            if (!pending.empty()) {
+                if (!buffered->readExact(pending) || !to.write(pending)) return false;
+                total += pending.size();
+            }
+            source = &buffered->next();
+        }
+
+#ifdef __linux__
+        const auto fromSocket = dynamic_cast<SocketConnection*>(source);
+        const auto toSocket = underlyingSocket(to);
+        if (fromSocket && toSocket) {
+            Pipe pipe;
+            if (pipe.open(bufferSize)) {
+                return spliceRelay(*fromSocket, *toSocket, pipe, bufferSize, total);
+            }
+        }
+#endif
+
+        return copyRelay(*source, to, bufferSize, total);
+    }
+
+}// namespace
+
+size_t simple_socket::relay(SimpleConnection& from, SimpleConnection& to, size_t bufferSize) {
+
+    std::atomic_size_t total{0};
+    relayImpl(from, to, bufferSize, total);
+    return total;
+}
+
+struct Relay::Impl {
+
+    Impl(std::unique_ptr<SimpleConnection> a, std::unique_ptr<SimpleConnection> b, size_t bufferSize)
+        : a_(std::move(a)), b_(std::move(b)), bufferSize_(bufferSize) {
+
+        if (!a_ || !b_) throw std::invalid_argument("Relay requires two connections");
+    }
+
+    void run() {
+
+        std::thread backward([this] { forward(*b_, *a_, returned_); });
+        forward(*a_, *b_, forwarded_);
+        backward.join();
+
+        a_->close();
+        b_->close();
+    }
+
+    void stop() {
+
+        // shutdown wakes up blocked reads without giving up the descriptors, which run() closes later
+        for (auto* conn : {a_.get(), b_.get()}) {
+            if (!shutdownSocket(*conn, true)) conn->close();
+        }
+    }
+
+    std::atomic_size_t forwarded_{0};
+    std::atomic_size_t returned_{0};
+
+private:
+    std::unique_ptr<SimpleConnection> a_;
+    std::unique_ptr<SimpleConnection> b_;
+    size_t bufferSize_;
+
+    void forward(SimpleConnection& from, SimpleConnection& to, std::atomic_size_t& counter) {
+
+        if (relayImpl(from, to, bufferSize_, counter)) {
+            // pass the EOF on, the other direction keeps going
+            if (shutdownSocket(to, false)) return;
+        }
+        stop();
+    }
+};
+
+Relay::Relay(std::unique_ptr<SimpleConnection> a, std::unique_ptr<SimpleConnection> b, size_t bufferSize)
+    : pimpl_(std::make_unique<Impl>(std::move(a), std::move(b), bufferSize)) {}
+
+void Relay::run() {
+
+    pimpl_->run();
+}
+
+void Relay::stop() {
+
+    pimpl_->stop();
+}
+
+size_t Relay::bytesForwarded() const {
+
+    return pimpl_->forwarded_;
+}
+
+size_t Relay::bytesReturned() const {
+
+    return pimpl_->returned_;
+}
+
+Relay::~Relay() = default;
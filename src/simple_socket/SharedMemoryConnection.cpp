@@ -1,11 +1,15 @@
 #include "simple_socket/SharedMemoryConnection.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
 #include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <cerrno>
 #include <fcntl.h>
 #include <semaphore.h>
 #include <sys/mman.h>
@@ -95,6 +99,49 @@ struct SharedMemoryConnection::Impl {
 
     ~Impl() { close(); }
 
+#ifdef _WIN32
+    using Semaphore = HANDLE;
+#else
+    using Semaphore = sem_t*;
+#endif
+
+    // Waits on a semaphore until the deadline (time_point::max() waits forever). Returns false on timeout.
+    static bool waitSemaphore(Semaphore sem, std::chrono::steady_clock::time_point deadline) {
+        const bool forever = deadline == std::chrono::steady_clock::time_point::max();
+#ifdef _WIN32
+        DWORD timeout = INFINITE;
+        if (!forever) {
+            const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            timeout = static_cast<DWORD>(std::clamp<long long>(remaining, 0, INFINITE - 1));
+        }
+        return WaitForSingleObject(sem, timeout) == WAIT_OBJECT_0;
+#elif defined(__APPLE__)
+        // no sem_timedwait on macOS
+        while (sem_trywait(sem) != 0) {
+            if (!forever && std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return true;
+#else
+        if (forever) {
+            while (sem_wait(sem) != 0) {
+                if (errno != EINTR) return false;
+            }
+            return true;
+        }
+        // sem_timedwait takes an absolute CLOCK_REALTIME time
+        const auto wallDeadline = std::chrono::system_clock::now() + (deadline - std::chrono::steady_clock::now());
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wallDeadline.time_since_epoch()).count();
+        timespec ts{};
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+        while (sem_timedwait(sem, &ts) != 0) {
+            if (errno != EINTR) return false;
+        }
+        return true;
+#endif
+    }
+
     void close() {
 #ifdef _WIN32
         if (shm_) UnmapViewOfFile(shm_);
@@ -127,12 +174,17 @@ SharedMemoryConnection::SharedMemoryConnection(const std::string& name, size_t s
     : pimpl_(std::make_unique<Impl>(name, size, isServer)) {}
 
 int SharedMemoryConnection::read(uint8_t* buffer, size_t size) {
-    if (!buffer || size == 0) return -1;
-#ifdef _WIN32
-    WaitForSingleObject(pimpl_->peerReadSem_, INFINITE);
-#else
-    sem_wait(pimpl_->peerReadSem_);
-#endif
+    const auto result = readUntil(buffer, size, std::chrono::steady_clock::time_point::max());
+    return result ? static_cast<int>(result.bytes) : -1;
+}
+
+bool SharedMemoryConnection::write(const uint8_t* data, size_t size) {
+    return static_cast<bool>(writeUntil(data, size, std::chrono::steady_clock::time_point::max()));
+}
+
+IoResult SharedMemoryConnection::readUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) {
+    if (!buffer || size == 0) return {IoStatus::Error, 0};
+    if (!Impl::waitSemaphore(pimpl_->peerReadSem_, deadline)) return {IoStatus::Timeout, 0};
     std::atomic_thread_fence(std::memory_order_acquire);
 
     size_t dataSize = pimpl_->peerBuffer_->size;
@@ -142,7 +194,7 @@ int SharedMemoryConnection::read(uint8_t* buffer, size_t size) {
 #else
         sem_post(pimpl_->peerWriteSem_);
 #endif
-        return -1;
+        return {IoStatus::Error, 0};
     }
     std::memcpy(buffer, pimpl_->peerBuffer_->data, dataSize);
     pimpl_->peerBuffer_->size = 0;
@@ -153,11 +205,29 @@ int SharedMemoryConnection::read(uint8_t* buffer, size_t size) {
 #else
     sem_post(pimpl_->peerWriteSem_);
 #endif
-    return static_cast<int>(dataSize);
+    return {IoStatus::Ok, dataSize};
 }
 
-bool SharedMemoryConnection::write(const uint8_t* data, size_t size) {
-    if (!data || size == 0 || size > pimpl_->bufferSize_) return false;
+IoResult SharedMemoryConnection::writeUntil(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point deadline) {
+    if (!data || size == 0 || size > pimpl_->bufferSize_) return {IoStatus::Error, 0};
+    if (!Impl::waitSemaphore(pimpl_->myWriteSem_, deadline)) return {IoStatus::Timeout, 0};
+    std::atomic_thread_fence(std::memory_order_release);
+    pimpl_->myBuffer_->size = size;
+    std::memcpy(pimpl_->myBuffer_->data, data, size);
+    std::atomic_thread_fence(std::memory_order_release);
+
+#ifdef _WIN32
+    ReleaseSemaphore(pimpl_->myReadSem_, 1, nullptr);
+#else
+    sem_post(pimpl_->myReadSem_);
+#endif
+    return {IoStatus::Ok, size};
+}
+
+bool SharedMemoryConnection::writev(std::span<const ConstBuffer> buffers) {
+    size_t size = 0;
+    for (const auto& b : buffers) size += b.size;
+    if (size == 0 || size > pimpl_->bufferSize_) return false;
 #ifdef _WIN32
     WaitForSingleObject(pimpl_->myWriteSem_, INFINITE);
 #else
@@ -165,7 +235,12 @@ bool SharedMemoryConnection::write(const uint8_t* data, size_t size) {
 #endif
     std::atomic_thread_fence(std::memory_order_release);
     pimpl_->myBuffer_->size = size;
-    std::memcpy(pimpl_->myBuffer_->data, data, size);
+    size_t offset = 0;
+    for (const auto& b : buffers) {
+        if (b.size == 0) continue;
+        std::memcpy(pimpl_->myBuffer_->data + offset, b.data, b.size);
+        offset += b.size;
+    }
     std::atomic_thread_fence(std::memory_order_release);
 
 #ifdef _WIN32
@@ -176,6 +251,38 @@ bool SharedMemoryConnection::write(const uint8_t* data, size_t size) {
     return true;
 }
 
+int SharedMemoryConnection::readv(std::span<const MutableBuffer> buffers) {
+    size_t capacity = 0;
+    for (const auto& b : buffers) capacity += b.size;
+    if (capacity == 0) return -1;
+#ifdef _WIN32
+    WaitForSingleObject(pimpl_->peerReadSem_, INFINITE);
+#else
+    sem_wait(pimpl_->peerReadSem_);
+#endif
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    const size_t dataSize = pimpl_->peerBuffer_->size;
+    if (dataSize <= capacity) {
+        size_t offset = 0;
+        for (const auto& b : buffers) {
+            if (offset == dataSize) break;
+            const size_t count = std::min(b.size, dataSize - offset);
+            std::memcpy(b.data, pimpl_->peerBuffer_->data + offset, count);
+            offset += count;
+        }
+        pimpl_->peerBuffer_->size = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+#ifdef _WIN32
+    ReleaseSemaphore(pimpl_->peerWriteSem_, 1, nullptr);
+#else
+    sem_post(pimpl_->peerWriteSem_);
+#endif
+    return dataSize <= capacity ? static_cast<int>(dataSize) : -1;
+}
+
 void SharedMemoryConnection::close() {
     if (pimpl_) pimpl_->close();
 }
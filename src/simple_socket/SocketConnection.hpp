@@ -2,9 +2,24 @@
 #ifndef SIMPLE_SOCKET_SOCKET_HPP
 #define SIMPLE_SOCKET_SOCKET_HPP
 
+#include "simple_socket/Metrics.hpp"
 #include "simple_socket/SimpleConnection.hpp"
 #include "simple_socket/socket_common.hpp"
 
+#include <atomic>
+#include <deque>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define SIMPLE_SOCKET_HAS_ZEROCOPY
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#endif
+
 
 namespace simple_socket {
 
@@ -13,42 +28,476 @@ namespace simple_socket {
         explicit SocketConnection(SOCKET socket)
             : sockfd_(socket) {}
 
+        using SimpleConnection::readv;
+        using SimpleConnection::writev;
+
         int read(unsigned char* buffer, size_t size) override {
 
+            Metrics::Timer timer(metrics_.get(), Metrics::Latency::Read);
 #ifdef _WIN32
             const auto read = recv(sockfd_, reinterpret_cast<char*>(buffer), static_cast<int>(size), 0);
 #else
             const auto read = ::read(sockfd_, buffer, size);
 #endif
+            countRead(read);
 
-            return (read != SOCKET_ERROR) && (read != 0) ? read : -1;
+            if (read > 0) return static_cast<int>(read);
+            return read == SOCKET_ERROR && socketWouldBlock() ? WouldBlock : -1;
         }
 
         bool write(const unsigned char* data, size_t size) override {
 
+            Metrics::Timer timer(metrics_.get(), Metrics::Latency::Write);
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+            if (useZeroCopy(size)) {
+                // the caller may reuse data once we return, so wait for the kernel to let go of it
+                return writeZeroCopy({}, data, size) && reapZeroCopy(0);
+            }
+#endif
+
+            // Loop on short writes; a non-blocking socket (e.g. one owned by a Reactor) waits for POLLOUT instead of failing.
+            size_t total = 0;
+            while (total < size) {
+#ifdef _WIN32
+                const auto n = send(sockfd_, reinterpret_cast<const char*>(data + total), static_cast<int>(size - total), 0);
+#else
+                const auto n = ::write(sockfd_, data + total, size - total);
+#endif
+                countWrite(n);
+                if (n == SOCKET_ERROR) {
+                    if (socketWouldBlock() && waitWritable()) continue;
+#ifndef _WIN32
+                    if (errno == EINTR) continue;
+#endif
+                    return false;
+                }
+                total += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool writev(std::span<const ConstBuffer> buffers) override {
+
+            Metrics::Timer timer(metrics_.get(), Metrics::Latency::Write);
+            int flags = 0;
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+            size_t total = 0;
+            for (const auto& b : buffers) total += b.size;
+            if (useZeroCopy(total)) flags = MSG_ZEROCOPY;
+            const auto firstSeq = zeroCopyNextSeq_;
+#endif
+
+            // gather in batches on the stack to keep the hot path allocation free
+            IoVec iov[maxIoVecs];
+            size_t next = 0;
+            while (next < buffers.size()) {
+                size_t count = 0;
+                for (; next < buffers.size() && count < maxIoVecs; ++next) {
+                    if (buffers[next].size == 0) continue;
+                    iov[count++] = makeIoVec(buffers[next].data, buffers[next].size);
+                }
+                if (!writeAll(iov, count, flags)) return false;
+            }
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+            if (zeroCopyNextSeq_ != firstSeq) {
+                // like write(), the buffers are the caller's again once we return
+                zeroCopyPending_.push_back({zeroCopyNextSeq_ - 1, {}, {}});
+                countQueued(1);
+                return reapZeroCopy(0);
+            }
+#endif
+            return true;
+        }
+
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+        bool writeOwned(std::vector<uint8_t> data, const ReleaseHandler& onRelease = {}) override {
+
+            if (!useZeroCopy(data.size())) return SimpleConnection::writeOwned(std::move(data), onRelease);
+
+            const auto* bytes = data.data();
+            const auto size = data.size();
+            const bool ok = writeZeroCopy(ZeroCopyBuffer{0, std::move(data), onRelease}, bytes, size);
+            // hand back what already completed, and bound the memory pinned by in-flight sends
+            return reapZeroCopy(maxZeroCopyPending) && ok;
+        }
+
+        bool enableZeroCopy() override {
+
+            const int one = 1;
+            zeroCopy_ = setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+            return zeroCopy_;
+        }
+
+        void flush() override {
+
+            reapZeroCopy(0);
+        }
+#endif
+
+#ifdef __linux__
+        size_t readTxTimestamps(std::span<TxTimestamp> out) override {
+
+            while (readErrorMessage() || errno == EINTR) {}
+            const size_t count = std::min(out.size(), txTimestamps_.size());
+            std::copy_n(txTimestamps_.begin(), count, out.begin());
+            txTimestamps_.erase(txTimestamps_.begin(), txTimestamps_.begin() + static_cast<std::ptrdiff_t>(count));
+            return count;
+        }
+#endif
+
+        int readv(std::span<const MutableBuffer> buffers) override {
+
+            Metrics::Timer timer(metrics_.get(), Metrics::Latency::Read);
+            // scatter in batches on the stack; only the first batch waits, the others take what already arrived
+            IoVec iov[maxIoVecs];
+            size_t total = 0;
+            size_t next = 0;
+            do {
+                size_t count = 0;
+                size_t capacity = 0;
+                for (; next < buffers.size() && count < maxIoVecs; ++next) {
+                    if (buffers[next].size == 0) continue;
+                    iov[count++] = makeIoVec(buffers[next].data, buffers[next].size);
+                    capacity += buffers[next].size;
+                }
+                const int n = readSome(iov, count, total > 0);
+                if (n <= 0) return total > 0 ? static_cast<int>(total) : n;
+                total += static_cast<size_t>(n);
+                if (static_cast<size_t>(n) < capacity) break;
+            } while (next < buffers.size());
+            return static_cast<int>(total);
+        }
+
+        IoResult readUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) override {
+
+            Metrics::Timer timer(metrics_.get(), Metrics::Latency::Read);
+            for (;;) {
+                const int ready = waitSocket(sockfd_, POLLIN, deadline);
+                if (ready == 0) return {IoStatus::Timeout, 0};
+                if (ready == SOCKET_ERROR) return {IoStatus::Error, 0};
 #ifdef _WIN32
-            return send(sockfd_, reinterpret_cast<const char*>(data), static_cast<int>(size), 0) != SOCKET_ERROR;
+                const auto n = recv(sockfd_, reinterpret_cast<char*>(buffer), static_cast<int>(size), 0);
 #else
-            return ::write(sockfd_, data, size) != SOCKET_ERROR;
+                const auto n = ::recv(sockfd_, buffer, size, MSG_DONTWAIT);
 #endif
+                countRead(n);
+                if (n > 0) return {IoStatus::Ok, static_cast<size_t>(n)};
+                if (n == 0) return {IoStatus::Closed, 0};
+                if (socketWouldBlock()) continue;// spurious wakeup
+#ifndef _WIN32
+                if (errno == EINTR) continue;
+#endif
+                return {IoStatus::Error, 0};
+            }
+        }
+
+        // Note: on Windows a blocking socket may block inside send() once poll reported it writable.
+        IoResult writeUntil(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point deadline) override {
+
+            Metrics::Timer timer(metrics_.get(), Metrics::Latency::Write);
+            size_t total = 0;
+            while (total < size) {
+#ifdef _WIN32
+                const auto n = send(sockfd_, reinterpret_cast<const char*>(data + total), static_cast<int>(size - total), 0);
+#else
+                const auto n = ::send(sockfd_, data + total, size - total, MSG_DONTWAIT | MSG_NOSIGNAL);
+#endif
+                countWrite(n);
+                if (n == SOCKET_ERROR) {
+#ifndef _WIN32
+                    if (errno == EINTR) continue;
+#endif
+                    if (!socketWouldBlock()) return {IoStatus::Error, total};
+                    const int ready = waitSocket(sockfd_, POLLOUT, deadline);
+                    if (ready == 0) return {IoStatus::Timeout, total};
+                    if (ready == SOCKET_ERROR) return {IoStatus::Error, total};
+                    continue;
+                }
+                total += static_cast<size_t>(n);
+            }
+            return {IoStatus::Ok, total};
+        }
+
+        void setMetrics(std::shared_ptr<Metrics> metrics) override {
+
+            if (metrics == metrics_) return;// e.g. set again by a protocol layer on top
+            metrics_ = std::move(metrics);
+            if (metrics_ && sockfd_ != INVALID_SOCKET) metrics_->add(Metrics::Counter::ConnectionsOpened);
         }
 
         void close() override {
 
-            closeSocket(sockfd_);
+            const SOCKET fd = sockfd_.exchange(INVALID_SOCKET);
+            if (fd != INVALID_SOCKET && metrics_) metrics_->add(Metrics::Counter::ConnectionsClosed);
+            closeSocket(fd);
         }
 
         ~SocketConnection() override {
 
             SocketConnection::close();
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+            // the socket is gone, nothing can reference the buffers any more
+            countQueued(-static_cast<int64_t>(zeroCopyPending_.size()));
+            for (auto& pending : zeroCopyPending_) {
+                if (pending.onRelease) pending.onRelease(std::move(pending.buffer));
+            }
+#endif
         }
 
         operator SOCKET() const {
             return sockfd_;
         }
 
+        // Give up ownership of the descriptor without closing it.
+        SOCKET release() {
+            return sockfd_.exchange(INVALID_SOCKET);
+        }
+
+    protected:
+#ifdef _WIN32
+        using IoVec = WSABUF;
+#else
+        using IoVec = iovec;
+#endif
+        static constexpr size_t maxIoVecs = 64;
+
+        static IoVec makeIoVec(const uint8_t* data, size_t size) {
+#ifdef _WIN32
+            return {static_cast<ULONG>(size), const_cast<char*>(reinterpret_cast<const char*>(data))};
+#else
+            return {const_cast<uint8_t*>(data), size};
+#endif
+        }
+
+        // One scatter read, like read(). With dontWait it returns WouldBlock instead of waiting for data.
+        int readSome(IoVec* iov, size_t count, bool dontWait) {
+
+#ifdef _WIN32
+            if (dontWait) {
+                u_long available = 0;
+                if (ioctlsocket(sockfd_, FIONREAD, &available) != 0 || available == 0) return WouldBlock;
+            }
+            DWORD received = 0;
+            DWORD flags = 0;
+            if (WSARecv(sockfd_, iov, static_cast<DWORD>(count), &received, &flags, nullptr, nullptr) != 0) {
+                countRead(SOCKET_ERROR);
+                return socketWouldBlock() ? WouldBlock : -1;
+            }
+            countRead(received);
+            return received != 0 ? static_cast<int>(received) : -1;
+#else
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = count;
+            const auto read = ::recvmsg(sockfd_, &msg, dontWait ? MSG_DONTWAIT : 0);
+            countRead(read);
+            if (read > 0) return static_cast<int>(read);
+            return read == SOCKET_ERROR && socketWouldBlock() ? WouldBlock : -1;
+#endif
+        }
+
+        bool writeAll(IoVec* iov, size_t count, int flags = 0) {
+
+            size_t first = 0;
+            while (first < count) {
+#ifdef _WIN32
+                DWORD sent = 0;
+                const auto rc = WSASend(sockfd_, iov + first, static_cast<DWORD>(count - first), &sent, 0, nullptr, nullptr);
+                const auto n = rc == 0 ? static_cast<long long>(sent) : SOCKET_ERROR;
+#else
+                msghdr msg{};
+                msg.msg_iov = iov + first;
+                msg.msg_iovlen = count - first;
+                const auto n = ::sendmsg(sockfd_, &msg, flags);
+#endif
+                countWrite(n);
+                if (n == SOCKET_ERROR) {
+                    if (socketWouldBlock() && waitWritable()) continue;
+#ifndef _WIN32
+                    if (errno == EINTR) continue;
+#endif
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+                    if (flags != 0 && errno == ENOBUFS) {
+                        flags = 0;// out of notification memory, copy the rest
+                        continue;
+                    }
+#endif
+                    return false;
+                }
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+                if (flags != 0) ++zeroCopyNextSeq_;
+#endif
+
+                // skip fully written buffers, trim the partially written one
+                auto remaining = static_cast<size_t>(n);
+                while (first < count) {
+#ifdef _WIN32
+                    auto& len = iov[first].len;
+                    auto*& base = iov[first].buf;
+#else
+                    auto& len = iov[first].iov_len;
+                    auto*& base = reinterpret_cast<uint8_t*&>(iov[first].iov_base);
+#endif
+                    if (remaining < len) {
+                        len -= static_cast<std::remove_reference_t<decltype(len)>>(remaining);
+                        base += remaining;
+                        break;
+                    }
+                    remaining -= len;
+                    ++first;
+                }
+            }
+            return true;
+        }
+
+        std::shared_ptr<Metrics> metrics_;
+
+        void countRead(long long n) const {
+            if (!metrics_) return;
+            metrics_->add(Metrics::Counter::ReadCalls);
+            if (n > 0) metrics_->add(Metrics::Counter::BytesIn, n);
+        }
+
+        void countWrite(long long n) const {
+            if (!metrics_) return;
+            metrics_->add(Metrics::Counter::WriteCalls);
+            if (n > 0) metrics_->add(Metrics::Counter::BytesOut, n);
+        }
+
+        void countQueued(int64_t delta) const {
+            if (metrics_ && delta != 0) metrics_->add(Metrics::Counter::QueueDepth, delta);
+        }
+
+        bool waitWritable() const {
+            pollfd pfd{};
+            pfd.fd = sockfd_;
+            pfd.events = POLLOUT;
+            return pollSockets(&pfd, 1, -1) > 0 && (pfd.revents & POLLOUT);
+        }
+
+#ifdef __linux__
+        // Transmit timestamps read from the error queue but not taken yet, the oldest are dropped beyond this many.
+        static constexpr size_t maxTxTimestamps = 1024;
+        std::deque<TxTimestamp> txTimestamps_;
+
+        // Reads one message from the error queue without waiting: a transmit timestamp is kept for
+        // readTxTimestamps(), a zero-copy completion recorded. Returns false (with errno set) if none could be read.
+        bool readErrorMessage() {
+
+            alignas(cmsghdr) char control[errorQueueControlSize];
+            msghdr msg{};
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if (::recvmsg(sockfd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == SOCKET_ERROR) return false;
+
+            TxTimestamp timestamp;
+            if (txTimestampOf(msg, timestamp)) {
+                if (txTimestamps_.size() == maxTxTimestamps) txTimestamps_.pop_front();
+                txTimestamps_.push_back(timestamp);
+                return true;
+            }
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+            for (auto* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+                const bool isErr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                                   (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+                if (!isErr) continue;
+                sock_extended_err err{};
+                std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+                if (err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0) continue;
+                completeZeroCopy(err.ee_info, err.ee_data);
+            }
+#endif
+            return true;
+        }
+#endif
+
+#ifdef SIMPLE_SOCKET_HAS_ZEROCOPY
+        // Below this size pinning pages and handling the notification costs more than the copy.
+        static constexpr size_t zeroCopyThreshold = 16 * 1024;
+        static constexpr size_t maxZeroCopyPending = 64;
+
+        struct ZeroCopyBuffer {
+            uint32_t lastSeq;// notification id of the last send referencing the buffer
+            std::vector<uint8_t> buffer;
+            ReleaseHandler onRelease;
+        };
+
+        bool zeroCopy_{false};
+        uint32_t zeroCopyNextSeq_{0};  // id the kernel assigns to the next MSG_ZEROCOPY send
+        uint32_t zeroCopyCompleted_{0};// all ids before this one are confirmed
+        std::vector<std::pair<uint32_t, uint32_t>> zeroCopyOutOfOrder_;
+        std::deque<ZeroCopyBuffer> zeroCopyPending_;
+
+        [[nodiscard]] bool useZeroCopy(size_t size) const {
+            return zeroCopy_ && size >= zeroCopyThreshold;
+        }
+
+        // Sends all bytes with MSG_ZEROCOPY and queues pending for release once the kernel is done with them.
+        bool writeZeroCopy(ZeroCopyBuffer pending, const uint8_t* data, size_t size) {
+
+            const auto firstSeq = zeroCopyNextSeq_;
+            IoVec iov = makeIoVec(data, size);
+            const bool ok = writeAll(&iov, 1, MSG_ZEROCOPY);
+
+            if (zeroCopyNextSeq_ == firstSeq) {
+                // nothing went out zero-copy
+                if (pending.onRelease) pending.onRelease(std::move(pending.buffer));
+                return ok;
+            }
+            pending.lastSeq = zeroCopyNextSeq_ - 1;
+            zeroCopyPending_.push_back(std::move(pending));
+            countQueued(1);
+            return ok;
+        }
+
+        // Drains completion notifications from the error queue and releases confirmed buffers in order.
+        // Blocks until at most maxPending buffers remain in flight.
+        bool reapZeroCopy(size_t maxPending) {
+
+            for (;;) {
+                while (!zeroCopyPending_.empty() &&
+                       static_cast<int32_t>(zeroCopyPending_.front().lastSeq - zeroCopyCompleted_) < 0) {
+                    auto done = std::move(zeroCopyPending_.front());
+                    zeroCopyPending_.pop_front();
+                    countQueued(-1);
+                    if (done.onRelease) done.onRelease(std::move(done.buffer));
+                }
+                if (zeroCopyPending_.empty()) return true;
+
+                if (!readErrorMessage()) {
+                    if (errno == EINTR) continue;
+                    if (!socketWouldBlock()) return false;
+                    if (zeroCopyPending_.size() <= maxPending) return true;
+
+                    // the error queue only signals POLLERR, which is always reported
+                    pollfd pfd{};
+                    pfd.fd = sockfd_;
+                    if (pollSockets(&pfd, 1, -1) < 0 || (pfd.revents & POLLNVAL)) return false;
+                    continue;
+                }
+            }
+        }
+
+        // Records that the sends [lo, hi] are confirmed.
+        void completeZeroCopy(uint32_t lo, uint32_t hi) {
+
+            zeroCopyOutOfOrder_.emplace_back(lo, hi);
+            for (bool advanced = true; advanced;) {
+                advanced = false;
+                for (auto it = zeroCopyOutOfOrder_.begin(); it != zeroCopyOutOfOrder_.end(); ++it) {
+                    if (it->first == zeroCopyCompleted_) {
+                        zeroCopyCompleted_ = it->second + 1;
+                        zeroCopyOutOfOrder_.erase(it);
+                        advanced = true;
+                        break;
+                    }
+                }
+            }
+        }
+#endif
+
     private:
-        SOCKET sockfd_;
+        std::atomic<SOCKET> sockfd_;
     };
 
 
@@ -15,40 +15,178 @@
 #include "simple_socket/tls/TLSConnection.hpp"
 #endif
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 
 using namespace simple_socket;
 
 namespace {
+    // Delay before racing the next address while earlier attempts are still pending (RFC 8305).
+    constexpr std::chrono::milliseconds connectionAttemptDelay{250};
+
     SOCKET createSocket() {
         SOCKET sockfd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
         if (sockfd == INVALID_SOCKET) {
             throwSocketError("Failed to create socket");
         }
 
-        // const int optval = 1;
-        // setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&optval), sizeof(optval));
+        return sockfd;
+    }
+
+    SOCKET createListenSocket(bool reusePort) {
+
+        SOCKET sockfd = createSocket();
+        const int optval = 1;
+
+#ifndef _WIN32
+        // allow an immediate restart while old connections linger in TIME_WAIT
+        // (on Windows SO_REUSEADDR would let other processes steal the port)
+        setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&optval), sizeof(optval));
+#endif
+
+        if (reusePort) {
+#if defined(__linux__) && defined(SO_REUSEPORT)
+            if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval)) < 0) {
+                closeSocket(sockfd);
+                throwSocketError("Failed to set SO_REUSEPORT");
+            }
+#else
+            closeSocket(sockfd);
+            throw std::runtime_error("SO_REUSEPORT load balancing is not supported on this platform");
+#endif
+        }
 
         return sockfd;
     }
 
-    std::pair<std::string, uint16_t> parseHostPort(const std::string& input) {
-        const size_t colonPos = input.find(':');
-        if (colonPos == std::string::npos) {
-            throw std::invalid_argument("Invalid input format. Expected 'host:port'.");
+    // Orders resolved addresses by alternating address families, starting with the resolver's first choice,
+    // so a broken IPv6 (or IPv4) path only costs one attempt delay.
+    std::vector<const addrinfo*> interleaveFamilies(const addrinfo* list) {
+
+        std::vector<const addrinfo*> preferred, other;
+        for (auto ai = list; ai; ai = ai->ai_next) {
+            (ai->ai_family == list->ai_family ? preferred : other).push_back(ai);
         }
 
-        std::string host = input.substr(0, colonPos);
-        std::string portStr = input.substr(colonPos + 1);
+        std::vector<const addrinfo*> ordered;
+        for (size_t i = 0; i < std::max(preferred.size(), other.size()); ++i) {
+            if (i < preferred.size()) ordered.push_back(preferred[i]);
+            if (i < other.size()) ordered.push_back(other[i]);
+        }
+        return ordered;
+    }
+
+    bool connectInProgress() {
+
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EINPROGRESS;
+#endif
+    }
+
+    // Starts a non-blocking connect, returns INVALID_SOCKET if it failed right away.
+    SOCKET startConnect(const addrinfo* ai, const SocketOptions& options) {
 
-        // Convert port string to uint16_t
-        uint16_t port;
+        SOCKET sock = socket(ai->ai_family, SOCK_STREAM, IPPROTO_TCP);
+        if (sock == INVALID_SOCKET) return INVALID_SOCKET;
+
+        // timestamps are only accepted once connected, see TCPClientContext::connect
+        SocketOptions beforeConnect = options;
+        beforeConnect.timestamps.reset();
         try {
-            port = static_cast<uint16_t>(std::stoi(portStr));
+            applySocketOptions(sock, beforeConnect, true);
         } catch (const std::exception&) {
-            throw std::invalid_argument("Invalid port number.");
+            closeSocket(sock);
+            throw;
+        }
+
+        if (!setNonBlocking(sock)) {
+            closeSocket(sock);
+            return INVALID_SOCKET;
         }
+        if (::connect(sock, ai->ai_addr, static_cast<socklen_t>(ai->ai_addrlen)) == 0 || connectInProgress()) {
+            return sock;// completion (or immediate success) is reported as writable
+        }
+        closeSocket(sock);
+        return INVALID_SOCKET;
+    }
 
-        return std::make_pair(host, port);
+    // Happy Eyeballs (RFC 8305): starts a connection attempt, and starts the next one whenever the previous
+    // attempts failed or did not complete within the attempt delay. The first connection to complete wins.
+    // Returns the connected (blocking) socket, or INVALID_SOCKET if no address could be reached before the deadline.
+    SOCKET connectFirst(const std::vector<const addrinfo*>& addresses, const SocketOptions& options,
+                        std::chrono::steady_clock::time_point deadline) {
+
+        std::vector<pollfd> pending;
+        const auto closePending = [&pending] {
+            for (const auto& p : pending) closeSocket(p.fd);
+            pending.clear();
+        };
+
+        size_t next = 0;
+        auto nextAttempt = std::chrono::steady_clock::now();
+        for (;;) {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) break;
+
+            if (next < addresses.size() && (pending.empty() || now >= nextAttempt)) {
+                SOCKET sock;
+                try {
+                    sock = startConnect(addresses[next++], options);
+                } catch (const std::exception&) {
+                    closePending();
+                    throw;
+                }
+                if (sock != INVALID_SOCKET) {
+                    pollfd pfd{};
+                    pfd.fd = sock;
+                    pfd.events = POLLOUT;
+                    pending.push_back(pfd);
+                    nextAttempt = now + connectionAttemptDelay;
+                }
+                continue;
+            }
+            if (pending.empty()) break;// every address failed
+
+            const auto wakeUp = next < addresses.size() ? std::min(deadline, nextAttempt) : deadline;
+            if (pollSockets(pending.data(), pending.size(), pollTimeout(wakeUp)) < 0) break;
+
+            for (auto it = pending.begin(); it != pending.end();) {
+                if (it->revents == 0) {
+                    ++it;
+                    continue;
+                }
+
+                int error = 0;
+                socklen_t len = sizeof(error);
+                getsockopt(it->fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &len);
+                if (error == 0 && (it->revents & POLLOUT)) {
+                    const SOCKET winner = it->fd;
+                    pending.erase(it);
+                    closePending();
+                    // a non-blocking socket would make the connection's reads and writes fail with EAGAIN
+                    if (!setNonBlocking(winner, false)) {
+                        closeSocket(winner);
+                        return INVALID_SOCKET;
+                    }
+                    return winner;
+                }
+
+                closeSocket(it->fd);
+                it = pending.erase(it);
+                nextAttempt = now;// don't wait out the delay after a failure
+            }
+        }
+
+        closePending();
+        return INVALID_SOCKET;
     }
 
 }// namespace
@@ -56,8 +194,17 @@ namespace {
 
 struct TCPServer::Impl {
 
-    Impl(int port, int backlog)
-        : socket(createSocket()) {
+    Impl(int port, int backlog, bool reusePort, const SocketOptions& options)
+        : socket(createListenSocket(reusePort)), options(options) {
+
+        // buffer sizes have to be in place before the handshake (window scaling), accepted sockets inherit them
+        SocketOptions bufferSizes;
+        bufferSizes.sendBufferSize = options.sendBufferSize;
+        bufferSizes.receiveBufferSize = options.receiveBufferSize;
+        applySocketOptions(socket, bufferSizes, false);
+#ifdef TCP_DEFER_ACCEPT
+        if (options.deferAccept) setSocketOption(socket, IPPROTO_TCP, TCP_DEFER_ACCEPT, *options.deferAccept, "TCP_DEFER_ACCEPT");
+#endif
 
         sockaddr_in serv_addr{};
         serv_addr.sin_family = AF_INET;
@@ -73,42 +220,253 @@ struct TCPServer::Impl {
 
             throwSocketError("Listen failed");
         }
+
+        // acceptors wait in poll(), which close() can interrupt, instead of inside accept()
+        if (!setNonBlocking(socket)) throwSocketError("Failed to make the listener non-blocking");
     }
 
     std::unique_ptr<SimpleConnection> accept() {
-        sockaddr_in client_addr{};
-        socklen_t addrlen = sizeof(client_addr);
-        SOCKET new_sock = ::accept(socket, reinterpret_cast<sockaddr*>(&client_addr), &addrlen);
 
-        if (new_sock == INVALID_SOCKET) {
+        const Acceptor acceptor(*this);
+        for (;;) {
+            const SOCKET new_sock = acceptSocket(false);
+            if (new_sock != INVALID_SOCKET) return wrap(new_sock);
+
+            if (socketOutOfDescriptors()) {
+                backOff();
+                continue;
+            }
+            if (!socketWouldBlock()) throwSocketError("Accept failed");
+            waitAcceptable();
+        }
+    }
 
-            throwSocketError("Accept failed");
+    std::vector<std::unique_ptr<SimpleConnection>> acceptBatch(size_t max) {
+
+        const Acceptor acceptor(*this);
+        std::vector<std::unique_ptr<SimpleConnection>> batch;
+        while (batch.size() < std::max<size_t>(max, 1)) {
+            const SOCKET new_sock = acceptSocket(false);
+            if (new_sock != INVALID_SOCKET) {
+                batch.emplace_back(wrap(new_sock));
+                continue;
+            }
+            if (socketOutOfDescriptors()) {
+                if (!batch.empty()) break;
+                backOff();
+                continue;
+            }
+            if (!socketWouldBlock()) {
+                if (!batch.empty()) break;// report the error on the next call
+                throwSocketError("Accept failed");
+            }
+            if (!batch.empty()) break;// drained
+
+            waitAcceptable();
         }
+        return batch;
+    }
+
+    void attach(Reactor& reactor, AcceptHandler onAccept) {
+
+#ifndef _WIN32
+        if (spareFd < 0) spareFd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+#endif
+        ReactorCallbacks callbacks;
+        callbacks.onReadable = [this, &reactor, onAccept = std::move(onAccept)](SimpleConnection&) {
+            // one readiness event may stand for many connections, take them all (bounded, the reactor calls again)
+            for (size_t i = 0; i < maxAcceptBatch; ++i) {
+                const SOCKET new_sock = acceptSocket(true);
+                if (new_sock == INVALID_SOCKET) {
+                    // the listener stays readable while out of descriptors, returning would have the reactor spin on it
+                    if (socketOutOfDescriptors()) {
+                        if (shedConnection()) continue;
+                        std::this_thread::sleep_for(outOfDescriptorsBackOff);
+                    }
+                    return;// drained, or the peer already gone
+                }
+
+                std::unique_ptr<SimpleConnection> conn;
+                try {
+                    conn = wrap(new_sock);
+                } catch (const std::exception&) {
+                    continue;
+                }
+                auto connCallbacks = onAccept ? onAccept(*conn) : ReactorCallbacks{};
+                reactor.add(std::move(conn), std::move(connCallbacks));
+            }
+        };
+
+        if (!reactor.watch(socket, std::move(callbacks))) {
+
+            throw std::runtime_error("Failed to register server socket with reactor");
+        }
+    }
 
-        return std::make_unique<SocketConnection>(new_sock);
+    Task<std::unique_ptr<AsyncConnection>> asyncAccept(EventLoop& loop) {
+
+        for (;;) {
+            const SOCKET new_sock = acceptSocket(true);
+            if (new_sock != INVALID_SOCKET) co_return std::make_unique<AsyncConnection>(loop, wrap(new_sock));
+
+            if (!socketWouldBlock() || !co_await loop.waitReadable(socket)) throwSocketError("Accept failed");
+        }
     }
 
+    // Wakes up the threads in accept() and acceptBatch() and closes the listener once they all returned,
+    // so none of them is left polling a closed (or by then reused) descriptor.
     void close() {
 
+        std::unique_lock lock(acceptMutex);
+        if (closed.exchange(true)) return;
+        closing.notify_all();
+#ifdef _WIN32
+        shutdown(socket, SD_RECEIVE);
+#else
+        shutdown(socket, SHUT_RD);
+#endif
+        acceptorsDone.wait(lock, [this] { return acceptors == 0; });
         socket.close();
     }
 
+    ~Impl() {
+
+#ifndef _WIN32
+        if (spareFd >= 0) ::close(spareFd);
+#endif
+    }
+
 private:
 #ifdef _WIN32
     WSASession session;
 #endif
 
     SocketConnection socket;
+    SocketOptions options;
+
+    static constexpr size_t maxAcceptBatch = 64;
+    // where shutdown() does not interrupt a poll on the listener, waiting acceptors check for close() this often
+    static constexpr std::chrono::milliseconds closePollInterval{100};
+    // how long to leave the connections queued while out of descriptors before trying again
+    static constexpr std::chrono::milliseconds outOfDescriptorsBackOff{10};
+
+    std::mutex acceptMutex;
+    std::condition_variable acceptorsDone;
+    std::condition_variable closing;
+    size_t acceptors{0};// threads in accept() or acceptBatch()
+    std::atomic_bool closed{false};
+    int spareFd{-1};// reserved for shedding connections in the reactor while out of descriptors
+
+    // Registers the calling thread with close() for the duration of an accept call.
+    struct Acceptor {
+        explicit Acceptor(Impl& impl)
+            : impl(impl) {
+            std::lock_guard lock(impl.acceptMutex);
+            if (impl.closed) throw std::runtime_error("Accept failed: server closed");
+            ++impl.acceptors;
+        }
+
+        ~Acceptor() {
+            {
+                std::lock_guard lock(impl.acceptMutex);
+                --impl.acceptors;
+            }
+            impl.acceptorsDone.notify_all();
+        }
+
+        Impl& impl;
+    };
+
+    // Waits for a pending connection, throws once the server is closed.
+    void waitAcceptable() {
+
+        while (!closed) {
+#ifdef __linux__
+            // shutdown() wakes the poll up
+            const auto deadline = std::chrono::steady_clock::time_point::max();
+#else
+            const auto deadline = std::chrono::steady_clock::now() + closePollInterval;
+#endif
+            const int ready = waitSocket(socket, POLLIN, deadline);
+            if (ready == SOCKET_ERROR) throwSocketError("Accept failed");
+            if (ready > 0) break;
+        }
+        if (closed) throw std::runtime_error("Accept failed: server closed");
+    }
+
+    // Gives other threads a chance to release descriptors instead of retrying accept in a busy loop,
+    // throws once the server is closed.
+    void backOff() {
+
+        std::unique_lock lock(acceptMutex);
+        closing.wait_for(lock, outOfDescriptorsBackOff, [this] { return closed.load(); });
+        if (closed) throw std::runtime_error("Accept failed: server closed");
+    }
+
+    // Frees the spare descriptor to take the oldest queued connection and close it right away, which makes room
+    // in the queue and lets that client know instead of leaving it hanging. Returns false if nothing was shed.
+    bool shedConnection() {
+
+#ifdef _WIN32
+        return false;
+#else
+        if (spareFd < 0) return false;
+        ::close(spareFd);
+        const SOCKET new_sock = ::accept(socket, nullptr, nullptr);
+        if (new_sock != INVALID_SOCKET) closeSocket(new_sock);
+        spareFd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+        return new_sock != INVALID_SOCKET;
+#endif
+    }
+
+    SOCKET acceptSocket(bool nonBlocking) {
+
+        sockaddr_in client_addr{};
+        socklen_t addrlen = sizeof(client_addr);
+#ifdef __linux__
+        // sets the flags in the same call, and never inherits O_NONBLOCK from the listener
+        return ::accept4(socket, reinterpret_cast<sockaddr*>(&client_addr), &addrlen,
+                         SOCK_CLOEXEC | (nonBlocking ? SOCK_NONBLOCK : 0));
+#else
+        const SOCKET new_sock = ::accept(socket, reinterpret_cast<sockaddr*>(&client_addr), &addrlen);
+        // elsewhere accepted sockets inherit the listener's (non-blocking) mode
+        if (new_sock != INVALID_SOCKET && !nonBlocking) setNonBlocking(new_sock, false);
+        return new_sock;
+#endif
+    }
+
+    std::unique_ptr<SimpleConnection> wrap(SOCKET new_sock) const {
+
+        auto conn = std::make_unique<SocketConnection>(new_sock);
+        applySocketOptions(new_sock, options, true);
+
+        return conn;
+    }
 };
 
-TCPServer::TCPServer(uint16_t port, int backlog)
-    : pimpl_(std::make_unique<Impl>(port, backlog)) {}
+TCPServer::TCPServer(uint16_t port, int backlog, bool reusePort, const SocketOptions& options)
+    : pimpl_(std::make_unique<Impl>(port, backlog, reusePort, options)) {}
 
 [[nodiscard]] std::unique_ptr<SimpleConnection> TCPServer::accept() {
 
     return pimpl_->accept();
 }
 
+std::vector<std::unique_ptr<SimpleConnection>> TCPServer::acceptBatch(size_t max) {
+
+    return pimpl_->acceptBatch(max);
+}
+
+void TCPServer::attach(Reactor& reactor, AcceptHandler onAccept) {
+
+    pimpl_->attach(reactor, std::move(onAccept));
+}
+
+Task<std::unique_ptr<AsyncConnection>> TCPServer::asyncAccept(EventLoop& loop) {
+
+    return pimpl_->asyncAccept(loop);
+}
+
 void TCPServer::close() {
 
     pimpl_->close();
@@ -117,36 +475,341 @@ void TCPServer::close() {
 TCPServer::~TCPServer() = default;
 
 
-[[nodiscard]] std::unique_ptr<SimpleConnection> TCPClientContext::connect(const std::string& ip, uint16_t port, bool useTLS) {
+struct TCPServerGroup::Impl {
 
-    SOCKET sock = createSocket();
+    Impl(uint16_t port, size_t numListeners, int backlog, const SocketOptions& options)
+        : numThreads(numListeners == 0 ? std::max(1u, std::thread::hardware_concurrency()) : numListeners) {
 
-    sockaddr_in serv_addr{};
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(port);
+#if defined(__linux__) && defined(SO_REUSEPORT)
+        for (size_t i = 0; i < numThreads; ++i) {
+            listeners.emplace_back(std::make_unique<TCPServer>(port, backlog, true, options));
+        }
+#else
+        listeners.emplace_back(std::make_unique<TCPServer>(port, backlog, false, options));
+#endif
+    }
 
-    if (inet_pton(AF_INET, ip.c_str(), &serv_addr.sin_addr) <= 0) {
+    void start(const std::function<void(std::unique_ptr<SimpleConnection>)>& onAccept) {
+
+        for (size_t i = 0; i < numThreads; ++i) {
+            auto& listener = *listeners[i % listeners.size()];
+            threads.emplace_back([&listener, onAccept] {
+                try {
+                    while (true) {
+                        for (auto& conn : listener.acceptBatch()) {
+                            onAccept(std::move(conn));
+                        }
+                    }
+                } catch (const std::exception&) {
+                    // listener closed
+                }
+            });
+        }
+    }
 
-        // Fallback: resolve hostname
-        addrinfo hints{}, *res = nullptr;
-        hints.ai_family = AF_INET;
-        hints.ai_socktype = SOCK_STREAM;
-        if (getaddrinfo(ip.c_str(), nullptr, &hints, &res) != 0 || !res) {
-            closeSocket(sock);
-            return nullptr;
+    void attach(Reactor& reactor, const AcceptHandler& onAccept) {
+
+        for (auto& listener : listeners) {
+            listener->attach(reactor, onAccept);
+        }
+    }
+
+    void close() {
+
+        for (auto& listener : listeners) {
+            listener->close();
+        }
+        for (auto& t : threads) {
+            if (t.joinable()) t.join();
+        }
+        threads.clear();
+    }
+
+    ~Impl() {
+
+        close();
+    }
+
+    size_t numThreads;
+    std::vector<std::unique_ptr<TCPServer>> listeners;
+    std::vector<std::thread> threads;
+};
+
+TCPServerGroup::TCPServerGroup(uint16_t port, size_t numListeners, int backlog, const SocketOptions& options)
+    : pimpl_(std::make_unique<Impl>(port, numListeners, backlog, options)) {}
+
+void TCPServerGroup::start(std::function<void(std::unique_ptr<SimpleConnection>)> onAccept) {
+
+    pimpl_->start(onAccept);
+}
+
+void TCPServerGroup::attach(Reactor& reactor, const AcceptHandler& onAccept) {
+
+    pimpl_->attach(reactor, onAccept);
+}
+
+size_t TCPServerGroup::size() const {
+
+    return pimpl_->numThreads;
+}
+
+void TCPServerGroup::close() {
+
+    pimpl_->close();
+}
+
+TCPServerGroup::~TCPServerGroup() = default;
+
+
+struct TCPClientContext::Pool {
+
+    struct Idle {
+        std::unique_ptr<SimpleConnection> conn;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    struct Host {
+        std::deque<Idle> idle;// most recently returned at the back
+        size_t open{0};       // idle + checked out
+    };
+
+    // Takes an idle connection (nullptr if none), or reserves a slot for a new one by setting reserved.
+    // Returns false if the per host limit is reached and nothing was returned before the deadline.
+    bool checkout(const std::string& key, std::chrono::steady_clock::time_point deadline,
+                  std::unique_ptr<SimpleConnection>& idleConn, bool& reserved) {
+
+        std::vector<std::unique_ptr<SimpleConnection>> expired;// closed outside the lock
+        std::unique_lock lock(mutex);
+        auto& host = hosts[key];
+        for (;;) {
+            const auto now = std::chrono::steady_clock::now();
+            while (!host.idle.empty() && now - host.idle.front().since > options.idleTimeout) {
+                expired.push_back(std::move(host.idle.front().conn));
+                host.idle.pop_front();
+                --host.open;
+            }
+            if (!host.idle.empty()) {
+                idleConn = std::move(host.idle.back().conn);
+                host.idle.pop_back();
+                return true;
+            }
+            if (options.maxPerHost == 0 || host.open < options.maxPerHost) {
+                ++host.open;
+                reserved = true;
+                return true;
+            }
+            if (cv.wait_until(lock, deadline) == std::cv_status::timeout) return false;
         }
-        serv_addr.sin_addr = reinterpret_cast<sockaddr_in*>(res->ai_addr)->sin_addr;
+    }
+
+    void checkin(const std::string& key, std::unique_ptr<SimpleConnection> conn) {
+
+        {
+            std::lock_guard lock(mutex);
+            auto& host = hosts[key];
+            if (conn && host.idle.size() < options.maxIdlePerHost) {
+                host.idle.push_back({std::move(conn), std::chrono::steady_clock::now()});
+            } else {
+                --host.open;
+            }
+        }
+        cv.notify_one();
+    }
+
+    PoolOptions options;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<std::string, Host> hosts;
+};
+
+namespace {
+
+    // Checked out pool connection, goes back to the pool on destruction unless it is known to be unusable.
+    class PooledConnection: public SimpleConnection {
+    public:
+        // onReturn receives the connection back, or nullptr if it must not be reused
+        PooledConnection(std::unique_ptr<SimpleConnection> conn, std::function<void(std::unique_ptr<SimpleConnection>)> onReturn)
+            : conn_(std::move(conn)), onReturn_(std::move(onReturn)) {}
+
+        using SimpleConnection::readv;
+        using SimpleConnection::writev;
+
+        int read(uint8_t* buffer, size_t size) override {
+            const int n = conn_->read(buffer, size);
+            if (n <= 0 && n != WouldBlock) reusable_ = false;
+            return n;
+        }
+
+        bool write(const uint8_t* data, size_t size) override {
+            return track(conn_->write(data, size));
+        }
+
+        bool writev(std::span<const ConstBuffer> buffers) override {
+            return track(conn_->writev(buffers));
+        }
+
+        int readv(std::span<const MutableBuffer> buffers) override {
+            const int n = conn_->readv(buffers);
+            if (n <= 0 && n != WouldBlock) reusable_ = false;
+            return n;
+        }
+
+        // a read timeout leaves the connection usable, the caller decides whether the exchange can continue
+        IoResult readUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) override {
+            const auto result = conn_->readUntil(buffer, size, deadline);
+            if (result.status == IoStatus::Closed || result.status == IoStatus::Error) reusable_ = false;
+            return result;
+        }
+
+        IoResult writeUntil(const uint8_t* data, size_t size, std::chrono::steady_clock::time_point deadline) override {
+            const auto result = conn_->writeUntil(data, size, deadline);
+            track(static_cast<bool>(result));
+            return result;
+        }
+
+        bool writeOwned(std::vector<uint8_t> data, const ReleaseHandler& onRelease = {}) override {
+            return track(conn_->writeOwned(std::move(data), onRelease));
+        }
+
+        bool enableZeroCopy() override {
+            return conn_->enableZeroCopy();
+        }
+
+        size_t readTxTimestamps(std::span<TxTimestamp> out) override {
+            return conn_->readTxTimestamps(out);
+        }
+
+        void flush() override {
+            conn_->flush();
+        }
+
+        void setMetrics(std::shared_ptr<Metrics> metrics) override {
+            conn_->setMetrics(std::move(metrics));
+        }
+
+        void close() override {
+            reusable_ = false;
+            conn_->close();
+        }
+
+        ~PooledConnection() override {
+            if (!reusable_) conn_.reset();
+            onReturn_(std::move(conn_));
+        }
+
+    private:
+        std::unique_ptr<SimpleConnection> conn_;
+        std::function<void(std::unique_ptr<SimpleConnection>)> onReturn_;
+        bool reusable_{true};
+
+        bool track(bool ok) {
+            if (!ok) reusable_ = false;
+            return ok;
+        }
+    };
+
+    // An idle connection must have nothing to read: pending data is unsolicited, EOF means the peer hung up.
+    bool healthy(SimpleConnection& conn) {
+
+        uint8_t probe;
+        return conn.readUntil(&probe, 1, std::chrono::steady_clock::now()).status == IoStatus::Timeout;
+    }
+
+}// namespace
+
+TCPClientContext::TCPClientContext(const SocketOptions& options)
+    : options_(options), pool_(std::make_shared<Pool>()) {}
+
+TCPClientContext::~TCPClientContext() = default;
+
+void TCPClientContext::setPoolOptions(const PoolOptions& options) {
+
+    std::lock_guard lock(pool_->mutex);
+    pool_->options = options;
+}
+
+std::unique_ptr<SimpleConnection> TCPClientContext::acquire(const std::string& ip, uint16_t port, bool useTLS) {
+
+    const std::string key = ip + ":" + std::to_string(port) + (useTLS ? ":tls" : "");
+    const auto deadline = connectTimeout_.count() > 0
+                                  ? std::chrono::steady_clock::now() + connectTimeout_
+                                  : std::chrono::steady_clock::time_point::max();
+
+    for (;;) {
+        std::unique_ptr<SimpleConnection> conn;
+        bool reserved = false;
+        if (!pool_->checkout(key, deadline, conn, reserved)) return nullptr;
+
+        if (reserved) {
+            try {
+                conn = connect(ip, port, useTLS);
+            } catch (const std::exception&) {
+                pool_->checkin(key, nullptr);
+                throw;
+            }
+            if (!conn) {
+                pool_->checkin(key, nullptr);
+                return nullptr;
+            }
+        } else if (!healthy(*conn)) {
+            pool_->checkin(key, nullptr);
+            continue;
+        }
+        // outstanding connections may outlive the context, they are simply closed then
+        std::weak_ptr<Pool> pool = pool_;
+        return std::make_unique<PooledConnection>(std::move(conn), [pool, key](std::unique_ptr<SimpleConnection> c) {
+            if (const auto p = pool.lock()) p->checkin(key, std::move(c));
+        });
+    }
+}
+
+void TCPClientContext::setConnectTimeout(std::chrono::milliseconds timeout) {
+
+    connectTimeout_ = timeout;
+}
+
+[[nodiscard]] std::unique_ptr<SimpleConnection> TCPClientContext::connect(const std::string& ip, uint16_t port, bool useTLS) {
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_NUMERICSERV;
+
+    addrinfo* res = nullptr;
+    if (getaddrinfo(ip.c_str(), std::to_string(port).c_str(), &hints, &res) != 0 || !res) {
+        return nullptr;
+    }
+
+    const auto deadline = connectTimeout_.count() > 0
+                                  ? std::chrono::steady_clock::now() + connectTimeout_
+                                  : std::chrono::steady_clock::time_point::max();
+    SOCKET sock;
+    try {
+        sock = connectFirst(interleaveFamilies(res), options_, deadline);
+    } catch (const std::exception&) {
         freeaddrinfo(res);
+        throw;
     }
+    freeaddrinfo(res);
 
-    if (::connect(sock, reinterpret_cast<sockaddr*>(&serv_addr), sizeof(serv_addr)) < 0) {
+    if (sock == INVALID_SOCKET) {
 
         return nullptr;
     }
+    if (options_.timestamps) {
+        try {
+            applyTimestamps(sock, *options_.timestamps);
+        } catch (const std::exception&) {
+            closeSocket(sock);
+            throw;
+        }
+    }
     if (useTLS) {
 #ifdef SIMPLE_SOCKET_WITH_TLS
         return std::make_unique<TLSConnection>(sock, ip);
 #else
+        closeSocket(sock);
         throw std::runtime_error("TLS support is not enabled in this build.");
 #endif
     }
@@ -0,0 +1,293 @@
+
+#include "simple_socket/TimerWheel.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace simple_socket;
+
+namespace {
+
+    constexpr size_t levelBits = 8;
+    constexpr size_t slotsPerLevel = size_t(1) << levelBits;
+    constexpr size_t slotMask = slotsPerLevel - 1;
+    constexpr size_t numLevels = 4;
+    constexpr uint64_t maxDelta = (uint64_t(1) << (levelBits * numLevels)) - 1;
+
+    // the first nodes are list heads: one per slot, then the list of timers about to fire
+    constexpr uint32_t firingList = numLevels * slotsPerLevel;
+    constexpr uint32_t firstTimer = firingList + 1;
+
+}// namespace
+
+struct TimerWheel::Impl {
+
+    explicit Impl(std::chrono::milliseconds tick)
+        : tick_(std::max(tick, std::chrono::milliseconds(1))),
+          epoch_(std::chrono::steady_clock::now()),
+          nodes_(firstTimer) {
+
+        for (uint32_t i = 0; i < firstTimer; ++i) nodes_[i].prev = nodes_[i].next = i;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    TimerId schedule(std::chrono::milliseconds delay, std::function<void()> callback) {
+
+        std::unique_lock lock(mutex_);
+        // nothing pending means the wheel may have been idle for a while, catch up without walking the ticks
+        if (pending_ == 0) current_ = std::max(current_, tickAt(std::chrono::steady_clock::now()));
+
+        uint32_t index;
+        if (free_.empty()) {
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        } else {
+            index = free_.back();
+            free_.pop_back();
+        }
+
+        auto& node = nodes_[index];
+        node.active = true;
+        node.callback = std::move(callback);
+        node.expires = deadline(delay);
+        insert(index);
+
+        const bool wake = pending_++ == 0;
+        lock.unlock();
+        if (wake) cv_.notify_all();
+        return idOf(index);
+    }
+
+    bool cancel(TimerId id) {
+
+        std::unique_lock lock(mutex_);
+        if (isPending(id)) {
+            const auto index = static_cast<uint32_t>(id);
+            unlink(index);
+            release(index);
+            return true;
+        }
+        if (running_ == id && std::this_thread::get_id() != thread_.get_id()) {
+            cv_.wait(lock, [&] { return running_ != id; });
+        }
+        return false;
+    }
+
+    bool reschedule(TimerId id, std::chrono::milliseconds delay) {
+
+        std::lock_guard lock(mutex_);
+        if (!isPending(id)) return false;
+
+        const auto index = static_cast<uint32_t>(id);
+        unlink(index);
+        nodes_[index].expires = deadline(delay);
+        insert(index);
+        return true;
+    }
+
+    [[nodiscard]] size_t pending() const {
+        std::lock_guard lock(mutex_);
+        return pending_;
+    }
+
+    ~Impl() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+private:
+    // Linked into a circular, doubly linked list (by index, the vector may grow): a slot or the firing list.
+    struct Node {
+        uint32_t prev{0};
+        uint32_t next{0};
+        uint32_t generation{1};
+        bool active{false};
+        uint64_t expires{0};// tick
+        std::function<void()> callback;
+    };
+
+    const std::chrono::milliseconds tick_;
+    const std::chrono::steady_clock::time_point epoch_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;// new timers, stop, or a callback finished
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    uint64_t current_{0};// next tick to process
+    size_t pending_{0};
+    TimerId running_{0};
+    bool stop_{false};
+
+    std::thread thread_;
+
+    [[nodiscard]] uint64_t tickAt(std::chrono::steady_clock::time_point time) const {
+        return static_cast<uint64_t>((time - epoch_) / tick_);
+    }
+
+    // First tick at or after now + delay.
+    [[nodiscard]] uint64_t deadline(std::chrono::milliseconds delay) const {
+        const auto due = std::chrono::steady_clock::now() - epoch_ + std::max(delay, std::chrono::milliseconds(0));
+        const auto ticks = static_cast<uint64_t>((due + tick_ - std::chrono::nanoseconds(1)) / tick_);
+        return std::max(ticks, current_);
+    }
+
+    [[nodiscard]] TimerId idOf(uint32_t index) const {
+        return (static_cast<uint64_t>(nodes_[index].generation) << 32) | index;
+    }
+
+    [[nodiscard]] bool isPending(TimerId id) const {
+        const auto index = static_cast<uint32_t>(id);
+        return index >= firstTimer && index < nodes_.size() && nodes_[index].active && idOf(index) == id;
+    }
+
+    void link(uint32_t index, uint32_t list) {
+        auto& node = nodes_[index];
+        node.prev = nodes_[list].prev;
+        node.next = list;
+        nodes_[node.prev].next = index;
+        nodes_[list].prev = index;
+    }
+
+    void unlink(uint32_t index) {
+        auto& node = nodes_[index];
+        nodes_[node.prev].next = node.next;
+        nodes_[node.next].prev = node.prev;
+        node.prev = node.next = index;
+    }
+
+    // Moves all timers of list to the (empty) firing list.
+    void spliceToFiring(uint32_t list) {
+        auto& head = nodes_[list];
+        if (head.next == list) return;
+        auto& firing = nodes_[firingList];
+        firing.next = head.next;
+        firing.prev = head.prev;
+        nodes_[head.next].prev = firingList;
+        nodes_[head.prev].next = firingList;
+        head.next = head.prev = list;
+    }
+
+    void release(uint32_t index) {
+        auto& node = nodes_[index];
+        node.active = false;
+        node.callback = nullptr;
+        ++node.generation;
+        free_.push_back(index);
+        --pending_;
+    }
+
+    // Level 0 holds the next 256 ticks one per slot, each further level 256 times coarser.
+    void insert(uint32_t index) {
+        auto& node = nodes_[index];
+        uint64_t delta = node.expires - current_;
+        if (delta > maxDelta) {
+            node.expires = current_ + maxDelta;
+            delta = maxDelta;
+        }
+
+        size_t level = 0;
+        while (delta >= (uint64_t(1) << (levelBits * (level + 1)))) ++level;
+        const size_t slot = (node.expires >> (levelBits * level)) & slotMask;
+        link(index, static_cast<uint32_t>(level * slotsPerLevel + slot));
+    }
+
+    // Redistributes the timers of a coarse slot that has come due over the finer levels.
+    void cascade(size_t level, size_t slot) {
+        const auto list = static_cast<uint32_t>(level * slotsPerLevel + slot);
+        while (nodes_[list].next != list) {
+            const uint32_t index = nodes_[list].next;
+            unlink(index);
+            insert(index);
+        }
+    }
+
+    void advance(std::unique_lock<std::mutex>& lock) {
+
+        const size_t index = current_ & slotMask;
+        if (index == 0) {
+            for (size_t level = 1; level < numLevels; ++level) {
+                const size_t slot = (current_ >> (levelBits * level)) & slotMask;
+                cascade(level, slot);
+                if (slot != 0) break;
+            }
+        }
+        spliceToFiring(static_cast<uint32_t>(index));
+        ++current_;// timers scheduled by the callbacks below land in later ticks
+
+        while (nodes_[firingList].next != firingList) {
+            const uint32_t timer = nodes_[firingList].next;
+            unlink(timer);
+            auto callback = std::move(nodes_[timer].callback);
+            running_ = idOf(timer);
+            release(timer);
+
+            lock.unlock();
+            try {
+                callback();
+            } catch (const std::exception& e) {
+                std::cerr << "Timer callback error: " << e.what() << std::endl;
+            }
+            lock.lock();
+
+            running_ = 0;
+            cv_.notify_all();
+        }
+    }
+
+    void run() {
+
+        std::unique_lock lock(mutex_);
+        while (!stop_) {
+            if (pending_ == 0) {
+                cv_.wait(lock, [&] { return stop_ || pending_ > 0; });
+                continue;
+            }
+
+            const auto now = tickAt(std::chrono::steady_clock::now());
+            while (!stop_ && pending_ > 0 && current_ <= now) advance(lock);
+
+            if (pending_ > 0) cv_.wait_until(lock, epoch_ + tick_ * static_cast<int64_t>(current_));
+        }
+    }
+};
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick)
+    : pimpl_(std::make_unique<Impl>(tick)) {}
+
+TimerWheel::TimerId TimerWheel::schedule(std::chrono::milliseconds delay, std::function<void()> callback) {
+
+    return pimpl_->schedule(delay, std::move(callback));
+}
+
+bool TimerWheel::cancel(TimerId id) {
+
+    return pimpl_->cancel(id);
+}
+
+bool TimerWheel::reschedule(TimerId id, std::chrono::milliseconds delay) {
+
+    return pimpl_->reschedule(id, delay);
+}
+
+size_t TimerWheel::pending() const {
+
+    return pimpl_->pending();
+}
+
+TimerWheel& TimerWheel::shared() {
+
+    // leaked on purpose: connections may cancel their timers during static destruction
+    static auto wheel = new TimerWheel();
+    return *wheel;
+}
+
+TimerWheel::~TimerWheel() = default;
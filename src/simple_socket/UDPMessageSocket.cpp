@@ -0,0 +1,253 @@
+
+#include "simple_socket/UDPMessageSocket.hpp"
+
+#include "simple_socket/util/byte_conversion.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <thread>
+
+using namespace simple_socket;
+
+namespace {
+
+    // Fragment header, big endian:
+    //   magic    u16  rejects datagrams that are not ours
+    //   stride   u16  payload bytes of every fragment but the last, offset / stride is the fragment's index
+    //   id       u32  message id, per sender
+    //   size     u32  message size
+    //   offset   u32  of this fragment's payload in the message
+    constexpr size_t headerSize = 16;
+    constexpr uint16_t magic = 0x554D;// "UM"
+
+    // fragments per sendBatch call
+    constexpr size_t batchSize = 64;
+
+    struct Header {
+        uint16_t stride;
+        uint32_t id;
+        uint32_t size;
+        uint32_t offset;
+    };
+
+    void writeHeader(uint8_t* out, const Header& header) {
+
+        out[0] = magic >> 8;
+        out[1] = magic & 0xFF;
+        out[2] = header.stride >> 8;
+        out[3] = header.stride & 0xFF;
+        std::ranges::copy(encode_uint32(header.id, std::endian::big), out + 4);
+        std::ranges::copy(encode_uint32(header.size, std::endian::big), out + 8);
+        std::ranges::copy(encode_uint32(header.offset, std::endian::big), out + 12);
+    }
+
+    bool readHeader(const uint8_t* in, size_t length, Header& header) {
+
+        if (length < headerSize || (in[0] << 8 | in[1]) != magic) return false;
+        header.stride = static_cast<uint16_t>(in[2] << 8 | in[3]);
+        header.id = decode_uint32(in + 4, std::endian::big);
+        header.size = decode_uint32(in + 8, std::endian::big);
+        header.offset = decode_uint32(in + 12, std::endian::big);
+
+        // the payload has to be exactly the fragment at offset
+        const size_t payload = length - headerSize;
+        return header.stride > 0 && header.size > 0 && header.offset < header.size &&
+               header.offset % header.stride == 0 &&
+               payload == std::min<size_t>(header.stride, header.size - header.offset);
+    }
+
+}// namespace
+
+struct UDPMessageSocket::Impl {
+
+    Impl(UDPSocket& socket, UDPMessageOptions options)
+        : socket_(socket), options_(options),
+          buffer_(MAX_UDP_PACKET_SIZE),
+          nextId_(std::random_device{}()) {
+
+        options_.maxDatagramSize = std::clamp<size_t>(options_.maxDatagramSize, headerSize + 1, MAX_UDP_PACKET_SIZE);
+        options_.maxMessageSize = std::min<size_t>(options_.maxMessageSize, UINT32_MAX);
+    }
+
+    bool send(const Endpoint& to, const uint8_t* data, size_t size) {
+
+        if (size == 0 || size > options_.maxMessageSize) return false;
+
+        const auto stride = static_cast<uint16_t>(options_.maxDatagramSize - headerSize);
+        Header header{stride, nextId_++, static_cast<uint32_t>(size), 0};
+
+        // fragments are assembled in place, a batch at a time
+        thread_local std::vector<uint8_t> scratch;
+        scratch.resize(batchSize * options_.maxDatagramSize);
+        std::array<OutgoingDatagram, batchSize> datagrams;
+
+        // paced sends go out in batches of about a millisecond's worth
+        const size_t rate = options_.maxBytesPerSecond;
+        const size_t batch = rate == 0 ? batchSize : std::clamp<size_t>(rate / 1000 / options_.maxDatagramSize, 1, batchSize);
+        const auto start = std::chrono::steady_clock::now();
+
+        size_t offset = 0;
+        while (offset < size) {
+            if (rate > 0 && offset > 0) {
+                std::this_thread::sleep_until(start + std::chrono::microseconds(offset * 1000000 / rate));
+            }
+
+            size_t count = 0;
+            for (; count < batch && offset < size; ++count) {
+                const size_t length = std::min<size_t>(stride, size - offset);
+                uint8_t* out = scratch.data() + count * options_.maxDatagramSize;
+                header.offset = static_cast<uint32_t>(offset);
+                writeHeader(out, header);
+                std::memcpy(out + headerSize, data + offset, length);
+                datagrams[count] = {out, headerSize + length, to};
+                offset += length;
+            }
+            if (socket_.sendBatch(std::span(datagrams).first(count)) != count) return false;
+        }
+        return true;
+    }
+
+    bool receive(std::vector<uint8_t>& message, Endpoint& from) {
+
+        while (true) {
+            const int length = socket_.recvFromAny(buffer_.data(), buffer_.size(), from);
+            if (length < 0) return false;
+
+            Header header{};
+            if (!readHeader(buffer_.data(), length, header) || header.size > options_.maxMessageSize) continue;
+
+            const auto now = std::chrono::steady_clock::now();
+            evictExpired(now);
+
+            // a single fragment is the whole message
+            if (header.size <= header.stride) {
+                message.assign(buffer_.data() + headerSize, buffer_.data() + length);
+                return true;
+            }
+
+            auto* pending = find(from, header.id);
+            if (!pending) pending = start(from, header, now);
+            if (!pending || pending->stride != header.stride || pending->size != header.size) continue;
+
+            const size_t index = header.offset / header.stride;
+            if (pending->received[index]) continue;// duplicate
+            pending->received[index] = true;
+            pending->lastProgress = now;
+            std::memcpy(pending->data.data() + header.offset, buffer_.data() + headerSize, length - headerSize);
+
+            if (--pending->missing == 0) {
+                message = std::move(pending->data);
+                remove(pending);
+                return true;
+            }
+        }
+    }
+
+    [[nodiscard]] size_t dropped() const {
+        return dropped_;
+    }
+
+private:
+    struct Pending {
+        Endpoint from;
+        uint32_t id{0};
+        uint16_t stride{0};
+        size_t size{0};
+        std::vector<uint8_t> data;
+        std::vector<bool> received;// per fragment
+        size_t missing{0};
+        std::chrono::steady_clock::time_point lastProgress;// arrival of the latest new fragment
+    };
+
+    UDPSocket& socket_;
+    UDPMessageOptions options_;
+
+    std::vector<uint8_t> buffer_;
+    std::atomic<uint32_t> nextId_;
+
+    // incomplete messages, oldest first. Only a handful are in flight at a time, so a linear search will do
+    std::vector<Pending> pending_;
+    size_t pendingBytes_{0};
+    std::chrono::steady_clock::time_point nextSweep_{};
+    std::atomic_size_t dropped_{0};
+
+    Pending* find(const Endpoint& from, uint32_t id) {
+
+        const auto it = std::ranges::find_if(pending_, [&](const Pending& p) {
+            return p.id == id && p.from == from;
+        });
+        return it == pending_.end() ? nullptr : &*it;
+    }
+
+    Pending* start(const Endpoint& from, const Header& header, std::chrono::steady_clock::time_point now) {
+
+        if (header.size > options_.maxPendingBytes) {
+            ++dropped_;
+            return nullptr;
+        }
+        while (!pending_.empty() && pendingBytes_ + header.size > options_.maxPendingBytes) {
+            ++dropped_;
+            remove(&pending_.front());
+        }
+
+        const size_t fragments = (header.size + header.stride - 1) / header.stride;
+        auto& pending = pending_.emplace_back();
+        pending.from = from;
+        pending.id = header.id;
+        pending.stride = header.stride;
+        pending.size = header.size;
+        pending.data.resize(header.size);
+        pending.received.assign(fragments, false);
+        pending.missing = fragments;
+        pending.lastProgress = now;
+        pendingBytes_ += header.size;
+        return &pending;
+    }
+
+    void remove(Pending* pending) {
+
+        pendingBytes_ -= pending->size;
+        pending_.erase(pending_.begin() + (pending - pending_.data()));
+    }
+
+    void evictExpired(std::chrono::steady_clock::time_point now) {
+
+        // often enough to keep the table small, rarely enough to stay off the per datagram path
+        if (now < nextSweep_) return;
+        nextSweep_ = now + options_.reassemblyTimeout / 4;
+
+        const auto expired = [&](const Pending& p) {
+            return now - p.lastProgress > options_.reassemblyTimeout;
+        };
+        for (const auto& p : pending_) {
+            if (expired(p)) {
+                ++dropped_;
+                pendingBytes_ -= p.size;
+            }
+        }
+        std::erase_if(pending_, expired);
+    }
+};
+
+UDPMessageSocket::UDPMessageSocket(UDPSocket& socket, UDPMessageOptions options)
+    : pimpl_(std::make_unique<Impl>(socket, options)) {}
+
+bool UDPMessageSocket::send(const Endpoint& to, const uint8_t* data, size_t size) {
+
+    return pimpl_->send(to, data, size);
+}
+
+bool UDPMessageSocket::receive(std::vector<uint8_t>& message, Endpoint& from) {
+
+    return pimpl_->receive(message, from);
+}
+
+size_t UDPMessageSocket::dropped() const {
+
+    return pimpl_->dropped();
+}
+
+UDPMessageSocket::~UDPMessageSocket() = default;
@@ -1,165 +1,587 @@
 
 #include "simple_socket/UDPSocket.hpp"
 
+#include "simple_socket/SocketConnection.hpp"
 #include "simple_socket/socket_common.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
 using namespace simple_socket;
 
-struct UDPSocket::Impl {
+namespace {
 
-    explicit Impl(int localPort)
-        : sockfd_(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) {
+    // messages per sendmmsg/recvmmsg call
+    constexpr size_t batchSize = 64;
 
-        if (sockfd_ == INVALID_SOCKET) {
+    // datagrams per UDP_SEGMENT send (UDP_MAX_SEGMENTS)
+    constexpr size_t maxSegments = 64;
 
-            throwSocketError("Failed to create socket");
+    bool validSize(size_t size) {
+        return size > 0 && size <= MAX_UDP_PACKET_SIZE;
+    }
+
+    // A connected UDP socket. A datagram can not be sent or received in parts, so buffer lists too long for a
+    // single gather (or scatter) system call go through a contiguous copy instead of several calls.
+    struct DatagramConnection: SocketConnection {
+
+        using SocketConnection::SocketConnection;
+        using SimpleConnection::readv;
+        using SimpleConnection::writev;
+
+        bool writev(std::span<const ConstBuffer> buffers) override {
+
+            if (buffers.size() <= maxIoVecs) return SocketConnection::writev(buffers);
+
+            thread_local std::vector<uint8_t> datagram;
+            datagram.clear();
+            for (const auto& b : buffers) datagram.insert(datagram.end(), b.data, b.data + b.size);
+            return write(datagram.data(), datagram.size());
         }
 
-        sockaddr_in addr{};
-        addr.sin_family = AF_INET;
-        addr.sin_addr.s_addr = INADDR_ANY;
-        addr.sin_port = htons(localPort);
+        int readv(std::span<const MutableBuffer> buffers) override {
+
+            if (buffers.size() <= maxIoVecs) return SocketConnection::readv(buffers);
+
+            size_t capacity = 0;
+            for (const auto& b : buffers) capacity += b.size;
+            // like a scatter read, what does not fit is discarded with the rest of the datagram
+            thread_local std::vector<uint8_t> datagram;
+            datagram.resize(std::min<size_t>(capacity, MAX_UDP_PACKET_SIZE));
+            const int n = read(datagram.data(), datagram.size());
+            if (n <= 0) return n;
+
+            size_t offset = 0;
+            for (const auto& b : buffers) {
+                const size_t length = std::min(b.size, static_cast<size_t>(n) - offset);
+                std::memcpy(b.data, datagram.data() + offset, length);
+                offset += length;
+                if (offset == static_cast<size_t>(n)) break;
+            }
+            return n;
+        }
+    };
 
-        if (::bind(sockfd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) {
+}// namespace
+
+struct UDPSocket::Impl {
 
-            throwSocketError("Bind failed");
+    explicit Impl(int localPort, const SocketOptions& options)
+        : sockfd_(createSocket(family_)) {
+
+        // the descriptor is not owned by anything yet
+        try {
+            applySocketOptions(sockfd_, options, false);
+            applyMulticastOptions(options);
+
+            sockaddr_storage addr{};
+            socklen_t length;
+            if (family_ == AF_INET6) {
+                auto& in6 = reinterpret_cast<sockaddr_in6&>(addr);
+                in6.sin6_family = AF_INET6;
+                in6.sin6_addr = in6addr_any;
+                in6.sin6_port = htons(localPort);
+                length = sizeof(sockaddr_in6);
+            } else {
+                auto& in = reinterpret_cast<sockaddr_in&>(addr);
+                in.sin_family = AF_INET;
+                in.sin_addr.s_addr = INADDR_ANY;
+                in.sin_port = htons(localPort);
+                length = sizeof(sockaddr_in);
+            }
+
+            if (::bind(sockfd_, reinterpret_cast<sockaddr*>(&addr), length) == SOCKET_ERROR) {
+
+                throwSocketError("Bind failed");
+            }
+        } catch (const std::exception&) {
+            closeSocket(sockfd_);
+            throw;
         }
     }
 
-    bool sendTo(const std::string& address, uint16_t port, const std::string& data) const {
+    bool sendTo(const Endpoint& to, const uint8_t* data, size_t size) const {
 
-        if (data.empty() || data.size() > MAX_UDP_PACKET_SIZE) {
+        if (!validSize(size)) {
             return false;
         }
 
-        sockaddr_in to{};
-        to.sin_family = AF_INET;
-        to.sin_port = htons(port);
-        if (!inet_pton(AF_INET, address.c_str(), &to.sin_addr)) {
+        sockaddr_storage addr;
+        const auto length = EndpointAccess::toSockaddr(to, family_, addr);
+        if (length == 0) {
 
             return false;
         }
 
-        return sendto(sockfd_, data.c_str(), data.size(), 0, reinterpret_cast<sockaddr*>(&to), sizeof(to)) != SOCKET_ERROR;
+        return sendto(sockfd_, reinterpret_cast<const char*>(data), size, 0, reinterpret_cast<sockaddr*>(&addr), length) != SOCKET_ERROR;
     }
 
-    bool sendTo(const std::string& address, uint16_t port, const std::vector<unsigned char>& data) const {
+    int recvFrom(uint8_t* buffer, size_t size, Endpoint* from) const {
 
-        return sendTo(address, port, data.data(), data.size());
+        sockaddr_storage addr{};
+        socklen_t length = sizeof(addr);
+
+        const auto receive = recvfrom(sockfd_, reinterpret_cast<char*>(buffer), size, 0, reinterpret_cast<sockaddr*>(&addr), &length);
+        if (receive == SOCKET_ERROR) {
+            return -1;
+        }
+
+        if (from) *from = EndpointAccess::fromSockaddr(addr);
+        return static_cast<int>(receive);
     }
 
-    bool sendTo(const std::string& address, uint16_t port, const unsigned char* data, size_t size) const {
+    // Receives the next datagram from any sender unless the deadline passes first.
+    IoResult recvUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) const {
 
-        if (size == 0 || size > MAX_UDP_PACKET_SIZE) {
-            return false;
+        for (;;) {
+            const int ready = waitSocket(sockfd_, POLLIN, deadline);
+            if (ready == 0) return {IoStatus::Timeout, 0};
+            if (ready == SOCKET_ERROR) return {IoStatus::Error, 0};
+#ifdef _WIN32
+            const auto n = recv(sockfd_, reinterpret_cast<char*>(buffer), static_cast<int>(size), 0);
+#else
+            const auto n = ::recv(sockfd_, buffer, size, MSG_DONTWAIT);
+#endif
+            if (n >= 0) return {IoStatus::Ok, static_cast<size_t>(n)};
+            if (socketWouldBlock()) continue;// another reader took it
+#ifndef _WIN32
+            if (errno == EINTR) continue;
+#endif
+            return {IoStatus::Error, 0};
         }
+    }
 
-        sockaddr_in to{};
-        to.sin_family = AF_INET;
-        to.sin_port = htons(port);
-        if (!inet_pton(AF_INET, address.c_str(), &to.sin_addr)) {
-
-            return false;
+    bool sendSegmented(const Endpoint& to, const uint8_t* data, size_t size, size_t segmentSize) {
+
+        sockaddr_storage addr;
+        const auto addrLength = EndpointAccess::toSockaddr(to, family_, addr);
+        if (size == 0 || !validSize(segmentSize) || addrLength == 0) return false;
+
+        size_t offset = 0;
+#ifdef __linux__
+        if (!gsoUnsupported_) {
+            // one send is limited both in datagrams and in total size
+            const size_t chunk = std::min(maxSegments, MAX_UDP_PACKET_SIZE / segmentSize) * segmentSize;
+
+            while (offset < size) {
+                const size_t length = std::min(chunk, size - offset);
+                iovec iov{const_cast<uint8_t*>(data + offset), length};
+
+                msghdr msg{};
+                msg.msg_name = &addr;
+                msg.msg_namelen = addrLength;
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+
+                alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))]{};
+                if (length > segmentSize) {
+                    msg.msg_control = control;
+                    msg.msg_controllen = sizeof(control);
+                    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+                    cmsg->cmsg_level = IPPROTO_UDP;
+                    cmsg->cmsg_type = UDP_SEGMENT;
+                    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                    const auto gsoSize = static_cast<uint16_t>(segmentSize);
+                    std::memcpy(CMSG_DATA(cmsg), &gsoSize, sizeof(gsoSize));
+                }
+
+                if (sendmsg(sockfd_, &msg, 0) < 0) {
+                    if (errno == EINTR) continue;
+                    // the kernel or the route can not segment, send the rest datagram by datagram from now on
+                    if (errno == EIO || errno == ENOPROTOOPT || errno == EOPNOTSUPP) {
+                        gsoUnsupported_ = true;
+                        break;
+                    }
+                    // segments larger than this route's MTU (EMSGSIZE, EINVAL on older kernels) can still be sent
+                    // one by one, IP fragments them
+                    if (errno == EMSGSIZE || errno == EINVAL) break;
+                    return false;
+                }
+                offset += length;
+            }
+            if (offset == size) return true;
         }
+#endif
 
-        return sendto(sockfd_, reinterpret_cast<const char*>(data), size, 0, reinterpret_cast<sockaddr*>(&to), sizeof(to)) != SOCKET_ERROR;
+        std::array<OutgoingDatagram, batchSize> datagrams;
+        while (offset < size) {
+            size_t count = 0;
+            for (; count < batchSize && offset < size; ++count) {
+                const size_t length = std::min(segmentSize, size - offset);
+                datagrams[count] = {data + offset, length, to};
+                offset += length;
+            }
+            if (sendBatch(std::span(datagrams).first(count)) != count) return false;
+        }
+        return true;
     }
 
-    int recvFrom(const std::string& address, uint16_t port, std::vector<unsigned char>& buffer) const {
-
-        return recvFrom(address, port, buffer.data(), buffer.size());
+#ifdef __linux__
+    size_t sendBatch(std::span<const OutgoingDatagram> datagrams) const {
+
+        std::array<mmsghdr, batchSize> msgs{};
+        std::array<iovec, batchSize> iovs{};
+        std::array<sockaddr_storage, batchSize> addrs;
+
+        size_t sent = 0;
+        while (sent < datagrams.size()) {
+            // up to the next datagram that can not be sent
+            size_t count = 0;
+            while (count < batchSize && sent + count < datagrams.size()) {
+                const auto& datagram = datagrams[sent + count];
+                const auto addrLength = EndpointAccess::toSockaddr(datagram.to, family_, addrs[count]);
+                if (!validSize(datagram.size) || addrLength == 0) break;
+
+                iovs[count].iov_base = const_cast<uint8_t*>(datagram.data);
+                iovs[count].iov_len = datagram.size;
+                msgs[count].msg_hdr = {};
+                msgs[count].msg_hdr.msg_name = &addrs[count];
+                msgs[count].msg_hdr.msg_namelen = addrLength;
+                msgs[count].msg_hdr.msg_iov = &iovs[count];
+                msgs[count].msg_hdr.msg_iovlen = 1;
+                ++count;
+            }
+            if (count == 0) break;
+
+            const int rc = sendmmsg(sockfd_, msgs.data(), static_cast<unsigned int>(count), 0);
+            if (rc < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            sent += rc;
+        }
+        return sent;
     }
 
-    int recvFrom(const std::string& address, uint16_t port, unsigned char* buffer, size_t size) const {
+    int recvBatch(std::span<IncomingDatagram> datagrams) const {
+
+        std::array<mmsghdr, batchSize> msgs{};
+        std::array<iovec, batchSize> iovs{};
+        std::array<sockaddr_storage, batchSize> addrs;
+        // UDP_GRO segment size and SO_TIMESTAMPING
+        struct Control {
+            alignas(cmsghdr) char data[CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(scm_timestamping))];
+        };
+        std::array<Control, batchSize> controls{};
+
+        size_t received = 0;
+        while (received < datagrams.size()) {
+            const size_t count = std::min(batchSize, datagrams.size() - received);
+            for (size_t i = 0; i < count; ++i) {
+                auto& datagram = datagrams[received + i];
+                iovs[i].iov_base = datagram.data;
+                iovs[i].iov_len = datagram.capacity;
+                msgs[i].msg_hdr = {};
+                msgs[i].msg_hdr.msg_name = &addrs[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                msgs[i].msg_hdr.msg_control = controls[i].data;
+                msgs[i].msg_hdr.msg_controllen = sizeof(Control::data);
+            }
+
+            // block for the first datagram only, later calls just drain what is already queued
+            const int flags = received == 0 ? MSG_WAITFORONE : MSG_DONTWAIT;
+            const int rc = recvmmsg(sockfd_, msgs.data(), static_cast<unsigned int>(count), flags, nullptr);
+            if (rc < 0) {
+                if (errno == EINTR && received == 0) continue;
+                if (received > 0) break;
+                return -1;
+            }
+
+            for (int i = 0; i < rc; ++i) {
+                auto& datagram = datagrams[received + i];
+                datagram.size = std::min<size_t>(msgs[i].msg_len, datagram.capacity);
+                datagram.from = EndpointAccess::fromSockaddr(addrs[i]);
+                datagram.truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+                datagram.segmentSize = datagram.size;
+                datagram.timestamp = {};
+                rxTimestampOf(msgs[i].msg_hdr, datagram.timestamp);
+                for (auto cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+                    if (cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+                        int segmentSize;
+                        std::memcpy(&segmentSize, CMSG_DATA(cmsg), sizeof(segmentSize));
+                        datagram.segmentSize = segmentSize;
+                    }
+                }
+            }
+            received += rc;
+            if (static_cast<size_t>(rc) < count) break;
+        }
+        return static_cast<int>(received);
+    }
+#else
+    // one system call per datagram
+    size_t sendBatch(std::span<const OutgoingDatagram> datagrams) const {
+
+        size_t sent = 0;
+        for (const auto& datagram : datagrams) {
+            if (!sendTo(datagram.to, datagram.data, datagram.size)) break;
+            ++sent;
+        }
+        return sent;
+    }
 
-        sockaddr_in from{};
-        from.sin_family = AF_INET;
-        from.sin_port = htons(port);
-        if (!inet_pton(AF_INET, address.c_str(), &from.sin_addr)) {
+    int recvBatch(std::span<IncomingDatagram> datagrams) const {
 
-            return -1;
+        int received = 0;
+        for (auto& datagram : datagrams) {
+            sockaddr_storage from{};
+#ifdef _WIN32
+            // there is no per call non-blocking flag, return after the first datagram
+            if (received > 0) break;
+
+            int fromLength = sizeof(from);
+            const int rc = recvfrom(sockfd_, reinterpret_cast<char*>(datagram.data), static_cast<int>(datagram.capacity), 0, reinterpret_cast<sockaddr*>(&from), &fromLength);
+            datagram.truncated = rc == SOCKET_ERROR && WSAGetLastError() == WSAEMSGSIZE;
+            if (rc == SOCKET_ERROR && !datagram.truncated) return -1;
+            datagram.size = datagram.truncated ? datagram.capacity : rc;
+#else
+            iovec iov{datagram.data, datagram.capacity};
+            msghdr msg{};
+            msg.msg_name = &from;
+            msg.msg_namelen = sizeof(from);
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+
+            const auto rc = recvmsg(sockfd_, &msg, received == 0 ? 0 : MSG_DONTWAIT);
+            if (rc < 0) {
+                if (received > 0) break;
+                return -1;
+            }
+            datagram.size = static_cast<size_t>(rc);
+            datagram.truncated = (msg.msg_flags & MSG_TRUNC) != 0;
+#endif
+            datagram.from = EndpointAccess::fromSockaddr(from);
+            datagram.segmentSize = datagram.size;
+            datagram.timestamp = {};
+            ++received;
         }
-        socklen_t fromLength = sizeof(from);
+        return received;
+    }
+#endif
 
-        const auto receive = recvfrom(sockfd_, reinterpret_cast<char*>(buffer), size, 0, reinterpret_cast<sockaddr*>(&from), &fromLength);
-        if (receive == SOCKET_ERROR) {
-            return -1;
+    size_t readTxTimestamps(std::span<TxTimestamp> out) const {
+
+        size_t count = 0;
+#ifdef __linux__
+        while (count < out.size()) {
+            alignas(cmsghdr) char control[errorQueueControlSize];
+            msghdr msg{};
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if (recvmsg(sockfd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            // anything else on the error queue (e.g. an ICMP error) is of no use here
+            if (txTimestampOf(msg, out[count])) ++count;
         }
+#endif
+        return count;
+    }
+
+    void close() const {
+
+        closeSocket(sockfd_);
+    }
+
+    ~Impl() {
 
-        return receive;
+        close();
     }
 
-    [[nodiscard]] std::string recvFrom(const std::string& address, uint16_t port) const {
+    void setMembership(const std::string& group, unsigned int interfaceIndex, bool join) const {
 
-        sockaddr_in from{};
-        from.sin_family = AF_INET;
-        from.sin_port = htons(port);
-        if (!inet_pton(AF_INET, address.c_str(), &from.sin_addr)) {
+        const Endpoint endpoint(group, 0);
+        if (endpoint.isV6() && family_ != AF_INET6) {
 
-            return "";
+            throw std::invalid_argument("IPv6 is not available for multicast group " + group);
         }
-        socklen_t fromLength = sizeof(from);
 
-        thread_local std::vector<unsigned char> buffer(MAX_UDP_PACKET_SIZE);
+        // protocol independent (RFC 3678), the group in its own family also on a dual stack socket
+        group_req request{};
+        request.gr_interface = interfaceIndex;
+        EndpointAccess::toSockaddr(endpoint, endpoint.isV6() ? AF_INET6 : AF_INET, request.gr_group);
 
-        const auto receive = recvfrom(sockfd_, reinterpret_cast<char*>(buffer.data()), buffer.size(), 0, reinterpret_cast<sockaddr*>(&from), &fromLength);
-        if (receive == SOCKET_ERROR) {
+        const int level = endpoint.isV6() ? IPPROTO_IPV6 : IPPROTO_IP;
+        if (setsockopt(sockfd_, level, join ? MCAST_JOIN_GROUP : MCAST_LEAVE_GROUP, reinterpret_cast<const char*>(&request), sizeof(request)) == SOCKET_ERROR) {
 
-            return "";
+            throwSocketError((join ? "Failed to join multicast group " : "Failed to leave multicast group ") + group);
         }
-
-        return {buffer.begin(), buffer.begin() + receive};
     }
 
-    void close() const {
+    // A dual stack socket sends to IPv4 groups with the IPv4 options, so it gets both, the IPv4 ones where the OS allows.
+    void applyMulticastOptions(const SocketOptions& options) const {
 
-        closeSocket(sockfd_);
+        const bool v6 = family_ == AF_INET6;
+        const auto setV4 = [&](int name, const void* value, socklen_t length, const char* what) {
+            if (setsockopt(sockfd_, IPPROTO_IP, name, static_cast<const char*>(value), length) == SOCKET_ERROR && !v6) {
+                throwSocketError(std::string("Failed to set ") + what);
+            }
+        };
+
+        if (options.multicastTtl) {
+            if (v6) setSocketOption(sockfd_, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, *options.multicastTtl, "IPV6_MULTICAST_HOPS");
+            const int ttl = *options.multicastTtl;
+            setV4(IP_MULTICAST_TTL, &ttl, sizeof(ttl), "IP_MULTICAST_TTL");
+        }
+        if (options.multicastLoop) {
+            if (v6) setSocketOption(sockfd_, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, *options.multicastLoop, "IPV6_MULTICAST_LOOP");
+            const int loop = *options.multicastLoop;
+            setV4(IP_MULTICAST_LOOP, &loop, sizeof(loop), "IP_MULTICAST_LOOP");
+        }
+        if (options.multicastInterface) {
+            const unsigned int index = *options.multicastInterface;
+            if (v6) setSocketOption(sockfd_, IPPROTO_IPV6, IPV6_MULTICAST_IF, static_cast<int>(index), "IPV6_MULTICAST_IF");
+#if defined(__linux__)
+            ip_mreqn request{};
+            request.imr_ifindex = static_cast<int>(index);
+            setV4(IP_MULTICAST_IF, &request, sizeof(request), "IP_MULTICAST_IF");
+#elif defined(_WIN32)
+            const DWORD value = htonl(index);// an index in place of the address: 0.0.0.index
+            setV4(IP_MULTICAST_IF, &value, sizeof(value), "IP_MULTICAST_IF");
+#elif defined(IP_MULTICAST_IFINDEX)
+            setV4(IP_MULTICAST_IFINDEX, &index, sizeof(index), "IP_MULTICAST_IFINDEX");
+#endif
+        }
     }
 
-    ~Impl() {
+    // Dual stack IPv6 where available, so that one socket reaches both IPv4 and IPv6 endpoints.
+    static SOCKET createSocket(int& family) {
+
+        SOCKET sock = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock != INVALID_SOCKET) {
+            const int v6only = 0;
+            if (setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&v6only), sizeof(v6only)) != SOCKET_ERROR) {
+                family = AF_INET6;
+                return sock;
+            }
+            closeSocket(sock);
+        }
 
-        close();
+        family = AF_INET;
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock == INVALID_SOCKET) {
+
+            throwSocketError("Failed to create socket");
+        }
+        return sock;
     }
 
 private:
 #ifdef _WIN32
     WSASession session_;
 #endif
+    int family_{AF_INET6};
     SOCKET sockfd_;
+    std::atomic_bool gsoUnsupported_{false};
 };
 
 
-UDPSocket::UDPSocket(int localPort)
-    : pimpl_(std::make_unique<Impl>(localPort)) {}
+UDPSocket::UDPSocket(int localPort, const SocketOptions& options)
+    : pimpl_(std::make_unique<Impl>(localPort, options)) {}
+
+bool UDPSocket::sendTo(const Endpoint& to, const uint8_t* data, size_t size) {
+
+    return pimpl_->sendTo(to, data, size);
+}
+
+bool UDPSocket::sendTo(const Endpoint& to, const std::vector<uint8_t>& data) {
+
+    return pimpl_->sendTo(to, data.data(), data.size());
+}
+
+bool UDPSocket::sendTo(const Endpoint& to, const std::string& data) {
+
+    return pimpl_->sendTo(to, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
 
 bool UDPSocket::sendTo(const std::string& address, uint16_t remotePort, const std::string& data) {
 
-    return pimpl_->sendTo(address, remotePort, data);
+    return sendTo(address, remotePort, reinterpret_cast<const uint8_t*>(data.data()), data.size());
 }
 
 bool UDPSocket::sendTo(const std::string& address, uint16_t remotePort, const std::vector<unsigned char>& data) {
 
-    return pimpl_->sendTo(address, remotePort, data);
+    return sendTo(address, remotePort, data.data(), data.size());
 }
 
 bool UDPSocket::sendTo(const std::string& address, uint16_t remotePort, const unsigned char* data, size_t size) {
 
-    return pimpl_->sendTo(address, remotePort, data, size);
+    Endpoint to;
+    if (!EndpointAccess::parse(address, remotePort, to)) {
+
+        return false;
+    }
+
+    return pimpl_->sendTo(to, data, size);
+}
+
+int UDPSocket::recvFromAny(uint8_t* buffer, size_t size, Endpoint& from) {
+
+    return pimpl_->recvFrom(buffer, size, &from);
+}
+
+int UDPSocket::recvFromAny(std::vector<uint8_t>& buffer, Endpoint& from) {
+
+    return pimpl_->recvFrom(buffer.data(), buffer.size(), &from);
+}
+
+int UDPSocket::recvFrom(const std::string&, uint16_t, std::vector<unsigned char>& buffer) {
+
+    return pimpl_->recvFrom(buffer.data(), buffer.size(), nullptr);
+}
+
+int UDPSocket::recvFrom(const std::string&, uint16_t, unsigned char* buffer, size_t size) {
+
+    return pimpl_->recvFrom(buffer, size, nullptr);
+}
+
+std::string UDPSocket::recvFrom(const std::string&, uint16_t) {
+
+    thread_local std::vector<unsigned char> buffer(MAX_UDP_PACKET_SIZE);
+
+    const auto receive = pimpl_->recvFrom(buffer.data(), buffer.size(), nullptr);
+    if (receive < 0) {
+
+        return "";
+    }
+
+    return {buffer.begin(), buffer.begin() + receive};
+}
+
+size_t UDPSocket::sendBatch(std::span<const OutgoingDatagram> datagrams) {
+
+    return pimpl_->sendBatch(datagrams);
+}
+
+bool UDPSocket::sendSegmented(const Endpoint& to, const uint8_t* data, size_t size, size_t segmentSize) {
+
+    return pimpl_->sendSegmented(to, data, size, segmentSize);
+}
+
+int UDPSocket::recvBatch(std::span<IncomingDatagram> datagrams) {
+
+    return pimpl_->recvBatch(datagrams);
 }
 
-int UDPSocket::recvFrom(const std::string& address, uint16_t remotePort, std::vector<unsigned char>& buffer) {
+size_t UDPSocket::readTxTimestamps(std::span<TxTimestamp> out) {
 
-    return pimpl_->recvFrom(address, remotePort, buffer);
+    return pimpl_->readTxTimestamps(out);
 }
 
-int UDPSocket::recvFrom(const std::string& address, uint16_t remotePort, unsigned char* buffer, size_t size) {
+void UDPSocket::joinGroup(const std::string& group, unsigned int interfaceIndex) {
 
-    return pimpl_->recvFrom(address, remotePort, buffer, size);
+    pimpl_->setMembership(group, interfaceIndex, true);
 }
 
-std::string UDPSocket::recvFrom(const std::string& address, uint16_t remotePort) {
+void UDPSocket::leaveGroup(const std::string& group, unsigned int interfaceIndex) {
 
-    return pimpl_->recvFrom(address, remotePort);
+    pimpl_->setMembership(group, interfaceIndex, false);
 }
 
 void UDPSocket::close() {
@@ -169,21 +591,30 @@ void UDPSocket::close() {
 
 std::unique_ptr<SimpleConnection> UDPSocket::makeConnection(const std::string& address, uint16_t remotePort) {
 
+    return makeConnection(Endpoint(address, remotePort));
+}
+
+std::unique_ptr<SimpleConnection> UDPSocket::makeConnection(const Endpoint& remote) {
+
     struct UDPConnection: SimpleConnection {
 
         UDPSocket* socket;
-        std::string address;
-        uint16_t port;
+        Endpoint remote;
 
-        explicit UDPConnection(UDPSocket* sock, std::string address, uint16_t port)
-            : socket(sock), address(std::move(address)), port(port) {}
+        explicit UDPConnection(UDPSocket* sock, const Endpoint& remote)
+            : socket(sock), remote(remote) {}
 
         int read(unsigned char* buffer, size_t size) override {
-            return socket->recvFrom(address, port, buffer, size);
+            Endpoint from;
+            return socket->recvFromAny(buffer, size, from);
+        }
+
+        IoResult readUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) override {
+            return socket->pimpl_->recvUntil(buffer, size, deadline);
         }
 
         bool write(const unsigned char* data, size_t size) override {
-            return socket->sendTo(address, port, data, size);
+            return socket->sendTo(remote, data, size);
         }
 
         void close() override {
@@ -191,7 +622,57 @@ std::unique_ptr<SimpleConnection> UDPSocket::makeConnection(const std::string& a
         }
     };
 
-    return std::make_unique<UDPConnection>(this, address, remotePort);
+    return std::make_unique<UDPConnection>(this, remote);
 }
 
 UDPSocket::~UDPSocket() = default;
+
+UDPClientContext::UDPClientContext(const SocketOptions& options)
+    : options_(options) {}
+
+std::unique_ptr<SimpleConnection> UDPClientContext::connect(const Endpoint& remote, uint16_t localPort) {
+
+    const int family = remote.isV6() ? AF_INET6 : AF_INET;
+    SOCKET sockfd = socket(family, SOCK_DGRAM, IPPROTO_UDP);
+    if (sockfd == INVALID_SOCKET) {
+
+        throwSocketError("Failed to create socket");
+    }
+
+    try {
+        applySocketOptions(sockfd, options_, false);
+    } catch (const std::exception&) {
+        closeSocket(sockfd);
+        throw;
+    }
+
+    // the local address of the same family, any interface
+    sockaddr_storage local;
+    const auto localLength = EndpointAccess::toSockaddr(Endpoint(remote.isV6() ? "::" : "0.0.0.0", localPort), family, local);
+    sockaddr_storage addr;
+    const auto length = EndpointAccess::toSockaddr(remote, family, addr);
+
+    if (::bind(sockfd, reinterpret_cast<sockaddr*>(&local), localLength) == SOCKET_ERROR ||
+        ::connect(sockfd, reinterpret_cast<sockaddr*>(&addr), length) == SOCKET_ERROR) {
+
+        closeSocket(sockfd);
+        return nullptr;
+    }
+
+    return std::make_unique<DatagramConnection>(sockfd);
+}
+
+std::unique_ptr<SimpleConnection> UDPClientContext::connect(const std::string& host) {
+
+    const auto [address, port] = parseHostPort(host);
+
+    Endpoint remote;
+    if (!EndpointAccess::parse(address, port, remote)) {
+        try {
+            remote = Endpoint::resolve(address, port);
+        } catch (const std::runtime_error&) {
+            return nullptr;
+        }
+    }
+    return connect(remote, 0);
+}
@@ -66,6 +66,26 @@ struct UnixDomainServer::Impl {
         return std::make_unique<SocketConnection>(new_sock);
     }
 
+    void attach(Reactor& reactor, AcceptHandler onAccept) {
+
+        ReactorCallbacks callbacks;
+        callbacks.onReadable = [this, &reactor, onAccept = std::move(onAccept)](SimpleConnection&) {
+            std::unique_ptr<SimpleConnection> conn;
+            try {
+                conn = accept();
+            } catch (const std::exception&) {
+                return;// spurious wakeup or peer already gone
+            }
+            auto connCallbacks = onAccept ? onAccept(*conn) : ReactorCallbacks{};
+            reactor.add(std::move(conn), std::move(connCallbacks));
+        };
+
+        if (!reactor.watch(socket, std::move(callbacks))) {
+
+            throw std::runtime_error("Failed to register server socket with reactor");
+        }
+    }
+
     void close() {
 
         socket.close();
@@ -88,6 +108,11 @@ private:
 UnixDomainServer::UnixDomainServer(const std::string& domain, int backlog)
        : pimpl_(std::make_unique<Impl>(domain, backlog)) {}
 
+void UnixDomainServer::attach(Reactor& reactor, AcceptHandler onAccept) {
+
+    pimpl_->attach(reactor, std::move(onAccept));
+}
+
 void UnixDomainServer::close() {
 
     pimpl_->close();
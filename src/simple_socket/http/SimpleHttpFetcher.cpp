@@ -1,5 +1,6 @@
 
 #include "simple_socket/http/SimpleHttpFetcher.hpp"
+#include "simple_socket/BufferedConnection.hpp"
 #include "simple_socket/TCPSocket.hpp"
 #include "simple_socket/util/string_utils.hpp"
 
@@ -120,39 +121,17 @@ namespace {
         return h;
     }
 
-    bool readMore(auto& connection, std::vector<uint8_t>& stash) {
-        uint8_t tmp[4096];
-        const int n = connection->read(tmp, sizeof(tmp));
-        if (n <= 0) return false;
-        stash.insert(stash.end(), tmp, tmp + n);
+    bool readLineCRLF(BufferedConnection& connection, std::string& line) {
+        line.clear();
+        if (!connection.readUntil("\r\n", line)) return false;
+        line.resize(line.size() - 2);
         return true;
     }
 
-    bool readLineCRLF(auto& connection, std::vector<uint8_t>& stash, size_t& off, std::string& line) {
-        for (;;) {
-            constexpr char delimiter[] = "\r\n";
-            auto it = std::search(stash.begin() + off, stash.end(), std::begin(delimiter), std::end(delimiter) - 1);
-            if (it != stash.end()) {
-                const size_t idx = static_cast<size_t>(it - stash.begin());
-                line.assign(reinterpret_cast<const char*>(&stash[off]), idx - off);
-                off = idx + 2;
-                return true;
-            }
-            if (!readMore(connection, stash)) return false;
-        }
-    }
-
-    bool ensureN(auto& connection, std::vector<uint8_t>& stash, size_t need) {
-        while (stash.size() < need) {
-            if (!readMore(connection, stash)) return false;
-        }
-        return true;
-    }
-
-    bool decodeChunked(auto& connection, std::vector<uint8_t>& stash, size_t& off, std::vector<uint8_t>& out) {
+    bool decodeChunked(BufferedConnection& connection, std::vector<uint8_t>& out) {
         for (;;) {
             std::string sizeLine;
-            if (!readLineCRLF(connection, stash, off, sizeLine)) return false;
+            if (!readLineCRLF(connection, sizeLine)) return false;
             // strip chunk extensions
             const size_t sc = sizeLine.find(';');
             const std::string hex = (sc == std::string::npos) ? sizeLine : sizeLine.substr(0, sc);
@@ -164,17 +143,16 @@ namespace {
                 // consume trailer headers until empty line
                 std::string trailer;
                 do {
-                    if (!readLineCRLF(connection, stash, off, trailer)) return false;
+                    if (!readLineCRLF(connection, trailer)) return false;
                 } while (!trailer.empty());
                 return true;
             }
-            // ensure chunk bytes + CRLF are present
-            if (!ensureN(connection, stash, off + chunkSize + 2)) return false;
-            out.insert(out.end(), stash.begin() + off, stash.begin() + off + chunkSize);
-            off += chunkSize;
-            // consume CRLF after chunk
-            if (!(stash[off] == '\r' && stash[off + 1] == '\n')) return false;
-            off += 2;
+            // chunk bytes followed by CRLF
+            const size_t off = out.size();
+            out.resize(off + chunkSize);
+            if (!connection.readExact(out.data() + off, chunkSize)) return false;
+            uint8_t crlf[2];
+            if (!connection.readExact(crlf, 2) || crlf[0] != '\r' || crlf[1] != '\n') return false;
         }
     }
 
@@ -184,8 +162,73 @@ namespace {
                hostHeader + "\r\n"
                             "User-Agent: SimpleSocket/1.0\r\n"
                             "Accept: */*\r\n"
-                            "Accept-Encoding: identity\r\n"
-                            "Connection: close\r\n\r\n";
+                            "Accept-Encoding: identity\r\n\r\n";
+    }
+
+    int statusCode(const std::string& headerBlock) {
+        // HTTP/1.1 200 OK
+        const size_t sp = headerBlock.find(' ');
+        if (sp == std::string::npos) return 0;
+        try {
+            return std::stoi(headerBlock.substr(sp + 1, 3));
+        } catch (...) { return 0; }
+    }
+
+    // Reads one response from the connection. responded is set once the headers arrived,
+    // keepAlive tells whether the connection may carry another request afterwards.
+    std::optional<std::vector<uint8_t>> readResponse(BufferedConnection& connection, bool& responded, bool& keepAlive) {
+
+        // Read headers; body bytes that arrive with them stay in the buffer
+        std::string headerBlock;
+        do {
+            // skip interim (1xx) responses
+            headerBlock.clear();
+            if (!connection.readUntil("\r\n\r\n", headerBlock)) return std::nullopt;
+            responded = true;
+        } while (statusCode(headerBlock) / 100 == 1);
+
+        const auto headers = parseHeaders(headerBlock.substr(0, headerBlock.size() - 4));
+        const auto itTE = headers.find("transfer-encoding");
+        const auto itCL = headers.find("content-length");
+        const auto itConn = headers.find("connection");
+        const std::string connectionHeader = itConn != headers.end() ? toLower(itConn->second) : "";
+        keepAlive = headerBlock.rfind("HTTP/1.0", 0) == 0
+                            ? connectionHeader.find("keep-alive") != std::string::npos
+                            : connectionHeader.find("close") == std::string::npos;
+
+        // No body
+        const int status = statusCode(headerBlock);
+        if (status == 204 || status == 304) {
+            return std::vector<uint8_t>{};
+        }
+
+        // Handle chunked
+        if (itTE != headers.end() && toLower(itTE->second).find("chunked") != std::string::npos) {
+            std::vector<uint8_t> out;
+            if (!decodeChunked(connection, out)) return std::nullopt;
+            return out;
+        }
+
+        // Handle Content-Length
+        if (itCL != headers.end()) {
+            size_t want = 0;
+            try {
+                want = std::stoull(itCL->second);
+            } catch (...) { return std::nullopt; }
+            std::vector<uint8_t> body(want);
+            if (want > 0 && !connection.readExact(body.data(), body.size())) return std::nullopt;
+            return body;
+        }
+
+        // Fallback: read until EOF, which also ends the connection
+        keepAlive = false;
+        std::vector<uint8_t> body;
+        std::vector<uint8_t> buf(4096);
+        int n;
+        while ((n = connection.read(buf.data(), buf.size())) > 0) {
+            body.insert(body.end(), buf.begin(), buf.begin() + n);
+        }
+        return body;
     }
 
 }// namespace
@@ -205,80 +248,29 @@ std::optional<std::vector<uint8_t>> SimpleHttpFetcher::fetchBytes(const std::str
     auto [host, port, tls] = parseHostPort(url);
     const std::string path = extractPath(url);
 
-    auto connection = context.connect(host, port, tls);
-
     std::string hostHeader = bracketIfIpv6(host);
     if (!isDefaultPort(tls, port)) hostHeader += ":" + std::to_string(port);
 
     const std::string request = makeHttpRequest(path, hostHeader);
 
-    if (!connection->write(request.c_str(), request.size())) return std::nullopt;
-
-    // Read headers
-    std::string headerAccum;
-    std::vector<uint8_t> stash;
-    stash.reserve(8192);
-    for (;;) {
-        // Try to find CRLFCRLF in headerAccum
-        const size_t sep = headerAccum.find("\r\n\r\n");
-        if (sep != std::string::npos) {
-            // Copy any body bytes already received after headers
-            std::vector<uint8_t> body;
-            const size_t rem = headerAccum.size() - (sep + 4);
-            if (rem) body.insert(body.end(),
-                                 reinterpret_cast<const uint8_t*>(headerAccum.data() + sep + 4),
-                                 reinterpret_cast<const uint8_t*>(headerAccum.data() + sep + 4) + rem);
-            // Parse headers
-            const auto headers = parseHeaders(headerAccum.substr(0, sep));
-            const auto itTE = headers.find("transfer-encoding");
-            const auto itCL = headers.find("content-length");
-
-            // If we already have more unread raw bytes in stash (from mixing string/bytes), append them
-            if (!stash.empty()) body.insert(body.end(), stash.begin(), stash.end());
-
-            // Handle chunked
-            if (itTE != headers.end() && toLower(itTE->second).find("chunked") != std::string::npos) {
-                // Move body into stash for unified parsing
-                stash = std::move(body);
-                size_t off = 0;
-                std::vector<uint8_t> out;
-                if (!decodeChunked(connection, stash, off, out)) return std::nullopt;
-                return out;
-            }
+    // A pooled connection may have been closed by the server right as we reused it,
+    // so a request that failed before any response arrived is retried once.
+    for (int attempt = 0; attempt < 2; ++attempt) {
 
-            // Handle Content-Length
-            if (itCL != headers.end()) {
-                size_t want = 0;
-                try {
-                    want = std::stoull(itCL->second);
-                } catch (...) { return std::nullopt; }
-                if (body.size() < want) {
-                    std::vector<uint8_t> buf(4096);
-                    while (body.size() < want) {
-                        const size_t need = want - body.size();
-                        const int n = connection->read(buf.data(), static_cast<int>(std::min(buf.size(), need)));
-                        if (n <= 0) return std::nullopt;
-                        body.insert(body.end(), buf.begin(), buf.begin() + n);
-                    }
-                } else if (body.size() > want) {
-                    body.resize(want);
-                }
-                return body;
-            }
+        auto tcp = context.acquire(host, port, tls);
+        if (!tcp) return std::nullopt;
+        BufferedConnection connection(std::move(tcp));
 
-            // Fallback: read until EOF (Connection: close)
-            std::vector<uint8_t> buf(4096);
-            int n;
-            while ((n = connection->read(buf.data(), static_cast<int>(buf.size()))) > 0) {
-                body.insert(body.end(), buf.begin(), buf.begin() + n);
-            }
-            return body;
+        bool responded = false;
+        bool keepAlive = false;
+        std::optional<std::vector<uint8_t>> body;
+        if (connection.write(request.c_str(), request.size())) {
+            body = readResponse(connection, responded, keepAlive);
         }
 
-        // Need more header bytes
-        uint8_t buf[4096];
-        const int n = connection->read(buf, sizeof(buf));
-        if (n <= 0) return std::nullopt;
-        headerAccum.append(reinterpret_cast<const char*>(buf), n);
+        // back to the pool only if the response ended exactly where we stopped reading
+        if (!body || !keepAlive || connection.buffered() != 0) connection.close();
+        if (body || responded) return body;
     }
+    return std::nullopt;
 }
@@ -3,6 +3,7 @@
 
 #include "simple_socket/TCPSocket.hpp"
 #include "simple_socket/modbus/modbus_helper.hpp"
+#include "simple_socket/socket_common.hpp"
 
 #include <stdexcept>
 
@@ -158,7 +159,7 @@ struct ModbusClient::Impl {
         return validate_write_response(response, address, size);
     }
 
-    TCPClientContext ctx;
+    TCPClientContext ctx{noDelayOptions()};
     std::unique_ptr<SimpleConnection> conn;
 
     uint16_t next_transaction_id_ = 1;
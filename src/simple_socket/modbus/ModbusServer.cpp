@@ -1,11 +1,17 @@
 
 #include "simple_socket/modbus/ModbusServer.hpp"
 
+#include "simple_socket/BufferPool.hpp"
+#include "simple_socket/BufferedConnection.hpp"
+#include "simple_socket/Metrics.hpp"
 #include "simple_socket/TCPSocket.hpp"
 #include "simple_socket/modbus/HoldingRegister.hpp"
+#include "simple_socket/socket_common.hpp"
 
 #include <array>
+#include <chrono>
 #include <iostream>
+#include <span>
 #include <thread>
 
 using namespace simple_socket;
@@ -22,7 +28,7 @@ namespace {
         connection.write(response);
     }
 
-    void processRequest(SimpleConnection& conn, const std::vector<uint8_t>& request, HoldingRegister& reg) {
+    void processRequest(SimpleConnection& conn, std::span<const uint8_t> request, HoldingRegister& reg) {
         const int8_t headerSize = 6;
         const uint8_t functionCode = request[headerSize + 1];
         const uint16_t startAddress = (request[headerSize + 2] << 8) | request[headerSize + 3];
@@ -35,24 +41,30 @@ namespace {
                     return;
                 }
 
-                // Prepare response: MBAP header + PDU
-                std::vector response(request.begin(), request.begin() + 4);
+                // A byte count larger than 250 can not be represented (max 125 registers per request)
+                if (quantity > 125) {
+                    sendException(conn, request[headerSize + 0], functionCode, 0x03);// Illegal Data Value
+                    return;
+                }
+
+                // Prepare response: MBAP header + PDU header, followed by the register values
                 const uint16_t length = 3 + (quantity * 2);// Length of PDU
-                response.push_back(length >> 8);           // Length (High)
-                response.push_back(length & 0xFF);         // Length (Low)
-                response.push_back(request[6]);            // Unit Identifier
-
-                // PDU
-                response.push_back(functionCode);// Function Code
-                response.push_back(quantity * 2);// Byte Count
-                // Append register values to the response
+                const std::array<uint8_t, 9> header{
+                        request[0], request[1], request[2], request[3],// Transaction + Protocol Identifier
+                        static_cast<uint8_t>(length >> 8),             // Length (High)
+                        static_cast<uint8_t>(length & 0xFF),           // Length (Low)
+                        request[6],                                    // Unit Identifier
+                        functionCode,                                  // Function Code
+                        static_cast<uint8_t>(quantity * 2)};           // Byte Count
+
+                std::array<uint8_t, 250> values{};
                 for (uint16_t i = 0; i < quantity; ++i) {
                     const uint16_t regValue = reg.getUint16(startAddress + i);
-                    response.push_back(regValue >> 8);
-                    response.push_back(regValue & 0xFF);
+                    values[i * 2] = regValue >> 8;
+                    values[i * 2 + 1] = regValue & 0xFF;
                 }
 
-                conn.write(response);
+                conn.writev({ConstBuffer(header), ConstBuffer(values.data(), quantity * 2)});
                 break;
             }
 
@@ -66,8 +78,7 @@ namespace {
                 reg.setUint16(startAddress, valueToWrite);
 
                 // Echo back the same request as a confirmation
-                const std::vector response(request.begin(), request.end());
-                conn.write(response);
+                conn.write(request);
                 break;
             }
 
@@ -90,13 +101,15 @@ namespace {
                 }
 
                 // Prepare response (Echo start address and quantity of registers written)
-                std::vector response(request.begin(), request.begin() + 6);// Copy MBAP header
-                response.push_back(request[headerSize + 1]);               // Unit Identifier
-                response.push_back(functionCode);                          // Function Code
-                response.push_back(startAddress >> 8);                     // Starting Address (High byte)
-                response.push_back(startAddress & 0xFF);                   // Starting Address (Low byte)
-                response.push_back(quantity >> 8);                         // Quantity of Registers (High byte)
-                response.push_back(quantity & 0xFF);                       // Quantity of Registers (Low byte)
+                const std::array<uint8_t, 12> response{
+                        request[0], request[1], request[2], request[3],// Transaction + Protocol Identifier
+                        0x00, 0x06,                                    // Length: Unit Identifier + 5 byte PDU
+                        request[headerSize],                           // Unit Identifier
+                        functionCode,                                  // Function Code
+                        static_cast<uint8_t>(startAddress >> 8),       // Starting Address (High byte)
+                        static_cast<uint8_t>(startAddress & 0xFF),     // Starting Address (Low byte)
+                        static_cast<uint8_t>(quantity >> 8),           // Quantity of Registers (High byte)
+                        static_cast<uint8_t>(quantity & 0xFF)};        // Quantity of Registers (Low byte)
 
                 conn.write(response);
                 break;
@@ -113,13 +126,16 @@ namespace {
 struct ModbusServer::Impl {
 
     Impl(uint16_t port, HoldingRegister& reg)
-        : server_(port), register_(&reg) {}
+        : server_(port, 1, false, noDelayOptions()), register_(&reg) {}
 
     void start() {
         thread_ = std::thread([this] {
             try {
                 while (!stop_) {
-                    auto conn = server_.accept();
+                    auto tcp = server_.accept();
+                    tcp->setMetrics(metrics_);
+                    // the MBAP header and the PDU are read separately, let one read serve both
+                    auto conn = std::make_unique<BufferedConnection>(std::move(tcp));
                     clients_.emplace_back(&Impl::clientThread, this, std::move(conn));
                 }
             } catch (const std::exception&) {}
@@ -131,27 +147,43 @@ struct ModbusServer::Impl {
         server_.close();
     }
 
+    [[nodiscard]] MetricsSnapshot metrics() const {
+        return metrics_->snapshot();
+    }
+
     void clientThread(std::unique_ptr<SimpleConnection> conn) {
 
-        std::array<uint8_t, 6> mbap{};
-        std::vector<uint8_t> request;
+        constexpr size_t mbapSize = 6;
+        std::array<uint8_t, mbapSize> mbap{};
         while (!stop_) {
 
-            if (!conn->readExact(mbap)) {
+            // Wait for the next request in short slices, so that stop() is noticed without closing the socket under us
+            const auto first = conn->readFor(mbap.data(), 1, pollInterval);
+            if (first.status == IoStatus::Timeout) continue;
+            if (!first) break;// connection closed or failed
+
+            // Once a request has started, the rest of it must arrive in time
+            const auto deadline = std::chrono::steady_clock::now() + requestTimeout;
+            if (!conn->readExactUntil(mbap.data() + 1, mbap.size() - 1, deadline)) {
                 std::cerr << "Error reading request or connection closed\n";
-                break;// Exit the loop if there’s an error or the connection is closed
+                break;
             }
 
             // Extract the length from the MBAP header (bytes 4 and 5)
             // Length field specifies the number of bytes following the Unit Identifier
             const uint16_t length = (mbap[4] << 8) | mbap[5];
 
-            // The total frame length is the 7 bytes MBAP header + the length in MBAP (following Unit Identifier)
-            request.resize(length);// Resize request to fit the full frame (MBAP + Modbus request)
-            conn->readExact(request);
+            // The full frame (MBAP header + the length in MBAP) in a pooled buffer, the PDU is read in behind the header
+            auto request = BufferPool::shared().acquire(mbapSize + length);
+            std::copy(mbap.begin(), mbap.end(), request.begin());
+            if (!conn->readExactUntil(request.data() + mbapSize, length, deadline)) {
+                std::cerr << "Error reading request or connection closed\n";
+                break;
+            }
 
-            request.insert(request.begin(), mbap.begin(), mbap.end());
+            metrics_->add(Metrics::Counter::MessagesIn);
             processRequest(*conn, request, *register_);
+            metrics_->add(Metrics::Counter::MessagesOut);// every request is answered, possibly with an exception
         }
     }
 
@@ -163,12 +195,17 @@ struct ModbusServer::Impl {
     }
 
 private:
+    static constexpr std::chrono::milliseconds pollInterval{100};
+    static constexpr std::chrono::seconds requestTimeout{5};
+
     TCPServer server_;
     HoldingRegister* register_;
 
-    std::atomic_bool stop_;
+    std::atomic_bool stop_{false};
     std::thread thread_;
     std::vector<std::thread> clients_;
+
+    std::shared_ptr<Metrics> metrics_ = std::make_shared<Metrics>();
 };
 
 ModbusServer::ModbusServer(HoldingRegister& reg, uint16_t port)
@@ -182,4 +219,8 @@ void ModbusServer::stop() {
     pimpl_->stop();
 }
 
+MetricsSnapshot ModbusServer::metrics() const {
+    return pimpl_->metrics();
+}
+
 ModbusServer::~ModbusServer() = default;
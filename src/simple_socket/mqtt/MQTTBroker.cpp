@@ -1,7 +1,12 @@
 
 #include "simple_socket/mqtt/MQTTBroker.hpp"
 
+#include "simple_socket/AsyncWriter.hpp"
+#include "simple_socket/BufferPool.hpp"
+#include "simple_socket/BufferedConnection.hpp"
+#include "simple_socket/Metrics.hpp"
 #include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/TimerWheel.hpp"
 #include "simple_socket/mqtt/mqtt_common.hpp"
 
 #ifdef SIMPLE_SOCKET_WITH_WEBSOCKETS
@@ -9,9 +14,13 @@
 #include "simple_socket/mqtt/WsMqttWrapper.hpp"
 #endif
 
+#include <array>
+#include <chrono>
 #include <iostream>
 #include <mutex>
 #include <optional>
+#include <span>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -24,11 +33,11 @@ using namespace simple_socket;
 struct MQTTBroker::Impl {
 
     explicit Impl(int port)
-        : server_(port), stop_(false) {}
+        : server_(port, backlog, false, serverOptions()), stop_(false) {}
 
 #ifdef SIMPLE_SOCKET_WITH_WEBSOCKETS
     explicit Impl(int port, int wsPort)
-        : server_(port), ws_(wsPort), stop_(false) {}
+        : server_(port, backlog, false, serverOptions()), ws_(wsPort), stop_(false) {}
 #endif
 
     void start() {
@@ -48,11 +57,41 @@ struct MQTTBroker::Impl {
 #endif
     }
 
+    [[nodiscard]] MetricsSnapshot metrics() const {
+        return metrics_->snapshot();
+    }
+
 private:
+    static constexpr std::chrono::milliseconds pollInterval{100};
+    static constexpr std::chrono::seconds connectTimeout{10};
+    static constexpr std::chrono::seconds packetTimeout{10};
+
+    static constexpr int backlog = 128;// room for reconnect storms
+
+    // QoS 0 allows dropping messages, which beats holding up everyone else for a subscriber that does not keep up
+    static WriteQueueOptions writeQueueOptions() {
+        WriteQueueOptions options;
+        options.highWatermark = 1024 * 1024;
+        options.lowWatermark = 256 * 1024;
+        options.overflow = OverflowPolicy::DropOldest;
+        return options;
+    }
+
+    static SocketOptions serverOptions() {
+        SocketOptions options;
+        options.noDelay = true;
+        // clients speak first (CONNECT), don't wake the acceptor for connections that have not
+        options.deferAccept = 5;
+        return options;
+    }
+
     struct Client {
         std::unique_ptr<SimpleConnection> conn;
+        std::unique_ptr<AsyncWriter> writer;// all packets to the client, declared after conn so it stops first
         std::string clientId;
         std::unordered_set<std::string> topics;
+        std::chrono::milliseconds idleTimeout{0};// none if the client asked for no keepalive
+        TimerWheel::TimerId idleTimer{0};
     };
 
 #ifdef SIMPLE_SOCKET_WITH_WEBSOCKETS
@@ -65,8 +104,22 @@ private:
     std::thread listener_;
     std::thread wsListener_;
 
+    std::shared_ptr<Metrics> metrics_ = std::make_shared<Metrics>();
+
+    void count(Metrics::Counter counter) {
+        metrics_->add(counter);
+    }
+
+    // heterogeneous lookup, so a PUBLISH finds its subscribers without copying the topic
+    struct TopicHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view topic) const {
+            return std::hash<std::string_view>{}(topic);
+        }
+    };
+
     std::mutex subsMutex_;
-    std::unordered_map<std::string, std::vector<Client*>> subscribers_;
+    std::unordered_map<std::string, std::vector<Client*>, TopicHash, std::equal_to<>> subscribers_;
     std::vector<Client*> clients_;
 
 #ifdef SIMPLE_SOCKET_WITH_WEBSOCKETS
@@ -112,14 +165,16 @@ private:
 
         while (!stop_) {
             try {
-                auto conn = server_.accept();
-
-                auto client = std::make_unique<Client>();
-                client->conn = std::move(conn);
-                Client* clientPtr = client.get();
-                clients_.push_back(clientPtr);
-
-                std::thread(&Impl::handleClient, this, std::move(client)).detach();
+                for (auto& conn : server_.acceptBatch()) {
+                    conn->setMetrics(metrics_);
+                    auto client = std::make_unique<Client>();
+                    // packets are parsed a few bytes at a time, serve those from a buffer
+                    client->conn = std::make_unique<BufferedConnection>(std::move(conn));
+                    Client* clientPtr = client.get();
+                    clients_.push_back(clientPtr);
+
+                    std::thread(&Impl::handleClient, this, std::move(client)).detach();
+                }
             } catch (std::exception&) {
                 break;
             }
@@ -128,14 +183,17 @@ private:
 
     void handleClient(std::unique_ptr<Client> c) {
         try {
-            // CONNECT
+            // CONNECT, which a peer that never speaks MQTT must not be able to hold off forever
+            const auto connectDeadline = std::chrono::steady_clock::now() + connectTimeout;
             uint8_t header = 0;
-            if (!c->conn->readExact(&header, 1)) return;
+            if (!c->conn->readExactUntil(&header, 1, connectDeadline)) return;
             if (header != CONNECT) return;// CONNECT must be 0x10
+            count(Metrics::Counter::MessagesIn);
 
-            size_t remLen = decodeRemainingLength(c->conn.get());
-            std::vector<uint8_t> payload(remLen);
-            if (remLen > 0 && !c->conn->readExact(payload.data(), payload.size())) return;
+            const auto remLen = readRemainingLength(c->conn.get(), connectDeadline);
+            if (!remLen) return;
+            std::vector<uint8_t> payload(*remLen);
+            if (*remLen > 0 && !c->conn->readExactUntil(payload.data(), payload.size(), connectDeadline)) return;
 
             // Parse CONNECT variable header + payload safely
             size_t pos = 0;
@@ -144,7 +202,8 @@ private:
             pos += 2;
             if (pos + protoLen + 4 > payload.size()) return;// name + level + flags + keepalive
             pos += protoLen;                                // skip protocol name
-            pos += 4;                                       // skip level(1), flags(1), keepalive(2)
+            const uint16_t keepAlive = (static_cast<uint16_t>(payload[pos + 2]) << 8) | payload[pos + 3];
+            pos += 4;// skip level(1), flags(1), keepalive(2)
 
             if (pos + 2 > payload.size()) return;
             uint16_t cidLen = (static_cast<uint16_t>(payload[pos]) << 8) | payload[pos + 1];
@@ -153,8 +212,18 @@ private:
             c->clientId.assign(reinterpret_cast<char*>(payload.data() + pos), cidLen);
 
             // CONNACK
-            const std::vector<uint8_t> connack = {CONNACK, 0x02, 0x00, 0x00};
-            if (!c->conn->write(connack)) return;
+            c->writer = std::make_unique<AsyncWriter>(*c->conn, writeQueueOptions());
+            const std::array<uint8_t, 4> connack = {CONNACK, 0x02, 0x00, 0x00};
+            count(Metrics::Counter::MessagesOut);
+            if (!c->writer->writeAsync(connack)) return;
+
+            // a client silent for one and a half keepalive periods is gone (MQTT 3.1.1, 3.1.2.10)
+            if (keepAlive > 0) {
+                c->idleTimeout = std::chrono::milliseconds(keepAlive * 1500);
+                c->idleTimer = TimerWheel::shared().schedule(c->idleTimeout, [conn = c->conn.get()] {
+                    conn->close();// the client loop notices and cleans up
+                });
+            }
 
             // Main loop
             clientLoop(c.get());
@@ -166,7 +235,7 @@ private:
         }
     }
 
-    void handlePublish(Client* c, uint8_t hdr, std::vector<uint8_t>& buf) {
+    void handlePublish(Client* c, uint8_t hdr, std::span<const uint8_t> buf) {
         size_t p = 0;
 
         // Topic length
@@ -174,7 +243,7 @@ private:
         uint16_t tlen = (static_cast<uint16_t>(buf[p]) << 8) | buf[p + 1];
         p += 2;
         if (p + tlen > buf.size()) return;
-        std::string topic(reinterpret_cast<const char*>(&buf[p]), tlen);
+        const std::string_view topic(reinterpret_cast<const char*>(&buf[p]), tlen);
         p += tlen;
 
         // QoS from fixed header
@@ -188,34 +257,31 @@ private:
         }
 
         if (p > buf.size()) return;
-        std::string message(reinterpret_cast<const char*>(&buf[p]), buf.size() - p);
 
         {
             std::lock_guard lock(subsMutex_);
-            if (subscribers_.empty() || !subscribers_.contains(topic)) return;
+            if (subscribers_.empty() || subscribers_.find(topic) == subscribers_.end()) return;
         }
 
-        // Build QoS 0 PUBLISH to subscribers
-        auto packetTopic = encodeShortString(topic);
-        std::vector<uint8_t> pl;
-        pl.reserve(packetTopic.size() + message.size());
-        pl.insert(pl.end(), packetTopic.begin(), packetTopic.end());
-        pl.insert(pl.end(), message.begin(), message.end());
-
-        std::vector<uint8_t> packet;
-        packet.reserve(1 + 4 + pl.size());
-        packet.push_back(PUBLISH);// 0x30 (QoS0)
-        auto len = encodeRemainingLength(pl.size());
-        packet.insert(packet.end(), len.begin(), len.end());
-        packet.insert(packet.end(), pl.begin(), pl.end());
-
+        // Forward as QoS 0 PUBLISH: fixed header, then topic (with length prefix) and message straight from the received buffer
+        const size_t topicBytes = 2 + tlen;
+        const size_t messageBytes = buf.size() - p;
+        uint8_t fixedHeader[5];
+        const size_t headerBytes = encodeFixedHeader(PUBLISH, topicBytes + messageBytes, fixedHeader);
+        const ConstBuffer packet[] = {
+                {fixedHeader, headerBytes},
+                {buf.data(), topicBytes},
+                {buf.data() + p, messageBytes}};
+
+        // only queued here, a slow subscriber can not hold up the others (or the lock)
         std::lock_guard lock(subsMutex_);
         for (auto it = subscribers_.begin(); it != subscribers_.end();) {
             if (it->first == topic) {
                 auto& subs = it->second;
                 bool erased = false;
                 for (auto* sub : subs) {
-                    if (!sub->conn->write(packet)) {
+                    count(Metrics::Counter::MessagesOut);
+                    if (!sub->writer->writeAsync(packet)) {
                         it = subscribers_.erase(it);
                         erased = true;
                         break;// exit inner loop
@@ -228,7 +294,7 @@ private:
         }
     }
 
-    void handleSubscriber(Client* c, uint8_t hdr, std::vector<uint8_t>& buf, bool& running) {
+    void handleSubscriber(Client* c, uint8_t hdr, std::span<const uint8_t> buf, bool& running) {
 
 
         size_t p = 0;
@@ -250,11 +316,12 @@ private:
         }
 
         // SUBACK echoing Packet Identifier, grant QoS 0
-        const std::vector<uint8_t> suback = {
+        const std::array<uint8_t, 5> suback = {
                 SUBACK, 0x03,
                 static_cast<uint8_t>(pid >> 8), static_cast<uint8_t>(pid & 0xFF),
                 0x00};
-        if (!c->conn->write(suback)) {
+        count(Metrics::Counter::MessagesOut);
+        if (!c->writer->writeAsync(suback)) {
             running = false;
         }
     }
@@ -262,11 +329,20 @@ private:
     void clientLoop(Client* c) {
         bool running = true;
         while (running && !stop_) {
+            // Wait for the next packet in short slices, so that stop() is noticed promptly
             uint8_t hdr = 0;
-            if (!c->conn->readExact(&hdr, 1)) break;
-            size_t rem = decodeRemainingLength(c->conn.get());
-            std::vector<uint8_t> buf(rem);
-            if (rem > 0 && !c->conn->readExact(buf.data(), rem)) break;
+            const auto first = c->conn->readFor(&hdr, 1, pollInterval);
+            if (first.status == IoStatus::Timeout) continue;
+            if (!first) break;
+
+            // Once a packet has started, the rest of it must arrive in time
+            const auto deadline = std::chrono::steady_clock::now() + packetTimeout;
+            const auto rem = readRemainingLength(c->conn.get(), deadline);
+            if (!rem) break;
+            auto buf = BufferPool::shared().acquire(*rem);
+            if (*rem > 0 && !c->conn->readExactUntil(buf.data(), buf.size(), deadline)) break;
+            count(Metrics::Counter::MessagesIn);
+            if (c->idleTimer) TimerWheel::shared().reschedule(c->idleTimer, c->idleTimeout);
 
             const auto typeNibble = static_cast<uint8_t>(hdr & 0xF0);
             const auto flagsNibble = static_cast<uint8_t>(hdr & 0x0F);
@@ -302,18 +378,20 @@ private:
                     }
 
                     // UNSUBACK echoing Packet Identifier
-                    const std::vector<uint8_t> unsuback = {
+                    const std::array<uint8_t, 4> unsuback = {
                             UNSUBACK, 0x02,
                             static_cast<uint8_t>(pid >> 8), static_cast<uint8_t>(pid & 0xFF)};
-                    if (!c->conn->write(unsuback)) {
+                    count(Metrics::Counter::MessagesOut);
+                    if (!c->writer->writeAsync(unsuback)) {
                         running = false;
                     }
                 } break;
 
                 case PINGREQ: {
                     if (flagsNibble != 0x00) break;
-                    const std::vector<uint8_t> pingresp = {PINGRESP, 0x00};
-                    if (!c->conn->write(pingresp)) {
+                    const std::array<uint8_t, 2> pingresp = {PINGRESP, 0x00};
+                    count(Metrics::Counter::MessagesOut);
+                    if (!c->writer->writeAsync(pingresp)) {
                         running = false;
                     }
                 } break;
@@ -330,11 +408,15 @@ private:
     }
 
     void cleanupClient(Client& c) {
+        // waits if the timer is closing the connection right now, it must be done with it before c goes away
+        if (c.idleTimer) TimerWheel::shared().cancel(c.idleTimer);
+
         std::lock_guard lock(subsMutex_);
         for (auto& topic : c.topics) {
             auto& vec = subscribers_[topic];
             std::erase(vec, &c);
         }
+        if (c.writer) c.writer->close();
         c.conn->close();
     }
 };
@@ -356,6 +438,10 @@ void MQTTBroker::stop() {
     pimpl_->stop();
 }
 
+MetricsSnapshot MQTTBroker::metrics() const {
+    return pimpl_->metrics();
+}
+
 MQTTBroker::~MQTTBroker() {
     stop();
 }
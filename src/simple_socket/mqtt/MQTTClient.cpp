@@ -1,9 +1,14 @@
 
 #include "simple_socket/mqtt/MQTTClient.hpp"
 
+#include "simple_socket/BufferedConnection.hpp"
 #include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/TimerWheel.hpp"
 #include "simple_socket/mqtt/mqtt_common.hpp"
+#include "simple_socket/socket_common.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <stdexcept>
 #include <thread>
@@ -15,7 +20,6 @@ using namespace simple_socket;
 
 namespace {
 
-
     void connackHandler(SimpleConnection* conn) {
 
         // Robust CONNACK handling
@@ -74,18 +78,21 @@ namespace {
 
 struct MQTTClient::Impl {
 
-    Impl(std::string host, int port, std::string clientId)
-        : clientId_(std::move(clientId)), host_(std::move(host)), port_(port) {}
+    Impl(std::string host, int port, std::string clientId, std::chrono::seconds keepAlive)
+        : keepAlive_(keepAlive), clientId_(std::move(clientId)), host_(std::move(host)), port_(port) {}
 
     void connect(bool tls) {
 
-        conn_ = ctx_.connect(host_, port_, tls);
+        auto conn = ctx_.connect(host_, port_, tls);
+        if (!conn) throw std::runtime_error("MQTTClient: failed to connect to " + host_);
+        // packets are parsed a few bytes at a time, serve those from a buffer
+        conn_ = std::make_unique<BufferedConnection>(std::move(conn));
 
         std::vector<uint8_t> payload = encodeShortString("MQTT");// protocol name
         payload.push_back(0x04);                                 // version 3.1.1
         payload.push_back(0x02);                                 // flags: clean session
-        payload.push_back(0x00);                                 // keepalive MSB
-        payload.push_back(0x3C);                                 // keepalive LSB = 60 sec
+        payload.push_back(static_cast<uint8_t>(keepAlive_.count() >> 8));  // keepalive MSB
+        payload.push_back(static_cast<uint8_t>(keepAlive_.count() & 0xFF));// keepalive LSB
 
         auto cid = encodeShortString(clientId_);
         payload.insert(payload.end(), cid.begin(), cid.end());
@@ -95,7 +102,7 @@ struct MQTTClient::Impl {
         packet.insert(packet.end(), len.begin(), len.end());
         packet.insert(packet.end(), payload.begin(), payload.end());
 
-        conn_->write(packet);
+        write(packet);
 
         connackHandler(conn_.get());
     }
@@ -118,7 +125,7 @@ struct MQTTClient::Impl {
         packet.insert(packet.end(), len.begin(), len.end());
         packet.insert(packet.end(), payload.begin(), payload.end());
 
-        conn_->write(packet);
+        write(packet);
 
         std::lock_guard lock(mutex_);
         callbacks_.emplace(topic, callback);
@@ -144,7 +151,7 @@ struct MQTTClient::Impl {
         packet.insert(packet.end(), len.begin(), len.end());
         packet.insert(packet.end(), payload.begin(), payload.end());
 
-        conn_->write(packet);
+        write(packet);
 
         std::lock_guard lock(mutex_);
         callbacks_.erase(topic);
@@ -157,17 +164,16 @@ struct MQTTClient::Impl {
             throw std::runtime_error("MQTTClient: not connected");
         }
 
-        auto t = encodeShortString(topic);
-        std::vector<uint8_t> payload;
-        payload.insert(payload.end(), t.begin(), t.end());
-        payload.insert(payload.end(), message.begin(), message.end());
-
-        std::vector<uint8_t> packet = {PUBLISH};
-        auto len = encodeRemainingLength(payload.size());
-        packet.insert(packet.end(), len.begin(), len.end());
-        packet.insert(packet.end(), payload.begin(), payload.end());
+        const uint8_t topicLength[2] = {static_cast<uint8_t>(topic.size() >> 8), static_cast<uint8_t>(topic.size() & 0xFF)};
+        uint8_t fixedHeader[5];
+        const size_t headerBytes = encodeFixedHeader(PUBLISH, 2 + topic.size() + message.size(), fixedHeader);
 
-        conn_->write(packet);
+        const ConstBuffer packet[] = {
+                {fixedHeader, headerBytes},
+                {topicLength, 2},
+                ConstBuffer(topic),
+                ConstBuffer(message)};
+        writev(packet);
     }
 
     void run() {
@@ -176,6 +182,9 @@ struct MQTTClient::Impl {
             throw std::runtime_error("MQTTClient: not connected");
         }
 
+        lastReceived_ = std::chrono::steady_clock::now();
+        if (keepAlive_.count() > 0) schedulePing();
+
         thread_ = std::thread([this] {
             while (!stop_) {
                 // Fixed header: byte 1
@@ -185,6 +194,7 @@ struct MQTTClient::Impl {
                 size_t remLen = decodeRemainingLength(conn_.get());
                 std::vector<uint8_t> payload(remLen);
                 if (remLen > 0 && !conn_->readExact(payload.data(), payload.size())) break;
+                lastReceived_ = std::chrono::steady_clock::now();
 
                 const uint8_t packetType = header1 & 0xF0;
                 const uint8_t flags = header1 & 0x0F;
@@ -251,23 +261,34 @@ struct MQTTClient::Impl {
     void close() {
 
         stop_ = true;
-        if (thread_.joinable()) {
-            thread_.join();
-        }
+        while (const auto timer = pingTimer_.exchange(0)) TimerWheel::shared().cancel(timer);
 
+        // closing first wakes the reader, which otherwise waits for the next packet from the broker
         if (conn_) {
             std::vector<uint8_t> packet = {DISCONNECT, 0x00};
-            conn_->write(packet);
+            write(packet);
             conn_->close();
         }
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
     }
 
 private:
-    TCPClientContext ctx_;
+    const std::chrono::seconds keepAlive_;
+
+    TCPClientContext ctx_{noDelayOptions()};
     std::unique_ptr<SimpleConnection> conn_;
 
     std::thread thread_;
     std::mutex mutex_;
+    std::mutex writeMutex_;// packets are written from the caller's threads and the keepalive timer
+
+    std::atomic<std::chrono::steady_clock::time_point> lastSent_{};
+    std::atomic<std::chrono::steady_clock::time_point> lastReceived_{};
+    std::atomic<std::chrono::steady_clock::time_point> pingSent_{};// unanswered PINGREQ, if any
+    std::atomic<TimerWheel::TimerId> pingTimer_{0};
 
     std::atomic_bool stop_{false};
     std::unordered_map<std::string, std::function<void(std::string)>> callbacks_;
@@ -275,10 +296,55 @@ private:
     std::string clientId_;
     std::string host_;
     int port_;
+
+    bool write(const std::vector<uint8_t>& packet) {
+        std::lock_guard lock(writeMutex_);
+        lastSent_ = std::chrono::steady_clock::now();
+        return conn_->write(packet);
+    }
+
+    bool writev(std::span<const ConstBuffer> packet) {
+        std::lock_guard lock(writeMutex_);
+        lastSent_ = std::chrono::steady_clock::now();
+        return conn_->writev(packet);
+    }
+
+    // Checks twice per keepalive period. Sends a PINGREQ when nothing was sent for half of it (the broker has to hear
+    // from us) or nothing was received (a publish-only client hears nothing otherwise), and gives up on a broker
+    // that has not sent anything back within half a period of the PINGREQ.
+    void schedulePing() {
+        const auto interval = std::chrono::duration_cast<std::chrono::milliseconds>(keepAlive_) / 2;
+        pingTimer_ = TimerWheel::shared().schedule(interval, [this, interval] {
+            if (stop_) return;
+            const auto now = std::chrono::steady_clock::now();
+            const auto pingSent = pingSent_.load();
+            if (pingSent != std::chrono::steady_clock::time_point{} && lastReceived_.load() < pingSent) {
+                if (now - pingSent >= interval) {
+                    conn_->close();// the reader stops
+                    return;
+                }
+            } else if (now - lastSent_.load() >= interval || now - lastReceived_.load() >= interval) {
+                // the timer thread must not queue up behind a busy writer, the next check tries again
+                std::unique_lock lock(writeMutex_, std::try_to_lock);
+                if (lock.owns_lock()) {
+                    const uint8_t ping[] = {PINGREQ, 0x00};
+                    // nor wait for the send buffer to drain, that would hold up every other timer; a broker that
+                    // can not take two bytes right now is not reading, so the ping fails and closes the connection
+                    if (!conn_->writeUntil(ping, sizeof(ping), now)) {
+                        conn_->close();
+                        return;
+                    }
+                    lastSent_ = now;
+                    pingSent_ = now;
+                }
+            }
+            if (!stop_) schedulePing();
+        });
+    }
 };
 
-MQTTClient::MQTTClient(const std::string& host, int port, const std::string& clientId)
-    : pimpl_(std::make_unique<Impl>(host, port, clientId)) {}
+MQTTClient::MQTTClient(const std::string& host, int port, const std::string& clientId, std::chrono::seconds keepAlive)
+    : pimpl_(std::make_unique<Impl>(host, port, clientId, keepAlive)) {}
 
 void MQTTClient::connect(bool tls) {
     pimpl_->connect(tls);
@@ -8,6 +8,7 @@
 #include "simple_socket/ws/WebSocket.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstring>
 #include <deque>
@@ -21,9 +22,19 @@ namespace simple_socket {
         explicit WsWrapper(WebSocketConnection* c): connection(c) {}
 
         int read(uint8_t* buffer, size_t size) override {
+            const auto result = readUntil(buffer, size, std::chrono::steady_clock::time_point::max());
+            return result ? static_cast<int>(result.bytes) : -1;
+        }
+
+        IoResult readUntil(uint8_t* buffer, size_t size, std::chrono::steady_clock::time_point deadline) override {
             std::unique_lock lock(m_);
-            cv_.wait(lock, [&] { return closed_ || !queue_.empty(); });
-            if (queue_.empty()) return -1;// closed and no data
+            const auto ready = [&] { return closed_ || !queue_.empty(); };
+            if (deadline == std::chrono::steady_clock::time_point::max()) {
+                cv_.wait(lock, ready);
+            } else if (!cv_.wait_until(lock, deadline, ready)) {
+                return {IoStatus::Timeout, 0};
+            }
+            if (queue_.empty()) return {IoStatus::Closed, 0};// closed and no data
 
             std::string msg = std::move(queue_.front());
             queue_.pop_front();
@@ -36,7 +47,7 @@ namespace simple_socket {
                 queue_.push_front(msg.substr(toCopy));
             }
 
-            return static_cast<int>(toCopy);
+            return {IoStatus::Ok, toCopy};
         }
 
         bool write(const uint8_t* data, size_t size) override {
@@ -2,6 +2,10 @@
 #ifndef SIMPLE_SOCKET_MQTT_HPP
 #define SIMPLE_SOCKET_MQTT_HPP
 
+#include "simple_socket/SimpleConnection.hpp"
+
+#include <chrono>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -42,12 +46,26 @@ namespace simple_socket {
         return bytes;
     }
 
-    inline size_t decodeRemainingLength(SimpleConnection* conn) {
+    // Writes the fixed header (packet type + remaining length) into out[5], returning its size.
+    inline size_t encodeFixedHeader(uint8_t type, size_t remainingLength, uint8_t* out) {
+        size_t n = 0;
+        out[n++] = type;
+        do {
+            uint8_t byte = remainingLength % 128;
+            remainingLength /= 128;
+            if (remainingLength > 0) byte |= 128;
+            out[n++] = byte;
+        } while (remainingLength > 0 && n < 5);
+        return n;
+    }
+
+    // Reads the variable length "remaining length" field; empty if the connection failed or the deadline passed.
+    inline std::optional<size_t> readRemainingLength(SimpleConnection* conn, std::chrono::steady_clock::time_point deadline) {
         size_t remLen = 0;
         size_t multiplier = 1;
         for (int i = 0; i < 4; ++i) {
             uint8_t enc = 0;
-            if (!conn->readExact(&enc, 1)) return 0;
+            if (!conn->readExactUntil(&enc, 1, deadline)) return std::nullopt;
             remLen += static_cast<size_t>(enc & 0x7F) * multiplier;
             if ((enc & 0x80) == 0) break;
             multiplier *= 128;
@@ -55,6 +73,10 @@ namespace simple_socket {
         return remLen;
     }
 
+    inline size_t decodeRemainingLength(SimpleConnection* conn) {
+        return readRemainingLength(conn, std::chrono::steady_clock::time_point::max()).value_or(0);
+    }
+
 }// namespace simple_socket
 
 #endif//MQTT_HPP
@@ -1,8 +1,18 @@
-
 #ifndef SIMPLE_SOCKET_COMMON_HPP
 #define SIMPLE_SOCKET_COMMON_HPP
 
+#include "simple_socket/Endpoint.hpp"
+#include "simple_socket/SimpleConnection.hpp"
+#include "simple_socket/SocketOptions.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <system_error>
+#include <utility>
 
 #ifdef _WIN32
 #include "WSASession.hpp"
@@ -10,13 +20,35 @@
 #include <ws2tcpip.h>
 #else
 #include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
-#include <netdb.h>
 using SOCKET = int;
 #define INVALID_SOCKET (SOCKET)(~0)
 #define SOCKET_ERROR (-1)
+#ifndef MSG_NOSIGNAL// e.g. macOS
+#define MSG_NOSIGNAL 0
+#endif
+#ifdef __linux__
+#include <ctime>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#endif
+#ifdef __linux__// older libc headers lack the UDP offload options
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
 #endif
 
 
@@ -45,6 +77,291 @@ namespace simple_socket {
         }
     }
 
+    inline int lastSocketError() {
+
+#ifdef _WIN32
+        return WSAGetLastError();
+#else
+        return errno;
+#endif
+    }
+
+    // True if the last socket call failed only because a non-blocking socket was not ready.
+    inline bool socketWouldBlock() {
+
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+    }
+
+    // True if the last accept failed because the process (EMFILE) or the system (ENFILE) ran out of descriptors,
+    // in which case the connection stays queued and the listener readable.
+    inline bool socketOutOfDescriptors() {
+
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEMFILE;
+#else
+        return errno == EMFILE || errno == ENFILE;
+#endif
+    }
+
+    inline bool setNonBlocking(SOCKET socket, bool enable = true) {
+
+#ifdef _WIN32
+        u_long mode = enable ? 1 : 0;
+        return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+        const int flags = fcntl(socket, F_GETFL, 0);
+        if (flags < 0) return false;
+        return fcntl(socket, F_SETFL, enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK)) == 0;
+#endif
+    }
+
+    // poll(2) on POSIX, WSAPoll on Windows. Returns the number of ready sockets, 0 on timeout or SOCKET_ERROR.
+    inline int pollSockets(pollfd* fds, size_t count, int timeoutMs) {
+
+#ifdef _WIN32
+        return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+#else
+        int rc;
+        do {
+            rc = ::poll(fds, static_cast<nfds_t>(count), timeoutMs);
+        } while (rc < 0 && errno == EINTR);
+        return rc;
+#endif
+    }
+
+    // Milliseconds left until the deadline, rounded up, as a poll timeout. time_point::max() waits forever (-1).
+    inline int pollTimeout(std::chrono::steady_clock::time_point deadline) {
+
+        if (deadline == std::chrono::steady_clock::time_point::max()) return -1;
+        const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return 0;
+        return static_cast<int>(std::min<long long>(remaining, std::numeric_limits<int>::max()));
+    }
+
+    // Waits for the requested poll events (or an error/hangup) until the deadline.
+    // Returns 1 when ready, 0 on timeout or SOCKET_ERROR.
+    inline int waitSocket(SOCKET socket, short events, std::chrono::steady_clock::time_point deadline) {
+
+        pollfd pfd{};
+        pfd.fd = socket;
+        pfd.events = events;
+        const int rc = pollSockets(&pfd, 1, pollTimeout(deadline));
+        if (rc <= 0) return rc;
+        // a closed descriptor is an error, anything else is left for the following recv/send to report
+        return (pfd.revents & POLLNVAL) ? SOCKET_ERROR : 1;
+    }
+
+    inline void setSocketOption(SOCKET socket, int level, int name, int value, const char* what) {
+
+        if (setsockopt(socket, level, name, reinterpret_cast<const char*>(&value), sizeof(value)) == SOCKET_ERROR) {
+            throwSocketError(std::string("Failed to set ") + what);
+        }
+    }
+
+    // SocketOptions::timestamps. TCP sockets reject it until they are connected.
+    inline void applyTimestamps(SOCKET socket, bool enable) {
+
+#ifdef __linux__
+        // OPT_ID numbers the sends, OPT_TSONLY reports just the timestamp instead of looping the packet back
+        const int flags = SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE |
+                          SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+        setSocketOption(socket, SOL_SOCKET, SO_TIMESTAMPING, enable ? flags : 0, "SO_TIMESTAMPING");
+#endif
+    }
+
+    // For protocols exchanging small request/response frames, each of which should go out right away.
+    inline SocketOptions noDelayOptions() {
+        SocketOptions options;
+        options.noDelay = true;
+        return options;
+    }
+
+    // Applies the options that are set. tcp selects whether the TCP or the UDP level options apply.
+    inline void applySocketOptions(SOCKET socket, const SocketOptions& options, bool tcp) {
+
+        if (options.sendBufferSize) setSocketOption(socket, SOL_SOCKET, SO_SNDBUF, *options.sendBufferSize, "SO_SNDBUF");
+        if (options.receiveBufferSize) setSocketOption(socket, SOL_SOCKET, SO_RCVBUF, *options.receiveBufferSize, "SO_RCVBUF");
+        if (!tcp) {
+#ifdef __linux__
+            if (options.udpGro) setSocketOption(socket, IPPROTO_UDP, UDP_GRO, *options.udpGro, "UDP_GRO");
+#endif
+            if (options.timestamps) applyTimestamps(socket, *options.timestamps);
+            if (options.reuseAddress) {
+                setSocketOption(socket, SOL_SOCKET, SO_REUSEADDR, *options.reuseAddress, "SO_REUSEADDR");
+#if defined(SO_REUSEPORT) && !defined(__linux__)
+                setSocketOption(socket, SOL_SOCKET, SO_REUSEPORT, *options.reuseAddress, "SO_REUSEPORT");
+#endif
+            }
+            return;
+        }
+
+        if (options.noDelay) setSocketOption(socket, IPPROTO_TCP, TCP_NODELAY, *options.noDelay, "TCP_NODELAY");
+        if (options.keepAlive) setSocketOption(socket, SOL_SOCKET, SO_KEEPALIVE, *options.keepAlive, "SO_KEEPALIVE");
+#ifdef TCP_NOTSENT_LOWAT
+        if (options.notSentLowWatermark) setSocketOption(socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT, *options.notSentLowWatermark, "TCP_NOTSENT_LOWAT");
+#endif
+#ifdef TCP_QUICKACK
+        if (options.quickAck) setSocketOption(socket, IPPROTO_TCP, TCP_QUICKACK, *options.quickAck, "TCP_QUICKACK");
+#endif
+        if (options.timestamps) applyTimestamps(socket, *options.timestamps);
+    }
+
+#ifdef __linux__
+    inline std::chrono::system_clock::time_point toTimePoint(const timespec& ts) {
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec)));
+    }
+
+    // Receive timestamp of a message read with SocketOptions::timestamps, false if it carries none.
+    inline bool rxTimestampOf(msghdr& msg, std::chrono::system_clock::time_point& time) {
+
+        for (auto* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_TIMESTAMPING) continue;
+            scm_timestamping stamps{};
+            std::memcpy(&stamps, CMSG_DATA(cm), sizeof(stamps));
+            time = toTimePoint(stamps.ts[0]);
+            return true;
+        }
+        return false;
+    }
+
+    // Transmit timestamp carried by a message from the error queue, false if it is something else
+    // (e.g. a zero-copy completion).
+    inline bool txTimestampOf(msghdr& msg, TxTimestamp& timestamp) {
+
+        bool stamped = false;
+        bool identified = false;
+        for (auto* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPING) {
+                scm_timestamping stamps{};
+                std::memcpy(&stamps, CMSG_DATA(cm), sizeof(stamps));
+                timestamp.time = toTimePoint(stamps.ts[0]);
+                stamped = true;
+            } else if ((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                       (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+                sock_extended_err err{};
+                std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+                if (err.ee_origin != SO_EE_ORIGIN_TIMESTAMPING) return false;
+                timestamp.id = err.ee_data;
+                identified = true;
+            }
+        }
+        return stamped && identified;
+    }
+
+    // Space for the control messages of an error queue message, a timestamp being the largest.
+    constexpr size_t errorQueueControlSize = CMSG_SPACE(sizeof(scm_timestamping)) +
+                                             CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6));
+#endif
+
+    // "host:port" or "[IPv6]:port"
+    inline std::pair<std::string, uint16_t> parseHostPort(const std::string& input) {
+        const size_t colonPos = input.rfind(':');
+        if (colonPos == std::string::npos) {
+            throw std::invalid_argument("Invalid input format. Expected 'host:port'.");
+        }
+
+        std::string host = input.substr(0, colonPos);
+        if (host.size() > 1 && host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2);// [IPv6]:port
+        }
+        std::string portStr = input.substr(colonPos + 1);
+
+        // Convert port string to uint16_t
+        uint16_t port;
+        try {
+            port = static_cast<uint16_t>(std::stoi(portStr));
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Invalid port number.");
+        }
+
+        return std::make_pair(host, port);
+    }
+
+    // Conversion between Endpoint and the socket API's address structures.
+    struct EndpointAccess {
+
+        // Parses a numeric IPv4 or IPv6 literal, returns false if address is none.
+        static bool parse(const std::string& address, uint16_t port, Endpoint& endpoint) {
+
+            endpoint = Endpoint();
+            endpoint.port_ = port;
+            if (inet_pton(AF_INET, address.c_str(), endpoint.address_.data()) == 1) return true;
+            endpoint.v6_ = true;
+            if (inet_pton(AF_INET6, address.c_str(), endpoint.address_.data()) == 1) return true;
+            if (address.find('%') == std::string::npos) return false;
+
+            // scoped (link local) address, inet_pton does not take the scope
+            addrinfo hints{};
+            hints.ai_family = AF_INET6;
+            hints.ai_flags = AI_NUMERICHOST;
+            addrinfo* res = nullptr;
+            if (getaddrinfo(address.c_str(), nullptr, &hints, &res) != 0 || !res) return false;
+            sockaddr_storage addr{};
+            std::memcpy(&addr, res->ai_addr, std::min<size_t>(res->ai_addrlen, sizeof(addr)));
+            freeaddrinfo(res);
+            endpoint = fromSockaddr(addr);
+            endpoint.port_ = port;
+            return true;
+        }
+
+        // Address to use with a socket of family: AF_INET, or a dual stack AF_INET6 socket where IPv4 endpoints
+        // map to ::ffff:a.b.c.d. Returns the length of the address, 0 if the socket can not reach the endpoint.
+        static socklen_t toSockaddr(const Endpoint& endpoint, int family, sockaddr_storage& addr) {
+
+            addr = {};
+            if (family == AF_INET) {
+                if (endpoint.v6_) return 0;
+                auto& in = reinterpret_cast<sockaddr_in&>(addr);
+                in.sin_family = AF_INET;
+                std::memcpy(&in.sin_addr, endpoint.address_.data(), 4);
+                in.sin_port = htons(endpoint.port_);
+                return sizeof(sockaddr_in);
+            }
+
+            auto& in6 = reinterpret_cast<sockaddr_in6&>(addr);
+            in6.sin6_family = AF_INET6;
+            in6.sin6_port = htons(endpoint.port_);
+            if (endpoint.v6_) {
+                std::memcpy(&in6.sin6_addr, endpoint.address_.data(), 16);
+                in6.sin6_scope_id = endpoint.scopeId_;
+            } else {
+                auto* bytes = reinterpret_cast<uint8_t*>(&in6.sin6_addr);
+                bytes[10] = bytes[11] = 0xFF;
+                std::memcpy(bytes + 12, endpoint.address_.data(), 4);
+            }
+            return sizeof(sockaddr_in6);
+        }
+
+        // IPv4 mapped IPv6 addresses come back as IPv4.
+        static Endpoint fromSockaddr(const sockaddr_storage& addr) {
+
+            Endpoint endpoint;
+            if (addr.ss_family == AF_INET) {
+                const auto& in = reinterpret_cast<const sockaddr_in&>(addr);
+                std::memcpy(endpoint.address_.data(), &in.sin_addr, 4);
+                endpoint.port_ = ntohs(in.sin_port);
+            } else if (addr.ss_family == AF_INET6) {
+                const auto& in6 = reinterpret_cast<const sockaddr_in6&>(addr);
+                const auto* bytes = reinterpret_cast<const uint8_t*>(&in6.sin6_addr);
+                constexpr uint8_t mappedPrefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+                if (std::memcmp(bytes, mappedPrefix, sizeof(mappedPrefix)) == 0) {
+                    std::memcpy(endpoint.address_.data(), bytes + 12, 4);
+                } else {
+                    std::memcpy(endpoint.address_.data(), bytes, 16);
+                    endpoint.scopeId_ = in6.sin6_scope_id;
+                    endpoint.v6_ = true;
+                }
+                endpoint.port_ = ntohs(in6.sin6_port);
+            }
+            return endpoint;
+        }
+    };
+
 }// namespace simple_socket
 
 #endif//SIMPLE_SOCKET_COMMON_HPP
@@ -8,14 +8,12 @@
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 
-#ifndef _WIN32
-#include <fcntl.h>
-#endif
-
 namespace simple_socket {
 
     class TLSConnection: public SimpleConnection {
     public:
+        using SimpleConnection::writev;
+
         TLSConnection(SOCKET sock, const std::string& ip)
             : sockfd_(sock) {
 
@@ -33,51 +31,95 @@ namespace simple_socket {
                 throw std::runtime_error("Failed to connect to TLS host");
             }
 
-            set_nonblocking(sockfd_);
+            setNonBlocking(sockfd_);
             // Ensure AUTO_RETRY is off for non-blocking semantics
             SSL_clear_mode(ssl_, SSL_MODE_AUTO_RETRY);
         }
 
         bool write(const uint8_t* buf, size_t len) override {
+
+            return static_cast<bool>(writeUntil(buf, len, std::chrono::steady_clock::time_point::max()));
+        }
+
+        bool writev(std::span<const ConstBuffer> buffers) override {
             if (!ssl_) return false;
 
-            size_t total = 0;
-            while (total < len) {
-                const int n = SSL_write(ssl_, buf + total, static_cast<int>(len - total));
-                if (n > 0) {
-                    total += static_cast<size_t>(n);
-                    continue;
-                }
-                const int err = SSL_get_error(ssl_, n);
-                if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
-                    continue;// retry
+            // coalesce small buffers into record sized chunks so each SSL_write produces full TLS records
+            constexpr size_t maxRecord = 16 * 1024;
+            uint8_t record[maxRecord];
+            size_t used = 0;
+            for (const auto& b : buffers) {
+                size_t offset = 0;
+                while (offset < b.size) {
+                    if (used == 0 && b.size - offset >= maxRecord) {
+                        if (!write(b.data + offset, b.size - offset)) return false;
+                        break;
+                    }
+                    const size_t count = std::min(maxRecord - used, b.size - offset);
+                    std::memcpy(record + used, b.data + offset, count);
+                    used += count;
+                    offset += count;
+                    if (used == maxRecord) {
+                        if (!write(record, used)) return false;
+                        used = 0;
+                    }
                 }
-                return false;// fatal
             }
-            return true;
+            return used == 0 || write(record, used);
         }
 
         int read(uint8_t* buf, size_t len) override {
-            if (!ssl_) return -1;
+
+            const auto result = readUntil(buf, len, std::chrono::steady_clock::time_point::max());
+            if (result) return static_cast<int>(result.bytes);
+            return result.status == IoStatus::Closed ? 0 : -1;// 0 on clean TLS shutdown
+        }
+
+        IoResult readUntil(uint8_t* buf, size_t len, std::chrono::steady_clock::time_point deadline) override {
+            if (!ssl_) return {IoStatus::Error, 0};
 
             for (;;) {
                 const int n = SSL_read(ssl_, buf, static_cast<int>(len));
-                if (n > 0) return n;
+                if (n > 0) return {IoStatus::Ok, static_cast<size_t>(n)};
 
                 const int err = SSL_get_error(ssl_, n);
-                if (err == SSL_ERROR_ZERO_RETURN) return 0;// clean TLS shutdown
+                if (err == SSL_ERROR_ZERO_RETURN) return {IoStatus::Closed, 0};
                 if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
-                    // retry until caller cancels via close()
+                    const int ready = waitSocket(sockfd_, err == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT, deadline);
+                    if (ready == 0) return {IoStatus::Timeout, 0};
+                    if (ready == SOCKET_ERROR) return {IoStatus::Error, 0};
                     continue;
                 }
-                return -1;// fatal
+                return {IoStatus::Error, 0};// fatal
             }
         }
 
-        void close() override {
+        IoResult writeUntil(const uint8_t* buf, size_t len, std::chrono::steady_clock::time_point deadline) override {
+            if (!ssl_) return {IoStatus::Error, 0};
 
-            closeSocket(sockfd_);
+            size_t total = 0;
+            while (total < len) {
+                const int n = SSL_write(ssl_, buf + total, static_cast<int>(len - total));
+                if (n > 0) {
+                    total += static_cast<size_t>(n);
+                    continue;
+                }
+                const int err = SSL_get_error(ssl_, n);
+                if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+                    // a partially written record must be retried with the same arguments
+                    const int ready = waitSocket(sockfd_, err == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT, deadline);
+                    if (ready == 0) return {IoStatus::Timeout, total};
+                    if (ready == SOCKET_ERROR) return {IoStatus::Error, total};
+                    continue;
+                }
+                return {IoStatus::Error, total};// fatal
+            }
+            return {IoStatus::Ok, total};
+        }
 
+        void close() override {
+
+            // shut down TLS while the socket is still open, then release the descriptor exactly once
             if (ssl_) {
                 SSL_shutdown(ssl_);
                 SSL_free(ssl_);
@@ -87,6 +129,8 @@ namespace simple_socket {
                 SSL_CTX_free(ctx_);
                 ctx_ = nullptr;
             }
+            closeSocket(sockfd_);
+            sockfd_ = INVALID_SOCKET;
         }
 
         ~TLSConnection() override {
@@ -95,19 +139,8 @@ namespace simple_socket {
 
     private:
         SOCKET sockfd_;
-        SSL* ssl_;
-        SSL_CTX* ctx_;
-
-        // Helper: put socket into non-blocking mode
-        static void set_nonblocking(SOCKET s) {
-#ifdef _WIN32
-            u_long mode = 1;
-            ioctlsocket(s, FIONBIO, &mode);
-#else
-            int flags = fcntl(s, F_GETFL, 0);
-            if (flags >= 0) fcntl(s, F_SETFL, flags | O_NONBLOCK);
-#endif
-        }
+        SSL* ssl_{nullptr};
+        SSL_CTX* ctx_{nullptr};
     };
 
 
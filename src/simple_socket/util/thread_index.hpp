@@ -0,0 +1,20 @@
+
+#ifndef SIMPLE_SOCKET_THREAD_INDEX_HPP
+#define SIMPLE_SOCKET_THREAD_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace simple_socket {
+
+    // Small number assigned round robin to each thread on first use, for picking a shard of per thread state.
+    inline size_t threadIndex() {
+
+        static std::atomic_size_t next{0};
+        thread_local const size_t index = next++;
+        return index;
+    }
+
+}// namespace simple_socket
+
+#endif//SIMPLE_SOCKET_THREAD_INDEX_HPP
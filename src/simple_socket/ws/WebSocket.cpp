@@ -2,6 +2,7 @@
 #include "simple_socket/ws/WebSocket.hpp"
 
 #include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/TimerWheel.hpp"
 #include "simple_socket/ws/WebSocketHandshakeKeyGen.hpp"
 
 #include "simple_socket/util/uuid.hpp"
@@ -20,7 +21,7 @@ using namespace simple_socket;
 
 namespace {
 
-    void handshake(SimpleConnection& conn) {
+    void handshake(BufferedConnection& conn) {
 
         const auto raw = readHttpHeaderBlock(conn);
         const auto http = parseHttpHeaders(raw);
@@ -53,7 +54,16 @@ namespace {
 struct WebSocket::Impl {
 
     explicit Impl(WebSocket* scope, uint16_t port)
-        : scope(scope), socket(port) {}
+        : scope(scope), socket(port, 128, false, serverOptions()) {}
+
+    static constexpr std::chrono::seconds handshakeTimeout{5};
+
+    static SocketOptions serverOptions() {
+        SocketOptions options;
+        // the client opens with the upgrade request, so the handshake below rarely waits on a silent peer
+        options.deferAccept = 5;
+        return options;
+    }
 
     void run() {
 
@@ -61,18 +71,40 @@ struct WebSocket::Impl {
 
         while (!stop_) {
 
+            std::vector<std::unique_ptr<SimpleConnection>> accepted;
             try {
-                WebSocketCallbacks callbacks{scope->onOpen, scope->onClose, scope->onMessage};
-                auto conn = socket.accept();
-                handshake(*conn);
-                auto ws = std::make_unique<WebSocketConnectionImpl>(callbacks, std::move(conn), WebSocketConnectionImpl::Role::Server);
-
-                ws->run();
-                connections.emplace_back(std::move(ws));
+                accepted = socket.acceptBatch();
             } catch (std::exception&) {
                 // std::cerr << ex.what() << std::endl;
             }
 
+            for (auto& tcp : accepted) {
+                try {
+                    WebSocketCallbacks callbacks{scope->onOpen, scope->onClose, scope->onMessage};
+                    tcp->setMetrics(metrics);
+                    auto conn = std::make_unique<BufferedConnection>(std::move(tcp));
+
+                    // a client that connects but never completes the upgrade request must not stall the accept loop
+                    const auto timeout = TimerWheel::shared().schedule(handshakeTimeout, [c = conn.get()] { c->close(); });
+                    try {
+                        handshake(*conn);
+                    } catch (const std::exception&) {
+                        TimerWheel::shared().cancel(timeout);
+                        throw;
+                    }
+                    TimerWheel::shared().cancel(timeout);
+
+                    auto ws = std::make_unique<WebSocketConnectionImpl>(callbacks, std::move(conn), WebSocketConnectionImpl::Role::Server);
+                    ws->setMetrics(metrics);
+                    ws->setKeepAlive(pingInterval, idleTimeout);
+
+                    ws->run();
+                    connections.emplace_back(std::move(ws));
+                } catch (std::exception&) {
+                    // failed handshake, the connection is dropped
+                }
+            }
+
             //cleanup connections
             for (auto it = connections.begin(); it != connections.end();) {
 
@@ -108,6 +140,9 @@ struct WebSocket::Impl {
     WebSocket* scope;
     TCPServer socket;
     std::thread thread;
+    std::shared_ptr<Metrics> metrics = std::make_shared<Metrics>();
+    std::chrono::milliseconds pingInterval{std::chrono::seconds(30)};
+    std::chrono::milliseconds idleTimeout{std::chrono::seconds(75)};
 };
 
 
@@ -122,6 +157,11 @@ WebSocket::WebSocket(uint16_t port)
     : pimpl_(std::make_unique<Impl>(this, port)) {}
 
 
+void WebSocket::setKeepAlive(std::chrono::milliseconds pingInterval, std::chrono::milliseconds idleTimeout) {
+    pimpl_->pingInterval = pingInterval;
+    pimpl_->idleTimeout = idleTimeout;
+}
+
 void WebSocket::start() {
     pimpl_->start();
 }
@@ -130,4 +170,8 @@ void WebSocket::stop() {
     pimpl_->stop();
 }
 
+MetricsSnapshot WebSocket::metrics() const {
+    return pimpl_->metrics->snapshot();
+}
+
 WebSocket::~WebSocket() = default;
@@ -95,7 +95,7 @@ namespace {
         throw std::invalid_argument("Invalid WebSocket URL: " + url);
     }
 
-    void performHandshake(SimpleConnection& conn, const std::string& url, const std::string& host, uint16_t port) {
+    void performHandshake(BufferedConnection& conn, const std::string& url, const std::string& host, uint16_t port) {
 
         std::string path = "/";
         const auto schemePos = url.find("://");
@@ -147,7 +147,11 @@ struct WebSocketClient::Impl {
         const bool useTLS = url.rfind("wss://", 0) == 0;
 
         const auto [host, port] = parseWebSocketURL(url);
-        auto c = ctx_.connect(host, port, useTLS);
+        auto tcp = ctx_.connect(host, port, useTLS);
+        if (!tcp) throwSocketError("Failed to connect to " + host);
+
+        // frames sent right after the 101 response may arrive together with it, the buffer keeps them for the reader
+        auto c = std::make_unique<BufferedConnection>(std::move(tcp));
         performHandshake(*c, url, host, port);
 
         WebSocketCallbacks callbacks{scope_->onOpen, scope_->onClose, scope_->onMessage};
@@ -3,6 +3,7 @@
 #define SIMPLE_SOCKET_WEBSOCKET_CONNECTION_HPP
 
 #include <atomic>
+#include <chrono>
 #include <iostream>
 #include <mutex>
 #include <random>
@@ -10,6 +11,9 @@
 #include <thread>
 #include <vector>
 
+#include "simple_socket/BufferPool.hpp"
+#include "simple_socket/Metrics.hpp"
+#include "simple_socket/TimerWheel.hpp"
 #include "simple_socket/ws/WebSocket.hpp"
 
 namespace simple_socket {
@@ -54,34 +58,52 @@ namespace simple_socket {
             buffer.resize(size);
         }
 
+        // Call before run().
+        void setKeepAlive(std::chrono::milliseconds pingInterval, std::chrono::milliseconds idleTimeout) {
+            pingInterval_ = pingInterval;
+            idleTimeout_ = idleTimeout;
+        }
+
+        // Counts frames here and bytes/system calls on the underlying connection. Call before run().
+        void setMetrics(std::shared_ptr<Metrics> metrics) {
+            conn_->setMetrics(metrics);
+            metrics_ = std::move(metrics);
+        }
+
         void run() {
 
             if (callbacks_.onOpen) {
                 callbacks_.onOpen(this);
             }
 
+            // a peer that vanished without closing is noticed by the missing traffic (pongs at least)
+            idleTimer_ = TimerWheel::shared().schedule(idleTimeout_, [this] {
+                conn_->close();// the listener notices and closes the rest
+            });
+            schedulePing();
+
             thread_ = std::thread([this] {
                 listen();
             });
         }
         bool send(const std::string& message) override {
-            const auto frame = buildText(message, role_);
-            std::lock_guard lg(tx_mtx_);
-            return conn_->write(frame);
+            return sendFrame(WS_TEXT, reinterpret_cast<const uint8_t*>(message.data()), message.size());
         }
 
         bool send(const uint8_t* message, size_t len) override {
-            const auto frame = buildBin(message, len, role_);
-            std::lock_guard lg(tx_mtx_);
-            return conn_->write(frame);
+            return sendFrame(WS_BIN, message, len);
         }
 
         void close(bool self) {
             if (closed_.exchange(true)) return;
 
+            // never called from the timers themselves, so this waits for one that is running right now
+            TimerWheel::shared().cancel(idleTimer_);
+            while (const auto timer = pingTimer_.exchange(0)) TimerWheel::shared().cancel(timer);
+
             if (self) {
                 // Empty close payload; mask only if client role
-                std::vector<uint8_t> closeFrame = buildClose(/*code=*/1000, role_);
+                const auto closeFrame = buildClose(/*code=*/1000, role_);
                 std::lock_guard lg(tx_mtx_);
                 conn_->write(closeFrame);
             }
@@ -109,6 +131,9 @@ namespace simple_socket {
         }
 
     private:
+        std::chrono::milliseconds pingInterval_{std::chrono::seconds(30)};
+        std::chrono::milliseconds idleTimeout_{std::chrono::seconds(75)};
+
         Role role_;
         std::mutex tx_mtx_;// serialize writes only
         std::atomic_bool closed_{false};
@@ -118,73 +143,119 @@ namespace simple_socket {
         std::thread thread_;
 
         std::vector<unsigned char> buffer;
+        std::shared_ptr<Metrics> metrics_;
+
+        TimerWheel::TimerId idleTimer_{0};
+        std::atomic<TimerWheel::TimerId> pingTimer_{0};
+
+        void schedulePing() {
+            pingTimer_ = TimerWheel::shared().schedule(pingInterval_, [this] {
+                if (closed_) return;
+                // a connection busy sending needs no ping, and the timer thread must not queue up behind it
+                std::unique_lock lock(tx_mtx_, std::try_to_lock);
+                if (lock.owns_lock()) {
+                    const auto ping = buildFrame(WS_PING, nullptr, 0, role_);
+                    // nor wait for the send buffer to drain: a peer with no room for a few bytes is not reading,
+                    // so the ping fails right away and closes the connection
+                    if (!conn_->writeUntil(ping.data(), ping.size(), std::chrono::steady_clock::now())) {
+                        conn_->close();
+                        return;
+                    }
+                }
+                if (!closed_) schedulePing();
+            });
+        }
+
+
+        // Unmasked frames go out as header + caller's payload in a single gather write, without copying the payload.
+        // Client frames must be masked, which requires a copy anyway.
+        bool sendFrame(uint8_t opcode, const uint8_t* data, size_t len) {
+            if (metrics_) metrics_->add(Metrics::Counter::MessagesOut);
+            if (role_ == Role::Client) {
+                const auto frame = buildFrame(opcode, data, len, role_);
+                std::lock_guard lg(tx_mtx_);
+                return conn_->write(frame);
+            }
 
+            uint8_t header[10];
+            size_t hdr = 0;
+            header[hdr++] = 0x80 | (opcode & 0x0F);// FIN=1
+            if (len <= 125) {
+                header[hdr++] = static_cast<uint8_t>(len);
+            } else if (len <= 0xFFFF) {
+                header[hdr++] = 126;
+                header[hdr++] = static_cast<uint8_t>((len >> 8) & 0xFF);
+                header[hdr++] = static_cast<uint8_t>(len & 0xFF);
+            } else {
+                header[hdr++] = 127;
+                for (int i = 7; i >= 0; --i)
+                    header[hdr++] = static_cast<uint8_t>((static_cast<uint64_t>(len) >> (i * 8)) & 0xFF);
+            }
 
-        static std::vector<uint8_t> buildFrame(uint8_t opcode,
-                                               const uint8_t* data,
-                                               size_t len,
-                                               Role role) {
-            std::vector<uint8_t> out;
-            out.reserve(2 + 4 + len);
-            out.push_back(0x80 | (opcode & 0x0F));// FIN=1
+            std::lock_guard lg(tx_mtx_);
+            return conn_->writev({ConstBuffer(header, hdr), ConstBuffer(data, len)});
+        }
+
+        // Frames are built in pooled buffers, so sending does not allocate per message.
+        static BufferPool::Buffer buildFrame(uint8_t opcode,
+                                             const uint8_t* data,
+                                             size_t len,
+                                             Role role) {
+            auto out = BufferPool::shared().acquire(14 + len);// largest header: 2 + 8 (length) + 4 (mask)
+            size_t hdr = 0;
+            out[hdr++] = 0x80 | (opcode & 0x0F);// FIN=1
             const bool mask = (role == Role::Client);
 
             if (len <= 125) {
-                out.push_back(static_cast<uint8_t>(len) | (mask ? 0x80 : 0x00));
+                out[hdr++] = static_cast<uint8_t>(len) | (mask ? 0x80 : 0x00);
             } else if (len <= 0xFFFF) {
-                out.push_back(126 | (mask ? 0x80 : 0x00));
-                out.push_back(static_cast<uint8_t>((len >> 8) & 0xFF));
-                out.push_back(static_cast<uint8_t>(len & 0xFF));
+                out[hdr++] = 126 | (mask ? 0x80 : 0x00);
+                out[hdr++] = static_cast<uint8_t>((len >> 8) & 0xFF);
+                out[hdr++] = static_cast<uint8_t>(len & 0xFF);
             } else {
-                out.push_back(127 | (mask ? 0x80 : 0x00));
+                out[hdr++] = 127 | (mask ? 0x80 : 0x00);
                 for (int i = 7; i >= 0; --i)
-                    out.push_back(static_cast<uint8_t>((static_cast<uint64_t>(len) >> (i * 8)) & 0xFF));
+                    out[hdr++] = static_cast<uint8_t>((static_cast<uint64_t>(len) >> (i * 8)) & 0xFF);
             }
 
             uint8_t m[4] = {0, 0, 0, 0};
             if (mask) {
-                std::random_device rd;
+                thread_local std::random_device rd;
                 for (auto& b : m) b = static_cast<uint8_t>(rd());
-                out.insert(out.end(), m, m + 4);
+                for (const auto b : m) out[hdr++] = b;
             }
 
-            const size_t start = out.size();
-            out.resize(start + len);
             for (size_t i = 0; i < len; ++i) {
                 uint8_t b = data ? data[i] : 0;
                 if (mask) b ^= m[i & 0x03];
-                out[start + i] = b;
+                out[hdr + i] = b;
             }
+            out.resize(hdr + len);
             return out;
         }
 
-        static std::vector<uint8_t> buildText(const std::string& s, Role role) {
-            return buildFrame(WS_TEXT, reinterpret_cast<const uint8_t*>(s.data()), s.size(), role);
-        }
-
-        static std::vector<uint8_t> buildBin(const uint8_t* msg, size_t len, Role role) {
-            return buildFrame(WS_BIN, msg, len, role);
-        }
-
-        static std::vector<uint8_t> buildClose(uint16_t code, Role role) {
+        static BufferPool::Buffer buildClose(uint16_t code, Role role) {
             uint8_t p[2] = {static_cast<uint8_t>(code >> 8), static_cast<uint8_t>(code & 0xFF)};
             return buildFrame(WS_CLOSE, p, 2, role);
         }
 
-        static std::vector<uint8_t> buildPong(const std::vector<uint8_t>& payload, Role role) {
+        static BufferPool::Buffer buildPong(std::span<const uint8_t> payload, Role role) {
             return buildFrame(WS_PONG, payload.data(), payload.size(), role);
         }
 
         void listen() {
 
+            // all three keep their capacity across messages
             std::vector<uint8_t> rx;     // accumulated bytes from socket
             std::vector<uint8_t> message;// assembling fragmented messages
+            std::string delivered;       // message handed to onMessage
             bool continued = false;
             uint8_t startOpcode = 0;
 
             while (!closed_) {
                 const int recv = conn_->read(buffer);
                 if (recv <= 0) break;
+                TimerWheel::shared().reschedule(idleTimer_, idleTimeout_);
 
                 rx.insert(rx.end(), buffer.begin(), buffer.begin() + recv);
 
@@ -235,15 +306,14 @@ namespace simple_socket {
                         off += 4;
                     }
 
-                    std::vector<uint8_t> chunk;
-                    chunk.resize(payloadLen);
-                    for (size_t i = 0; i < chunk.size(); ++i) {
-                        uint8_t b = rx[off + i];
-                        if (isMasked) b ^= mask[i & 0x03];
-                        chunk[i] = b;
+                    // unmask in place, the payload is consumed from rx
+                    const std::span<uint8_t> chunk(rx.data() + off, payloadLen);
+                    if (isMasked) {
+                        for (size_t i = 0; i < chunk.size(); ++i) chunk[i] ^= mask[i & 0x03];
                     }
 
                     pos = off + payloadLen;
+                    if (metrics_) metrics_->add(Metrics::Counter::MessagesIn);
 
                     if (opcode == WS_CLOSE) {
                         {
@@ -268,12 +338,9 @@ namespace simple_socket {
                         message.insert(message.end(), chunk.begin(), chunk.end());
                         if (fin) {
                             // deliver completed fragmented message
-                            if (startOpcode == WS_TEXT) {
-                                std::string s(message.begin(), message.end());
-                                if (callbacks_.onMessage) callbacks_.onMessage(this, s);
-                            } else if (startOpcode == WS_BIN) {
-                                std::string s(reinterpret_cast<const char*>(message.data()), message.size());
-                                if (callbacks_.onMessage) callbacks_.onMessage(this, s);
+                            if (startOpcode == WS_TEXT || startOpcode == WS_BIN) {
+                                delivered.assign(reinterpret_cast<const char*>(message.data()), message.size());
+                                if (callbacks_.onMessage) callbacks_.onMessage(this, delivered);
                             }
                             message.clear();
                             continued = false;
@@ -289,16 +356,11 @@ namespace simple_socket {
                         }
                         if (fin) {
                             // single-frame message
-                            if (opcode == WS_TEXT) {
-                                std::string s(chunk.begin(), chunk.end());
-                                if (callbacks_.onMessage) callbacks_.onMessage(this, s);
-                            } else {
-                                std::string s(reinterpret_cast<const char*>(chunk.data()), chunk.size());
-                                if (callbacks_.onMessage) callbacks_.onMessage(this, s);
-                            }
+                            delivered.assign(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+                            if (callbacks_.onMessage) callbacks_.onMessage(this, delivered);
                         } else {
                             // start fragmented message
-                            message = std::move(chunk);
+                            message.assign(chunk.begin(), chunk.end());
                             continued = true;
                             startOpcode = opcode;
                         }
@@ -312,6 +374,9 @@ namespace simple_socket {
                 // discard parsed bytes, keep remainder for next read
                 if (pos > 0) rx.erase(rx.begin(), rx.begin() + pos);
             }
+
+            // the peer went away (or timed out) without a close frame
+            close(false);
         }
     };
 }// namespace simple_socket
@@ -2,7 +2,7 @@
 #ifndef SIMPLE_SOCKET_WEBSOCKETHANDSHAKECOMMON_HPP
 #define SIMPLE_SOCKET_WEBSOCKETHANDSHAKECOMMON_HPP
 
-#include "simple_socket/SimpleConnection.hpp"
+#include "simple_socket/BufferedConnection.hpp"
 #include "simple_socket/util/string_utils.hpp"
 #include "simple_socket/socket_common.hpp"
 
@@ -24,18 +24,15 @@ namespace simple_socket {
     };
 
     // Read raw HTTP header block (including trailing "\r\n\r\n").
+    // Anything the peer sent after the headers (e.g. the first frames) stays buffered in conn.
     // Throws on read failure or when headers exceed maxBytes.
-    inline std::string readHttpHeaderBlock(SimpleConnection& conn, size_t maxBytes = 16 * 1024) {
+    inline std::string readHttpHeaderBlock(BufferedConnection& conn, size_t maxBytes = 16 * 1024) {
         std::string raw;
-        std::vector<unsigned char> buffer(1024);
         constexpr size_t defaultMax = 16 * 1024;
         if (maxBytes == 0) maxBytes = defaultMax;
 
-        while (raw.find("\r\n\r\n") == std::string::npos) {
-            const int n = conn.read(buffer);
-            if (n <= 0) throwSocketError("Failed to read HTTP headers.");
-            raw.append(reinterpret_cast<const char*>(buffer.data()), static_cast<size_t>(n));
-            if (raw.size() > maxBytes) throwSocketError("HTTP headers too large.");
+        if (!conn.readUntil("\r\n\r\n", raw, maxBytes)) {
+            throwSocketError(conn.buffered() >= maxBytes ? "HTTP headers too large." : "Failed to read HTTP headers.");
         }
         return raw;
     }
@@ -0,0 +1,140 @@
+
+#include "simple_socket/IoUring.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace simple_socket;
+
+// Echo throughput of the plain socket path (thread per connection, one read + one write syscall per message)
+// against a single thread driving io_uring with batched submissions.
+//
+// usage: io_uring_bench [connections=16] [messages=20000] [messageSize=64]
+
+namespace {
+
+    struct Session {
+        std::unique_ptr<IoUringConnection> conn;
+        std::vector<uint8_t> buffer;
+    };
+
+    double runClients(uint16_t port, size_t numConnections, size_t numMessages, size_t messageSize) {
+
+        std::vector<std::thread> clients;
+        std::atomic_size_t failures{0};
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < numConnections; ++i) {
+            clients.emplace_back([&] {
+                TCPClientContext ctx;
+                auto conn = ctx.connect("127.0.0.1", port);
+                if (!conn) {
+                    ++failures;
+                    return;
+                }
+                std::vector<uint8_t> message(messageSize, 'x');
+                std::vector<uint8_t> response(messageSize);
+                for (size_t m = 0; m < numMessages; ++m) {
+                    if (!conn->write(message) || !conn->readExact(response)) {
+                        ++failures;
+                        return;
+                    }
+                }
+            });
+        }
+        for (auto& t : clients) t.join();
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (failures) std::cerr << failures << " clients failed" << std::endl;
+        return elapsed;
+    }
+
+    double benchSockets(uint16_t port, size_t numConnections, size_t numMessages, size_t messageSize) {
+
+        TCPServer server(port, static_cast<int>(numConnections));
+        std::vector<std::thread> handlers;
+        std::thread acceptor([&] {
+            for (size_t i = 0; i < numConnections; ++i) {
+                std::shared_ptr<SimpleConnection> conn = server.accept();
+                handlers.emplace_back([conn, messageSize] {
+                    std::vector<uint8_t> buffer(messageSize);
+                    int n;
+                    while ((n = conn->read(buffer)) > 0) {
+                        if (!conn->write(buffer.data(), n)) break;
+                    }
+                });
+            }
+        });
+
+        const auto elapsed = runClients(port, numConnections, numMessages, messageSize);
+        acceptor.join();
+        for (auto& t : handlers) t.join();
+        server.close();
+        return elapsed;
+    }
+
+    double benchIoUring(uint16_t port, size_t numConnections, size_t numMessages, size_t messageSize, size_t& enterCalls) {
+
+        IoUringContext ctx(1024);
+        IoUringServer server(ctx, port, static_cast<int>(numConnections));
+
+        std::vector<std::unique_ptr<Session>> sessions;
+        std::function<void(Session&)> echo = [&](Session& s) {
+            s.conn->asyncRead(s.buffer.data(), s.buffer.size(), [&](int n) {
+                if (n <= 0) return;
+                s.conn->asyncWrite(s.buffer.data(), n, [&](int written) {
+                    if (written > 0) echo(s);
+                });
+            });
+        };
+        std::function<void(std::unique_ptr<IoUringConnection>)> onAccept = [&](std::unique_ptr<IoUringConnection> conn) {
+            if (!conn) return;
+            auto& s = *sessions.emplace_back(std::make_unique<Session>());
+            s.conn = std::move(conn);
+            s.buffer.resize(messageSize);
+            echo(s);
+            if (sessions.size() < numConnections) server.asyncAccept(onAccept);
+        };
+        server.asyncAccept(onAccept);
+
+        std::atomic_bool done{false};
+        std::thread loop([&] {
+            while (!done || ctx.inFlight() > 0) ctx.run();
+        });
+
+        const auto elapsed = runClients(port, numConnections, numMessages, messageSize);
+        done = true;
+        loop.join();
+        enterCalls = ctx.enterCalls();
+        return elapsed;
+    }
+
+}// namespace
+
+int main(int argc, char** argv) {
+
+    const size_t numConnections = argc > 1 ? std::stoul(argv[1]) : 16;
+    const size_t numMessages = argc > 2 ? std::stoul(argv[2]) : 20000;
+    const size_t messageSize = argc > 3 ? std::stoul(argv[3]) : 64;
+
+    const auto port = getAvailablePort(8000, 9000);
+    if (!port) {
+        std::cerr << "No available port" << std::endl;
+        return 1;
+    }
+
+    const double total = static_cast<double>(numConnections * numMessages);
+
+    const auto socketTime = benchSockets(*port, numConnections, numMessages, messageSize);
+    size_t enterCalls = 0;
+    const auto uringTime = benchIoUring(*port, numConnections, numMessages, messageSize, enterCalls);
+
+    std::cout << "connections:  " << numConnections << ", messages: " << numMessages << ", size: " << messageSize << " bytes\n"
+              << "sockets:      " << total / socketTime << " msg/s, 2 syscalls/msg (server)\n"
+              << "io_uring:     " << total / uringTime << " msg/s, " << static_cast<double>(enterCalls) / total << " syscalls/msg (server)" << std::endl;
+}
@@ -0,0 +1,169 @@
+
+#include "simple_socket/Reactor.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace simple_socket;
+
+// Opens many mostly-idle connections against an echo server and measures
+// round trip latency on a few active ones, either with a Reactor or thread-per-connection.
+//
+// usage: reactor_bench [connections=10000] [reactor|threads] [reactorThreads=2]
+
+namespace {
+
+    size_t raiseFdLimit(size_t wanted) {
+#ifndef _WIN32
+        rlimit lim{};
+        if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+            lim.rlim_cur = lim.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &lim);
+            // both ends of every connection live in this process
+            const size_t maxConnections = (lim.rlim_cur - 64) / 2;
+            return std::min(wanted, maxConnections);
+        }
+#endif
+        return wanted;
+    }
+
+    std::string residentMemory() {
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmRSS:", 0) == 0) return line.substr(line.find_first_not_of(" \t", 6));
+        }
+#endif
+        return "n/a";
+    }
+
+    size_t threadCount() {
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("Threads:", 0) == 0) return std::stoul(line.substr(8));
+        }
+#endif
+        return 0;
+    }
+
+}// namespace
+
+int main(int argc, char** argv) {
+
+    size_t numConnections = argc > 1 ? std::stoul(argv[1]) : 10000;
+    const bool useReactor = argc > 2 ? std::string(argv[2]) != "threads" : true;
+    const size_t reactorThreads = argc > 3 ? std::stoul(argv[3]) : 2;
+
+    numConnections = raiseFdLimit(numConnections);
+
+    const auto port = getAvailablePort(8000, 9000);
+    if (!port) {
+        std::cerr << "No available port" << std::endl;
+        return 1;
+    }
+
+    TCPServer server(*port, 1024);
+    Reactor reactor(reactorThreads);
+    std::vector<std::thread> connectionThreads;
+    std::thread acceptThread;
+
+    if (useReactor) {
+        server.attach(reactor, [&reactor](SimpleConnection&) {
+            ReactorCallbacks callbacks;
+            callbacks.onReadable = [&reactor](SimpleConnection& conn) {
+                unsigned char buffer[256];
+                const auto n = conn.read(buffer, sizeof(buffer));
+                if (n == SimpleConnection::WouldBlock) return;
+                if (n <= 0) {
+                    reactor.remove(conn);
+                    return;
+                }
+                conn.write(buffer, n);
+            };
+            return callbacks;
+        });
+        reactor.start();
+    } else {
+        acceptThread = std::thread([&] {
+            try {
+                for (size_t i = 0; i < numConnections; ++i) {
+                    std::shared_ptr<SimpleConnection> conn = server.accept();
+                    connectionThreads.emplace_back([conn] {
+                        unsigned char buffer[256];
+                        int n;
+                        while ((n = conn->read(buffer, sizeof(buffer))) > 0) {
+                            conn->write(buffer, n);
+                        }
+                    });
+                }
+            } catch (const std::exception& ex) {
+                std::cerr << "accept stopped: " << ex.what() << std::endl;
+            }
+        });
+    }
+
+    TCPClientContext ctx;
+    std::vector<std::unique_ptr<SimpleConnection>> clients;
+    clients.reserve(numConnections);
+
+    const auto connectStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < numConnections; ++i) {
+        auto conn = ctx.connect("127.0.0.1", *port);
+        if (!conn) {
+            std::cerr << "connect failed after " << i << " connections" << std::endl;
+            break;
+        }
+        clients.emplace_back(std::move(conn));
+    }
+    const auto connectTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - connectStart).count();
+
+    // ping a spread of connections while the rest stay idle
+    const size_t active = std::max<size_t>(1, clients.size() / 100);
+    const size_t stride = std::max<size_t>(1, clients.size() / active);
+    std::vector<double> latencies;
+    const std::string ping = "ping";
+    unsigned char pong[4];
+    for (int round = 0; round < 10; ++round) {
+        for (size_t i = 0; i < clients.size(); i += stride) {
+            const auto t0 = std::chrono::steady_clock::now();
+            clients[i]->write(ping);
+            if (!clients[i]->readExact(pong, sizeof(pong))) continue;
+            latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+        }
+    }
+    std::ranges::sort(latencies);
+
+    const auto percentile = [&](double p) {
+        if (latencies.empty()) return 0.0;
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())))];
+    };
+
+    std::cout << "mode:         " << (useReactor ? "reactor (" + std::to_string(reactorThreads) + " threads)" : std::string("thread-per-connection")) << "\n"
+              << "connections:  " << clients.size() << " (" << connectTime << " s to establish)\n"
+              << "threads:      " << threadCount() << "\n"
+              << "resident:     " << residentMemory() << "\n"
+              << "rtt p50:      " << percentile(0.50) << " us\n"
+              << "rtt p99:      " << percentile(0.99) << " us\n"
+              << "rtt max:      " << (latencies.empty() ? 0.0 : latencies.back()) << " us" << std::endl;
+
+    clients.clear();
+    reactor.stop();
+    server.close();
+    if (acceptThread.joinable()) acceptThread.join();
+    for (auto& t : connectionThreads) t.join();
+}
@@ -0,0 +1,115 @@
+
+#include "simple_socket/Relay.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace simple_socket;
+
+// Pushes bulk data through a TCP relay (client -> relay -> sink) and reports throughput and the CPU time
+// of the relay thread, for the splice() path against a forced user space copy.
+//
+// usage: relay_bench [totalMB=4096]
+
+namespace {
+
+    // Hides the socket from relay(), forcing the buffered copy path.
+    struct Opaque: SimpleConnection {
+        explicit Opaque(std::unique_ptr<SimpleConnection> conn): conn(std::move(conn)) {}
+
+        int read(uint8_t* buffer, size_t size) override {
+            return conn->read(buffer, size);
+        }
+
+        bool write(const uint8_t* data, size_t size) override {
+            return conn->write(data, size);
+        }
+
+        void close() override {
+            conn->close();
+        }
+
+        std::unique_ptr<SimpleConnection> conn;
+    };
+
+    double threadCpuTime() {
+#ifdef RUSAGE_THREAD
+        rusage usage{};
+        getrusage(RUSAGE_THREAD, &usage);
+        const auto toSeconds = [](const timeval& tv) { return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) * 1e-6; };
+        return toSeconds(usage.ru_utime) + toSeconds(usage.ru_stime);
+#else
+        return 0;
+#endif
+    }
+
+    void run(const std::string& name, bool splice, size_t totalBytes) {
+
+        const auto sinkPort = getAvailablePort(8000, 9000);
+        const auto relayPort = getAvailablePort(9000, 10000);
+        if (!sinkPort || !relayPort) throw std::runtime_error("No available port");
+
+        TCPServer sinkServer(*sinkPort);
+        TCPServer relayServer(*relayPort);
+
+        std::thread sink([&] {
+            const auto conn = sinkServer.accept();
+            std::vector<uint8_t> buffer(1024 * 1024);
+            while (conn->read(buffer) > 0) {}
+        });
+
+        double cpuSeconds = 0;
+        std::thread relayThread([&] {
+            TCPClientContext ctx;
+            std::unique_ptr<SimpleConnection> from = relayServer.accept();
+            std::unique_ptr<SimpleConnection> to = ctx.connect("127.0.0.1", *sinkPort);
+            if (!splice) {
+                from = std::make_unique<Opaque>(std::move(from));
+                to = std::make_unique<Opaque>(std::move(to));
+            }
+            const auto cpuStart = threadCpuTime();
+            relay(*from, *to, 1024 * 1024);
+            cpuSeconds = threadCpuTime() - cpuStart;
+            to->close();
+        });
+
+        TCPClientContext ctx;
+        const auto conn = ctx.connect("127.0.0.1", *relayPort);
+        if (!conn) throw std::runtime_error("connect failed");
+
+        const std::vector<uint8_t> blob(1024 * 1024, 42);
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t sent = 0; sent < totalBytes; sent += blob.size()) {
+            if (!conn->write(blob)) break;
+        }
+        conn->close();
+        relayThread.join();
+        sink.join();
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const double gb = static_cast<double>(totalBytes) / (1024.0 * 1024.0 * 1024.0);
+        std::cout << name << ": " << gb / seconds << " GB/s, " << cpuSeconds / gb << " CPU s/GB (relay)" << std::endl;
+
+        sinkServer.close();
+        relayServer.close();
+    }
+
+}// namespace
+
+int main(int argc, char** argv) {
+
+    const size_t totalBytes = (argc > 1 ? std::stoul(argv[1]) : 4096) * 1024 * 1024;
+
+    run("copy  ", false, totalBytes);
+    run("splice", true, totalBytes);
+}
@@ -0,0 +1,475 @@
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/UDPSocket.hpp"
+#include "simple_socket/UnixDomainSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#ifdef SIMPLE_SOCKET_WITH_MEMORY
+#include "simple_socket/SharedMemoryConnection.hpp"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace simple_socket;
+
+// Ping-pong latency (p50/p99/p99.9 per round trip) and one way streaming throughput over loopback transports,
+// for message sizes from 8 B to 1 MB. Both ends run in this process, on separate threads.
+//
+// usage: simple_socket_bench [--transports tcp,unix,udp,cudp,shm] [--sizes 8,64,...] [--quick] [--json results.json]
+//
+// UDP skips sizes above the datagram limit and reports the fraction of datagrams lost while streaming.
+// A ping-pong round trip without a reply within 200 ms counts as lost (JSON only) and has no latency sample.
+// Shared memory transfers one message at a time, so its throughput is bounded by the round trip per message.
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t maxDatagramSize = 65507;
+    constexpr size_t maxMessageSize = 1024 * 1024;
+    // a datagram ping-pong stops waiting for the reply after this long and counts the round trip as lost
+    constexpr std::chrono::milliseconds datagramTimeout{200};
+
+    // A connected pair of endpoints, plus whatever the connections depend on (listeners, bound sockets).
+    struct Pair {
+        std::unique_ptr<SimpleConnection> client;
+        std::unique_ptr<SimpleConnection> server;
+        std::vector<std::shared_ptr<void>> owners;
+    };
+
+    struct Transport {
+        std::string name;
+        bool datagram;// unreliable, limited to maxDatagramSize
+        std::function<Pair()> connect;
+    };
+
+    Pair tcpPair() {
+
+        const auto port = getAvailablePort(8000, 9000);
+        if (!port) throw std::runtime_error("No available port");
+
+        SocketOptions options;
+        options.noDelay = true;
+
+        auto server = std::make_shared<TCPServer>(*port, 1, false, options);
+        TCPClientContext ctx(options);
+
+        Pair pair;
+        pair.client = ctx.connect("127.0.0.1", *port);
+        if (!pair.client) throw std::runtime_error("TCP connect failed");
+        pair.server = server->accept();
+        pair.owners.emplace_back(std::move(server));
+        return pair;
+    }
+
+    Pair unixPair() {
+
+#ifdef _WIN32
+        const std::string domain{"simple_socket_bench"};
+#else
+        const std::string domain{"/tmp/simple_socket_bench"};
+#endif
+
+        auto server = std::make_shared<UnixDomainServer>(domain);
+        UnixDomainClientContext ctx;
+
+        Pair pair;
+        pair.client = ctx.connect(domain);
+        if (!pair.client) throw std::runtime_error("Unix domain connect failed");
+        pair.server = server->accept();
+        pair.owners.emplace_back(std::move(server));
+        return pair;
+    }
+
+    Pair udpPair() {
+
+        const auto clientPort = getAvailablePort(8000, 9000);
+        if (!clientPort) throw std::runtime_error("No available port");
+        const auto serverPort = getAvailablePort(8000, 9000, {*clientPort});
+        if (!serverPort) throw std::runtime_error("No available port");
+
+        // room for bursts while streaming
+        SocketOptions options;
+        options.receiveBufferSize = 8 * 1024 * 1024;
+
+        auto client = std::make_shared<UDPSocket>(*clientPort, options);
+        auto server = std::make_shared<UDPSocket>(*serverPort, options);
+
+        Pair pair;
+        pair.client = client->makeConnection("127.0.0.1", *serverPort);
+        pair.server = server->makeConnection("127.0.0.1", *clientPort);
+        pair.owners.emplace_back(std::move(client));
+        pair.owners.emplace_back(std::move(server));
+        return pair;
+    }
+
+    // both ends own a socket connected to the other
+    Pair connectedUdpPair() {
+
+        const auto clientPort = getAvailablePort(8000, 9000);
+        if (!clientPort) throw std::runtime_error("No available port");
+        const auto serverPort = getAvailablePort(8000, 9000, {*clientPort});
+        if (!serverPort) throw std::runtime_error("No available port");
+
+        SocketOptions options;
+        options.receiveBufferSize = 8 * 1024 * 1024;
+        UDPClientContext ctx(options);
+
+        Pair pair;
+        pair.client = ctx.connect(Endpoint("127.0.0.1", *serverPort), *clientPort);
+        pair.server = ctx.connect(Endpoint("127.0.0.1", *clientPort), *serverPort);
+        if (!pair.client || !pair.server) throw std::runtime_error("UDP connect failed");
+        return pair;
+    }
+
+#ifdef SIMPLE_SOCKET_WITH_MEMORY
+    Pair sharedMemoryPair() {
+
+        // a fresh segment per run, left over semaphores of an earlier run would be in an unknown state
+        static int run = 0;
+        const auto name = "simple_socket_bench_" + std::to_string(Clock::now().time_since_epoch().count()) + "_" + std::to_string(run++);
+
+        Pair pair;
+        pair.server = std::make_unique<SharedMemoryConnection>(name, maxMessageSize, true);
+        pair.client = std::make_unique<SharedMemoryConnection>(name, maxMessageSize, false);
+        return pair;
+    }
+#endif
+
+    struct LatencyResult {
+        size_t iterations{0};
+        double mean{0};// microseconds
+        double p50{0};
+        double p99{0};
+        double p999{0};
+        size_t lost{0};// round trips that timed out (datagram transports)
+    };
+
+    struct ThroughputResult {
+        size_t messages{0};
+        double megabytesPerSecond{0};
+        double messagesPerSecond{0};
+        double loss{0};// fraction of messages not delivered (datagram transports)
+    };
+
+    struct Result {
+        std::string transport;
+        size_t size;
+        LatencyResult latency;
+        ThroughputResult throughput;
+    };
+
+    // Reads until the reply to the ping arrives, skipping late replies to earlier pings that already timed out.
+    IoStatus readReply(SimpleConnection& conn, const std::vector<uint8_t>& ping, std::vector<uint8_t>& reply, Clock::time_point deadline) {
+
+        const size_t tagSize = std::min(ping.size(), sizeof(uint64_t));
+        for (;;) {
+            const auto result = conn.readUntil(reply.data(), reply.size(), deadline);
+            if (!result) return result.status;
+            if (result.bytes == ping.size() && std::equal(ping.begin(), ping.begin() + tagSize, reply.begin())) return IoStatus::Ok;
+        }
+    }
+
+    // Datagrams are tagged with their round trip, a lost one (either way) times out instead of stalling the run.
+    LatencyResult pingPong(Pair& pair, size_t size, size_t iterations, bool datagram) {
+
+        const size_t warmup = std::max<size_t>(iterations / 10, 10);
+        const size_t total = warmup + iterations;
+
+        std::atomic_bool done{false};
+        std::thread echo([&pair, &done, size, total, datagram] {
+            std::vector<uint8_t> buffer(size);
+            if (!datagram) {
+                for (size_t i = 0; i < total; ++i) {
+                    if (!pair.server->readExact(buffer) || !pair.server->write(buffer)) return;
+                }
+                return;
+            }
+            // pings may be lost, so echo until the client is done rather than a fixed count
+            while (!done) {
+                const auto result = pair.server->readFor(buffer.data(), buffer.size(), datagramTimeout);
+                if (result.status == IoStatus::Timeout) continue;
+                if (!result || !pair.server->write(buffer.data(), result.bytes)) return;
+            }
+        });
+
+        std::vector<uint8_t> message(size, 'x');
+        std::vector<uint8_t> reply(size);
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        size_t lost = 0;
+        for (size_t i = 0; i < total; ++i) {
+            std::memcpy(message.data(), &i, std::min(size, sizeof(i)));
+            const auto start = Clock::now();
+            if (!pair.client->write(message)) break;
+            if (datagram) {
+                const auto status = readReply(*pair.client, message, reply, start + datagramTimeout);
+                if (status == IoStatus::Timeout) {
+                    if (i >= warmup) ++lost;
+                    continue;
+                }
+                if (status != IoStatus::Ok) break;
+            } else if (!pair.client->readExact(reply)) {
+                break;
+            }
+            if (i >= warmup) samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+        done = true;
+        echo.join();
+
+        if (samples.size() + lost != iterations) throw std::runtime_error("ping-pong interrupted");
+        if (samples.empty()) throw std::runtime_error("ping-pong lost every datagram");
+
+        std::ranges::sort(samples);
+        const auto at = [&samples](double q) {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(q * static_cast<double>(samples.size())))];
+        };
+
+        LatencyResult result;
+        result.iterations = iterations;
+        result.lost = lost;
+        for (const auto sample : samples) result.mean += sample;
+        result.mean /= static_cast<double>(samples.size());
+        result.p50 = at(0.5);
+        result.p99 = at(0.99);
+        result.p999 = at(0.999);
+        return result;
+    }
+
+    // The receiver acknowledges the last byte, so the time covers delivery and not just handing data to the kernel.
+    ThroughputResult streamReliable(Pair& pair, size_t size, size_t count) {
+
+        const size_t total = size * count;
+
+        std::thread receiver([&pair, size, total] {
+            std::vector<uint8_t> buffer(std::max<size_t>(size, 64 * 1024));
+            size_t received = 0;
+            while (received < total) {
+                const int n = pair.server->read(buffer);
+                if (n <= 0) return;
+                received += n;
+            }
+            const uint8_t ack = 1;
+            pair.server->write(&ack, 1);
+        });
+
+        const std::vector<uint8_t> message(size, 'x');
+        uint8_t ack = 0;
+
+        const auto start = Clock::now();
+        bool ok = true;
+        for (size_t i = 0; i < count && ok; ++i) ok = pair.client->write(message);
+        ok = ok && pair.client->readExact(&ack, 1);
+        const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        receiver.join();
+
+        if (!ok) throw std::runtime_error("stream interrupted");
+
+        ThroughputResult result;
+        result.messages = count;
+        result.megabytesPerSecond = static_cast<double>(total) / (1024.0 * 1024.0) / seconds;
+        result.messagesPerSecond = static_cast<double>(count) / seconds;
+        return result;
+    }
+
+    // Datagrams may be dropped, so the sender keeps sending a short end marker until the receiver saw one.
+    // The rate counts delivered datagrams up to the last one received.
+    ThroughputResult streamDatagrams(Pair& pair, size_t size, size_t count) {
+
+        const size_t markerSize = size == 1 ? 2 : 1;
+
+        std::atomic_bool done{false};
+        size_t delivered = 0;
+        Clock::time_point last;
+
+        const auto start = Clock::now();
+        std::thread receiver([&] {
+            std::vector<uint8_t> buffer(maxDatagramSize);
+            while (true) {
+                const int n = pair.server->read(buffer);
+                if (n < 0 || static_cast<size_t>(n) == markerSize) break;
+                ++delivered;
+                last = Clock::now();
+            }
+            done = true;
+        });
+
+        const std::vector<uint8_t> message(size, 'x');
+        for (size_t i = 0; i < count; ++i) pair.client->write(message);
+        while (!done) {
+            pair.client->write(message.data(), markerSize);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        receiver.join();
+
+        ThroughputResult result;
+        result.messages = count;
+        result.loss = 1.0 - static_cast<double>(delivered) / static_cast<double>(count);
+        if (delivered > 0) {
+            const auto seconds = std::chrono::duration<double>(last - start).count();
+            result.megabytesPerSecond = static_cast<double>(delivered * size) / (1024.0 * 1024.0) / seconds;
+            result.messagesPerSecond = static_cast<double>(delivered) / seconds;
+        }
+        return result;
+    }
+
+    // Enough round trips for a stable p99.9 on small messages, without spending minutes on large ones.
+    size_t iterationsFor(size_t size, bool quick) {
+        const size_t n = std::clamp<size_t>(512 * maxMessageSize / size, 200, 20000);
+        return quick ? std::max<size_t>(n / 10, 100) : n;
+    }
+
+    size_t messagesFor(size_t size, bool quick) {
+        const size_t n = std::clamp<size_t>(256 * maxMessageSize / size, 1000, 200000);
+        return quick ? std::max<size_t>(n / 10, 100) : n;
+    }
+
+    std::vector<std::string> split(const std::string& list) {
+        std::vector<std::string> items;
+        std::stringstream ss(list);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (!item.empty()) items.push_back(item);
+        }
+        return items;
+    }
+
+    void printHeader() {
+        std::cout << std::left << std::setw(10) << "transport" << std::right
+                  << std::setw(9) << "size"
+                  << std::setw(11) << "p50 us"
+                  << std::setw(11) << "p99 us"
+                  << std::setw(11) << "p99.9 us"
+                  << std::setw(11) << "MB/s"
+                  << std::setw(13) << "msg/s"
+                  << std::setw(8) << "loss" << std::endl;
+    }
+
+    void printResult(const Result& r) {
+        std::cout << std::left << std::setw(10) << r.transport << std::right << std::fixed
+                  << std::setw(9) << r.size
+                  << std::setprecision(1)
+                  << std::setw(11) << r.latency.p50
+                  << std::setw(11) << r.latency.p99
+                  << std::setw(11) << r.latency.p999
+                  << std::setw(11) << r.throughput.megabytesPerSecond
+                  << std::setprecision(0)
+                  << std::setw(13) << r.throughput.messagesPerSecond
+                  << std::setprecision(3)
+                  << std::setw(8) << r.throughput.loss << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+    }
+
+    void writeJson(std::ostream& out, const std::vector<Result>& results) {
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            out << "  {\"transport\": \"" << r.transport << "\", \"size\": " << r.size
+                << ", \"pingpong\": {\"iterations\": " << r.latency.iterations
+                << ", \"mean_us\": " << r.latency.mean
+                << ", \"p50_us\": " << r.latency.p50
+                << ", \"p99_us\": " << r.latency.p99
+                << ", \"p999_us\": " << r.latency.p999
+                << ", \"lost\": " << r.latency.lost
+                << "}, \"throughput\": {\"messages\": " << r.throughput.messages
+                << ", \"mb_per_s\": " << r.throughput.megabytesPerSecond
+                << ", \"messages_per_s\": " << r.throughput.messagesPerSecond
+                << ", \"loss\": " << r.throughput.loss << "}}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+
+}// namespace
+
+int main(int argc, char** argv) {
+
+    std::vector<Transport> transports{
+            {"tcp", false, tcpPair},
+            {"unix", false, unixPair},
+            {"udp", true, udpPair},
+            {"cudp", true, connectedUdpPair},
+#ifdef SIMPLE_SOCKET_WITH_MEMORY
+            {"shm", false, sharedMemoryPair},
+#endif
+    };
+
+    std::vector<size_t> sizes;
+    for (size_t size = 8; size <= maxMessageSize; size *= 8) sizes.push_back(size);
+    sizes.push_back(maxMessageSize);
+
+    std::optional<std::string> jsonPath;
+    std::vector<std::string> selected;
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--transports" && hasValue) {
+            selected = split(argv[++i]);
+        } else if (arg == "--sizes" && hasValue) {
+            sizes.clear();
+            for (const auto& s : split(argv[++i])) sizes.push_back(std::clamp<size_t>(std::stoul(s), 1, maxMessageSize));
+        } else if (arg == "--quick") {
+            quick = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--transports tcp,unix,udp,cudp,shm] [--sizes 8,64,...] [--quick] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!selected.empty()) {
+        std::erase_if(transports, [&selected](const Transport& t) {
+            return std::ranges::find(selected, t.name) == selected.end();
+        });
+    }
+
+    std::vector<Result> results;
+    printHeader();
+    for (const auto& transport : transports) {
+        for (const auto size : sizes) {
+            if (transport.datagram && size > maxDatagramSize) continue;
+
+            try {
+                Result result{transport.name, size, {}, {}};
+                {
+                    auto pair = transport.connect();
+                    result.latency = pingPong(pair, size, iterationsFor(size, quick), transport.datagram);
+                }
+                {
+                    // a fresh pair, so nothing left over from the previous run is read as a message
+                    auto pair = transport.connect();
+                    const auto count = messagesFor(size, quick);
+                    result.throughput = transport.datagram ? streamDatagrams(pair, size, count) : streamReliable(pair, size, count);
+                }
+                printResult(result);
+                results.push_back(result);
+            } catch (const std::exception& e) {
+                std::cerr << transport.name << " " << size << " B: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    if (jsonPath) {
+        std::ofstream out(*jsonPath);
+        if (!out) {
+            std::cerr << "Unable to write " << *jsonPath << std::endl;
+            return 1;
+        }
+        writeJson(out, results);
+    }
+}
@@ -0,0 +1,181 @@
+#include "simple_socket/UDPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace simple_socket;
+
+// Packets per second over UDP loopback with one system call per datagram (sendTo/recvFromAny) against
+// sendBatch/recvBatch, and against segmentation offload (sendSegmented, received with udpGro), for small
+// datagram sizes where the per call overhead dominates.
+//
+// usage: udp_batch_bench [--sizes 64,512,1400] [--batch 32] [--quick]
+//
+// The sender and receiver run on separate threads. Send rate is measured over the whole send loop, receive rate
+// from the first to the last datagram received; datagrams dropped by the kernel are reported as loss.
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode {
+        Single,
+        Batch,
+        Segmented
+    };
+
+    struct Result {
+        double sendRate{0};// datagrams/s
+        double recvRate{0};
+        double loss{0};
+    };
+
+    std::vector<std::string> split(const std::string& list) {
+
+        std::vector<std::string> parts;
+        std::stringstream ss(list);
+        std::string part;
+        while (std::getline(ss, part, ',')) {
+            if (!part.empty()) parts.push_back(part);
+        }
+        return parts;
+    }
+
+    Result run(Mode mode, size_t size, size_t count, size_t batch) {
+
+        const auto receiverPort = getAvailablePort(8000, 9000);
+        const auto senderPort = getAvailablePort(8000, 9000, {*receiverPort});
+        if (!receiverPort || !senderPort) throw std::runtime_error("No available port");
+
+        SocketOptions options;
+        options.receiveBufferSize = 8 * 1024 * 1024;
+        options.sendBufferSize = 8 * 1024 * 1024;
+        UDPSocket sender(*senderPort, options);
+        options.udpGro = mode == Mode::Segmented;
+        UDPSocket receiver(*receiverPort, options);
+
+        const Endpoint to("127.0.0.1", *receiverPort);
+
+        std::atomic_size_t received{0};
+        Clock::time_point first{}, last{};
+        std::thread reader([&] {
+            if (mode == Mode::Single) {
+                std::vector<uint8_t> buffer(size);
+                Endpoint from;
+                while (received < count) {
+                    if (receiver.recvFromAny(buffer, from) <= 0) break;
+                    if (received++ == 0) first = Clock::now();
+                    last = Clock::now();
+                }
+            } else {
+                // coalesced datagrams need room for a whole super datagram
+                const size_t capacity = mode == Mode::Segmented ? MAX_UDP_PACKET_SIZE : size;
+                std::vector<uint8_t> storage(capacity * batch);
+                std::vector<IncomingDatagram> datagrams(batch);
+                for (size_t i = 0; i < batch; ++i) datagrams[i] = {storage.data() + i * capacity, capacity};
+                while (received < count) {
+                    const auto n = receiver.recvBatch(datagrams);
+                    if (n <= 0) break;
+                    if (received == 0) first = Clock::now();
+                    for (int i = 0; i < n; ++i) {
+                        if (datagrams[i].size == 0) continue;// shutdown
+                        received += (datagrams[i].size + datagrams[i].segmentSize - 1) / datagrams[i].segmentSize;
+                    }
+                    last = Clock::now();
+                }
+            }
+        });
+
+        const std::vector<uint8_t> payload(size, 'x');
+        std::vector<OutgoingDatagram> datagrams(batch, {payload.data(), payload.size(), to});
+        const std::vector<uint8_t> segments(size * batch, 'x');
+
+        const auto start = Clock::now();
+        if (mode == Mode::Single) {
+            for (size_t i = 0; i < count; ++i) {
+                if (!sender.sendTo(to, payload)) throw std::runtime_error("sendTo failed");
+            }
+        } else if (mode == Mode::Segmented) {
+            for (size_t sent = 0; sent < count;) {
+                const auto n = std::min(batch, count - sent);
+                if (!sender.sendSegmented(to, segments.data(), n * size, size)) throw std::runtime_error("sendSegmented failed");
+                sent += n;
+            }
+        } else {
+            for (size_t sent = 0; sent < count;) {
+                const auto n = std::min(batch, count - sent);
+                if (sender.sendBatch(std::span(datagrams).first(n)) != n) throw std::runtime_error("sendBatch failed");
+                sent += n;
+            }
+        }
+        const auto sendTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+        // whatever was dropped will not come, unblock the reader
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        receiver.close();
+        reader.join();
+
+        Result result;
+        result.sendRate = count / sendTime;
+        const auto recvTime = std::chrono::duration<double>(last - first).count();
+        if (received > 1 && recvTime > 0) result.recvRate = (received - 1) / recvTime;
+        result.loss = 1.0 - static_cast<double>(received) / count;
+        return result;
+    }
+
+    void print(size_t size, const std::string& mode, const Result& result) {
+
+        std::cout << std::left << std::setw(8) << size << std::setw(10) << mode << std::right
+                  << std::fixed << std::setprecision(0)
+                  << std::setw(14) << result.sendRate
+                  << std::setw(14) << result.recvRate
+                  << std::setprecision(2) << std::setw(9) << result.loss * 100 << "%" << std::endl;
+    }
+
+}// namespace
+
+int main(int argc, char** argv) {
+
+    std::vector<size_t> sizes{64, 512, 1400};
+    size_t batch = 32;
+    bool quick = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--sizes" && hasValue) {
+            sizes.clear();
+            for (const auto& s : split(argv[++i])) sizes.push_back(std::clamp<size_t>(std::stoul(s), 1, MAX_UDP_PACKET_SIZE));
+        } else if (arg == "--batch" && hasValue) {
+            batch = std::max<size_t>(std::stoul(argv[++i]), 2);
+        } else if (arg == "--quick") {
+            quick = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--sizes 64,512,...] [--batch 32] [--quick]" << std::endl;
+            return 1;
+        }
+    }
+
+    const size_t count = quick ? 20000 : 500000;
+
+    std::cout << std::left << std::setw(8) << "size" << std::setw(10) << "mode" << std::right
+              << std::setw(14) << "send pkt/s" << std::setw(14) << "recv pkt/s" << std::setw(10) << "loss" << std::endl;
+    for (const auto size : sizes) {
+        try {
+            print(size, "single", run(Mode::Single, size, count, 1));
+            print(size, "batch" + std::to_string(batch), run(Mode::Batch, size, count, batch));
+            print(size, "gso" + std::to_string(batch), run(Mode::Segmented, size, count, batch));
+        } catch (const std::exception& e) {
+            std::cerr << size << " B: " << e.what() << std::endl;
+        }
+    }
+}
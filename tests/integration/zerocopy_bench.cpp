@@ -0,0 +1,110 @@
+
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace simple_socket;
+
+// Sends large blobs over loopback and reports sender CPU time per GB for the copying write() path
+// against zero-copy writeOwned() with buffer recycling.
+// Note that loopback delivery copies the pages on the receive side anyway, so the savings measured here
+// are a lower bound for what a real NIC achieves.
+//
+// usage: zerocopy_bench [totalMB=4096] [blobKB=1024]
+
+namespace {
+
+    // CPU seconds (user + system) consumed by the calling thread.
+    double threadCpuTime() {
+#ifdef RUSAGE_THREAD
+        rusage usage{};
+        getrusage(RUSAGE_THREAD, &usage);
+        const auto toSeconds = [](const timeval& tv) { return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) * 1e-6; };
+        return toSeconds(usage.ru_utime) + toSeconds(usage.ru_stime);
+#else
+        return 0;
+#endif
+    }
+
+    struct Result {
+        double seconds;
+        double cpuSeconds;
+    };
+
+    Result run(bool zeroCopy, size_t totalBytes, size_t blobSize) {
+
+        // a fresh port per run, the previous one lingers in TIME_WAIT
+        const auto port = getAvailablePort(8000, 9000);
+        if (!port) throw std::runtime_error("No available port");
+
+        TCPServer server(*port);
+
+        std::thread receiver([&server, totalBytes] {
+            const auto conn = server.accept();
+            std::vector<uint8_t> buffer(1024 * 1024);
+            size_t received = 0;
+            int n;
+            while (received < totalBytes && (n = conn->read(buffer)) > 0) {
+                received += n;
+            }
+        });
+
+        TCPClientContext ctx;
+        const auto conn = ctx.connect("127.0.0.1", *port);
+        if (!conn) throw std::runtime_error("connect failed");
+        if (zeroCopy && !conn->enableZeroCopy()) {
+            std::cerr << "zero-copy not supported, falling back to copies" << std::endl;
+        }
+
+        // a small ring of blobs is recycled through the release handler
+        std::vector<std::vector<uint8_t>> freeBlobs;
+        for (int i = 0; i < 4; ++i) freeBlobs.emplace_back(blobSize, static_cast<uint8_t>(i));
+        const auto recycle = [&freeBlobs](std::vector<uint8_t> blob) { freeBlobs.push_back(std::move(blob)); };
+
+        const auto cpuStart = threadCpuTime();
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t sent = 0; sent < totalBytes; sent += blobSize) {
+            if (zeroCopy) {
+                if (freeBlobs.empty()) conn->flush();
+                auto blob = std::move(freeBlobs.back());
+                freeBlobs.pop_back();
+                if (!conn->writeOwned(std::move(blob), recycle)) break;
+            } else {
+                if (!conn->write(freeBlobs.front())) break;
+            }
+        }
+        conn->flush();
+        const auto cpuSeconds = threadCpuTime() - cpuStart;
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        receiver.join();
+        server.close();
+        return {seconds, cpuSeconds};
+    }
+
+    void report(const std::string& name, const Result& r, size_t totalBytes) {
+        const double gb = static_cast<double>(totalBytes) / (1024.0 * 1024.0 * 1024.0);
+        std::cout << name << ": " << gb / r.seconds << " GB/s, "
+                  << r.cpuSeconds / gb << " CPU s/GB (sender)" << std::endl;
+    }
+
+}// namespace
+
+int main(int argc, char** argv) {
+
+    const size_t totalBytes = (argc > 1 ? std::stoul(argv[1]) : 4096) * 1024 * 1024;
+    const size_t blobSize = (argc > 2 ? std::stoul(argv[2]) : 1024) * 1024;
+
+    report("write      ", run(false, totalBytes, blobSize), totalBytes);
+    report("writeOwned ", run(true, totalBytes, blobSize), totalBytes);
+}
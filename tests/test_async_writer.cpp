@@ -0,0 +1,230 @@
+
+#include "simple_socket/AsyncWriter.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#ifdef SIMPLE_SOCKET_WITH_MQTT
+#include "simple_socket/mqtt/MQTTBroker.hpp"
+#endif
+
+#include "test_util.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+namespace {
+
+    struct Pair {
+        std::unique_ptr<TCPServer> server;
+        std::unique_ptr<SimpleConnection> client;
+        std::unique_ptr<SimpleConnection> peer;
+    };
+
+    Pair connectPair() {
+
+        const auto port = getAvailablePort(8000, 9000);
+        REQUIRE(port);
+
+        Pair pair;
+        pair.server = std::make_unique<TCPServer>(*port);
+        TCPClientContext ctx;
+        pair.client = ctx.connect("127.0.0.1", *port);
+        REQUIRE(pair.client);
+        pair.peer = pair.server->accept();
+        return pair;
+    }
+
+}// namespace
+
+TEST_CASE("Async writes arrive in order") {
+
+    auto pair = connectPair();
+    AsyncWriter writer(*pair.client);
+
+    for (uint8_t i = 0; i < 100; ++i) {
+        const std::vector<uint8_t> message(100, i);
+        REQUIRE(writer.writeAsync(message));
+    }
+    CHECK(writer.writeAsync({ConstBuffer{"ab", 2}, ConstBuffer{"c", 1}}));
+    CHECK(writer.flush());
+    CHECK(writer.queuedBytes() == 0);
+
+    std::vector<uint8_t> received(100 * 100 + 3);
+    REQUIRE(pair.peer->readExact(received));
+    for (size_t i = 0; i < 100 * 100; ++i) {
+        if (received[i] != i / 100) FAIL("out of order at " << i);
+    }
+    CHECK(std::string(received.end() - 3, received.end()) == "abc");
+}
+
+TEST_CASE("Async writer backpressure with a stalled peer") {
+
+    std::vector<uint8_t> message(64 * 1024, 'x');
+
+    SECTION("drop oldest") {
+        auto pair = connectPair();
+
+        std::vector<bool> signals;
+        WriteQueueOptions options;
+        options.highWatermark = 256 * 1024;
+        options.lowWatermark = 64 * 1024;
+        options.overflow = OverflowPolicy::DropOldest;
+        options.onBackpressure = [&signals](bool congested) {
+            signals.push_back(congested);
+        };
+        AsyncWriter writer(*pair.client, options);
+
+        // far more than the socket buffers hold, the peer never reads
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 1000; ++i) REQUIRE(writer.writeAsync(message));
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+        CHECK(writer.dropped() > 0);
+        CHECK(writer.queuedBytes() <= options.highWatermark + message.size());
+        REQUIRE(!signals.empty());
+        CHECK(signals.front());
+
+        // draining lifts the backpressure again
+        std::thread reader([&pair] {
+            std::vector<uint8_t> buffer(64 * 1024);
+            while (pair.peer->read(buffer) > 0) {}
+        });
+        CHECK(writer.flush());
+        CHECK(signals.back() == false);
+
+        writer.close();
+        pair.client->close();
+        reader.join();
+    }
+
+    SECTION("disconnect") {
+        auto pair = connectPair();
+
+        WriteQueueOptions options;
+        options.highWatermark = 256 * 1024;
+        options.overflow = OverflowPolicy::Disconnect;
+        AsyncWriter writer(*pair.client, options);
+
+        bool accepted = true;
+        for (int i = 0; i < 1000 && accepted; ++i) accepted = writer.writeAsync(message);
+        CHECK_FALSE(accepted);
+        CHECK(writer.closed());
+        CHECK_FALSE(writer.writeAsync(message));
+    }
+
+    SECTION("block") {
+        auto pair = connectPair();
+
+        WriteQueueOptions options;
+        options.highWatermark = 256 * 1024;
+        options.overflow = OverflowPolicy::Block;
+        AsyncWriter writer(*pair.client, options);
+
+        const size_t count = 200;
+        std::thread reader([&pair, total = count * message.size()] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            std::vector<uint8_t> buffer(total);
+            REQUIRE(pair.peer->readExact(buffer));
+        });
+
+        for (size_t i = 0; i < count; ++i) REQUIRE(writer.writeAsync(message));
+        CHECK(writer.flush());
+        CHECK(writer.dropped() == 0);
+        reader.join();
+    }
+}
+
+TEST_CASE("Async writers share their threads") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+    TCPServer server(*port);
+    TCPClientContext ctx;
+
+    std::vector<std::unique_ptr<SimpleConnection>> clients;
+    std::vector<std::unique_ptr<SimpleConnection>> peers;
+    for (int i = 0; i < 20; ++i) {
+        clients.emplace_back(ctx.connect("127.0.0.1", *port));
+        REQUIRE(clients.back());
+        peers.emplace_back(server.accept());
+    }
+
+#ifdef __linux__
+    const auto threadCount = [] {
+        return std::distance(std::filesystem::directory_iterator("/proc/self/task"), std::filesystem::directory_iterator{});
+    };
+    const auto threadsBefore = threadCount();
+#endif
+
+    std::vector<std::unique_ptr<AsyncWriter>> writers;
+    for (auto& client : clients) writers.emplace_back(std::make_unique<AsyncWriter>(*client));
+
+    // the first peer never reads, its writer stalls without holding up the others
+    const std::vector<uint8_t> large(64 * 1024, 'x');
+    for (int i = 0; i < 400; ++i) REQUIRE(writers[0]->writeAsync(large));
+    for (size_t i = 1; i < writers.size(); ++i) REQUIRE(writers[i]->writeAsync(std::string("hello")));
+
+    for (size_t i = 1; i < peers.size(); ++i) {
+        std::vector<uint8_t> received(5);
+        REQUIRE(peers[i]->readExactFor(received.data(), received.size(), std::chrono::seconds(2)));
+        CHECK(std::string(received.begin(), received.end()) == "hello");
+    }
+    CHECK(writers[0]->queuedBytes() + writers[0]->dropped() > 0);
+
+#ifdef __linux__
+    // no thread per writer
+    CHECK(threadCount() <= threadsBefore + 2);
+#endif
+    writers.clear();
+    server.close();
+}
+
+#ifdef SIMPLE_SOCKET_WITH_MQTT
+TEST_CASE("MQTT broker is not held up by a stalled subscriber") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    MQTTBroker broker(*port);
+    broker.start();
+
+    TCPClientContext ctx;
+
+    auto stalled = test::mqttConnect(ctx, *port, 's');// subscribes and never reads again
+    test::mqttSubscribe(*stalled);
+    auto subscriber = test::mqttConnect(ctx, *port, 'f');
+    test::mqttSubscribe(*subscriber);
+    auto publisher = test::mqttConnect(ctx, *port, 'p');
+
+    // 8 KB payloads: remaining length 8197 encoded in two bytes
+    constexpr size_t payload = 8 * 1024;
+    constexpr size_t remaining = 5 + payload;
+    std::vector<uint8_t> publish{0x30, static_cast<uint8_t>((remaining & 0x7F) | 0x80), static_cast<uint8_t>(remaining >> 7), 0x00, 0x03, 'a', '/', 'b'};
+    publish.resize(publish.size() + payload, 'x');
+
+    // far more than the stalled subscriber's socket buffers and queue hold, in lock step with the other subscriber
+    constexpr int count = 4000;
+    std::vector<uint8_t> forwarded(publish.size());
+    int received = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!publisher->write(publish)) break;
+        if (!subscriber->readExactFor(forwarded.data(), forwarded.size(), std::chrono::seconds(5))) break;
+        ++received;
+    }
+    CHECK(received == count);
+    CHECK(forwarded == publish);
+
+    publisher->close();
+    subscriber->close();
+    stalled->close();
+    broker.stop();
+}
+#endif
@@ -0,0 +1,254 @@
+
+#include "simple_socket/BufferPool.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#ifdef SIMPLE_SOCKET_WITH_WEBSOCKETS
+#include "simple_socket/ws/WebSocket.hpp"
+#endif
+#if defined(SIMPLE_SOCKET_WITH_MQTT) || defined(SIMPLE_SOCKET_WITH_MODBUS)
+#include "simple_socket/TCPSocket.hpp"
+#endif
+#ifdef SIMPLE_SOCKET_WITH_MQTT
+#include "simple_socket/mqtt/MQTTBroker.hpp"
+#endif
+#ifdef SIMPLE_SOCKET_WITH_MODBUS
+#include "simple_socket/modbus/ModbusServer.hpp"
+#endif
+
+#include "test_util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+// Count every heap allocation in the process.
+namespace {
+    std::atomic_size_t allocations{0};
+}
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+using simple_socket::test::waitFor;
+
+TEST_CASE("Buffer pool size classes") {
+
+    BufferPool pool(4096);
+
+    auto small = pool.acquire(10);
+    CHECK(small.size() == 10);
+    CHECK(small.capacity() == 64);
+
+    auto medium = pool.acquire(1000);
+    CHECK(medium.capacity() == 1024);
+
+    auto large = pool.acquire(10000);// beyond the largest class
+    CHECK(large.size() == 10000);
+
+    // released blocks are handed out again
+    const auto address = medium.data();
+    medium.release();
+    CHECK(medium.empty());
+    auto again = pool.acquire(600);
+    CHECK(again.data() == address);
+
+    // growing keeps the content
+    small[0] = 42;
+    small.resize(100);
+    CHECK(small.capacity() == 128);
+    CHECK(small[0] == 42);
+
+    BufferPool::Buffer moved = std::move(small);
+    CHECK(moved[0] == 42);
+    CHECK(small.data() == nullptr);
+}
+
+TEST_CASE("Buffer pool steady state") {
+
+    BufferPool pool;
+
+    const auto cycle = [&pool] {
+        for (size_t size = 1; size < 64 * 1024; size *= 2) {
+            auto a = pool.acquire(size);
+            auto b = pool.acquire(size + 1);
+            a[0] = b[0] = 1;
+        }
+    };
+
+    cycle();// warm up
+    const auto heapBefore = pool.heapAllocations();
+    const auto before = allocations.load();
+    for (int i = 0; i < 1000; ++i) cycle();
+    const auto after = allocations.load();
+    CHECK(after == before);
+    CHECK(pool.heapAllocations() == heapBefore);
+
+    // blocks released on another thread are reused instead of growing the pool
+    std::vector<BufferPool::Buffer> handoff;
+    handoff.reserve(1000);
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 1000; ++i) handoff.emplace_back(pool.acquire(256));
+        std::thread([&handoff] { handoff.clear(); }).join();
+    }
+    CHECK(pool.heapAllocations() < heapBefore + 10);
+}
+
+#ifdef SIMPLE_SOCKET_WITH_WEBSOCKETS
+TEST_CASE("WebSocket messages do not allocate in steady state") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    std::atomic_size_t received{0};
+    std::atomic<WebSocketConnection*> clientConnection{nullptr};
+
+    WebSocket ws(*port);
+    ws.onMessage = [&](auto, const auto&) {
+        ++received;
+    };
+    ws.start();
+
+    WebSocketClient client;
+    client.onOpen = [&](auto c) {
+        clientConnection = c;
+    };
+    client.connect("ws://127.0.0.1:" + std::to_string(*port));
+    REQUIRE(waitFor([&] { return clientConnection.load() != nullptr; }));
+
+    const std::vector<uint8_t> message(200, 'x');
+    const auto sendAll = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i) clientConnection.load()->send(message.data(), message.size());
+    };
+
+    sendAll(100);
+    REQUIRE(waitFor([&] { return received == 100; }));
+
+    const auto before = allocations.load();
+    sendAll(1000);
+    const bool ok = waitFor([&] { return received == 1100; });
+    const auto after = allocations.load();
+    REQUIRE(ok);
+    CHECK(after == before);
+
+    client.close();
+    ws.stop();
+}
+#endif
+
+#ifdef SIMPLE_SOCKET_WITH_MQTT
+TEST_CASE("MQTT broker forwards without allocating in steady state") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    MQTTBroker broker(*port);
+    broker.start();
+
+    TCPClientContext ctx;
+
+    auto subscriber = test::mqttConnect(ctx, *port, 's');
+    test::mqttSubscribe(*subscriber);
+
+    auto publisher = test::mqttConnect(ctx, *port, 'p');
+    std::vector<uint8_t> publish{0x30, 5 + 64, 0x00, 0x03, 'a', '/', 'b'};
+    publish.resize(publish.size() + 64, 'x');
+    std::vector<uint8_t> forwarded(publish.size());
+
+    // no assertions inside the measured loop, the test framework may allocate
+    const auto roundTrips = [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            if (!publisher->write(publish.data(), publish.size())) return false;
+            if (!subscriber->readExact(forwarded.data(), forwarded.size())) return false;
+        }
+        return true;
+    };
+
+    REQUIRE(roundTrips(100));
+    const auto before = allocations.load();
+    const bool ok = roundTrips(1000);
+    const auto after = allocations.load();
+    REQUIRE(ok);
+    CHECK(after == before);
+    CHECK(forwarded == publish);
+
+    publisher->close();
+    subscriber->close();
+    broker.stop();
+}
+#endif
+
+#ifdef SIMPLE_SOCKET_WITH_MODBUS
+TEST_CASE("Modbus server answers requests without allocating in steady state") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    HoldingRegister reg(8);
+    for (uint16_t i = 0; i < 4; ++i) reg.setUint16(i, 100 + i);
+
+    ModbusServer server(reg, *port);
+    server.start();
+
+    TCPClientContext ctx;
+    auto conn = ctx.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+
+    // Read Holding Registers 0-3: MBAP header (length 6), unit, function, start address and quantity
+    const std::vector<uint8_t> request{0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x01, 0x03, 0x00, 0x00, 0x00, 0x04};
+    std::vector<uint8_t> response(9 + 4 * 2);
+
+    // no assertions inside the measured loop, the test framework may allocate
+    const auto roundTrips = [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            if (!conn->write(request.data(), request.size())) return false;
+            if (!conn->readExact(response.data(), response.size())) return false;
+        }
+        return true;
+    };
+
+    REQUIRE(roundTrips(100));
+    const auto before = allocations.load();
+    const bool ok = roundTrips(1000);
+    const auto after = allocations.load();
+    REQUIRE(ok);
+    CHECK(after == before);
+    CHECK(response[7] == 0x03);
+    CHECK(response[8] == 4 * 2);
+    CHECK(response[15] == 0);
+    CHECK(response[16] == 103);
+
+    conn->close();
+    server.stop();
+}
+#endif
@@ -0,0 +1,123 @@
+
+#include "simple_socket/EventLoop.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+namespace {
+
+    Task<> echo(std::unique_ptr<AsyncConnection> conn) {
+
+        std::vector<uint8_t> buffer(1024);
+        int n;
+        while ((n = co_await conn->asyncRead(buffer)) > 0) {
+            if (!co_await conn->asyncWrite(buffer.data(), n)) break;
+        }
+    }
+
+    Task<> serve(EventLoop& loop, TCPServer& server, int numClients) {
+
+        for (int i = 0; i < numClients; ++i) {
+            loop.spawn(echo(co_await server.asyncAccept(loop)));
+        }
+    }
+
+    Task<> client(EventLoop& loop, uint16_t port, int id, int& done, int numClients) {
+
+        TCPClientContext ctx;
+        AsyncConnection conn(loop, ctx.connect("127.0.0.1", port));
+
+        // larger than the socket buffers, so the write has to wait for the echo to be read
+        std::vector<uint8_t> data(512 * 1024);
+        std::iota(data.begin(), data.end(), static_cast<uint8_t>(id));
+
+        std::vector<uint8_t> received(data.size());
+        bool sent = false;
+        loop.spawn([](AsyncConnection& conn, const std::vector<uint8_t>& data, bool& sent) -> Task<> {
+            sent = co_await conn.asyncWrite(data);
+        }(conn, data, sent));
+
+        const bool read = co_await conn.asyncReadExact(received);
+        CHECK(read);
+        CHECK(sent);
+        CHECK(received == data);
+
+        if (++done == numClients) loop.stop();
+    }
+
+}// namespace
+
+TEST_CASE("Event loop echo") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    constexpr int numClients = 8;
+
+    EventLoop loop;
+    TCPServer server(*port, numClients);
+
+    int done = 0;
+    loop.spawn(serve(loop, server, numClients));
+    for (int i = 0; i < numClients; ++i) {
+        loop.spawn(client(loop, *port, i, done, numClients));
+    }
+
+    loop.run();
+    CHECK(done == numClients);
+}
+
+TEST_CASE("Event loop task results and errors") {
+
+    EventLoop loop;
+
+    const auto twice = [](int value) -> Task<int> {
+        co_return value * 2;
+    };
+
+    int result = 0;
+    loop.spawn([](EventLoop& loop, auto twice, int& result) -> Task<> {
+        result = co_await twice(co_await twice(5));
+        loop.stop();
+    }(loop, twice, result));
+    loop.run();
+    CHECK(result == 20);
+
+    loop.spawn([]() -> Task<> {
+        throw std::runtime_error("failed");
+        co_return;
+    }());
+    CHECK_THROWS_AS(loop.run(), std::runtime_error);
+}
+
+TEST_CASE("Event loop concurrent accepts") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    constexpr int numAcceptors = 4;
+    constexpr int numClients = 8;
+
+    EventLoop loop;
+    TCPServer server(*port, numClients);
+
+    // the acceptors are all waiting on the listener before the first client connects
+    int done = 0;
+    for (int i = 0; i < numAcceptors; ++i) {
+        loop.spawn(serve(loop, server, numClients / numAcceptors));
+    }
+    for (int i = 0; i < numClients; ++i) {
+        loop.spawn(client(loop, *port, i, done, numClients));
+    }
+
+    loop.run();
+    CHECK(done == numClients);
+}
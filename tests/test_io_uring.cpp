@@ -0,0 +1,110 @@
+
+#include "simple_socket/IoUring.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+TEST_CASE("io_uring synchronous read/write") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    IoUringContext ctx;
+    IoUringServer server(ctx, *port);
+
+    std::thread serverThread([&server] {
+        auto conn = server.accept();
+        REQUIRE(conn);
+
+        std::vector<uint8_t> buffer(1024);
+        int n;
+        while ((n = conn->read(buffer)) > 0) {
+            REQUIRE(conn->write(buffer.data(), n));
+        }
+    });
+
+    auto conn = ctx.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+
+    // larger than one registered buffer
+    std::string message(64 * 1024, 'x');
+    for (size_t i = 0; i < message.size(); ++i) message[i] = static_cast<char>('a' + i % 26);
+
+    REQUIRE(conn->write(message));
+    std::vector<uint8_t> response(message.size());
+    REQUIRE(conn->readExact(response));
+    CHECK(std::string(response.begin(), response.end()) == message);
+
+    conn->close();
+    serverThread.join();
+}
+
+TEST_CASE("io_uring completion based echo") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    IoUringContext ctx;
+    IoUringServer server(ctx, *port);
+
+    struct Session {
+        std::unique_ptr<IoUringConnection> conn;
+        std::vector<uint8_t> buffer = std::vector<uint8_t>(256);
+    };
+    std::vector<std::unique_ptr<Session>> sessions;
+
+    std::function<void(Session&)> echo = [&](Session& s) {
+        s.conn->asyncRead(s.buffer.data(), s.buffer.size(), [&](int n) {
+            if (n <= 0) return;
+            s.conn->asyncWrite(s.buffer.data(), n, [&](int written) {
+                if (written > 0) echo(s);
+            });
+        });
+    };
+
+    constexpr int numClients = 8;
+    std::function<void(std::unique_ptr<IoUringConnection>)> onAccept = [&](std::unique_ptr<IoUringConnection> conn) {
+        if (!conn) return;
+        auto& s = *sessions.emplace_back(std::make_unique<Session>());
+        s.conn = std::move(conn);
+        echo(s);
+        if (sessions.size() < numClients) server.asyncAccept(onAccept);
+    };
+    server.asyncAccept(onAccept);
+
+    std::atomic_bool stop{false};
+    std::thread loop([&] {
+        while (!stop) ctx.run();
+    });
+
+    std::vector<std::thread> clients;
+    for (int i = 0; i < numClients; ++i) {
+        clients.emplace_back([i, port] {
+            TCPClientContext client;
+            auto conn = client.connect("127.0.0.1", *port);
+            REQUIRE(conn);
+            for (int round = 0; round < 10; ++round) {
+                const auto message = "client " + std::to_string(i) + " round " + std::to_string(round);
+                REQUIRE(conn->write(message));
+                std::vector<uint8_t> response(message.size());
+                REQUIRE(conn->readExact(response));
+                CHECK(std::string(response.begin(), response.end()) == message);
+            }
+        });
+    }
+    for (auto& t : clients) t.join();
+
+    // the peers are gone, so every pending read completes with EOF
+    while (ctx.inFlight() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(sessions.size() == numClients);
+
+    stop = true;
+    loop.join();
+}
@@ -0,0 +1,124 @@
+
+#include "simple_socket/Metrics.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#ifdef SIMPLE_SOCKET_WITH_WEBSOCKETS
+#include "simple_socket/ws/WebSocket.hpp"
+#endif
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+TEST_CASE("Metrics counters and histograms") {
+
+    Metrics metrics;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&metrics] {
+            for (int i = 0; i < 1000; ++i) {
+                metrics.add(Metrics::Counter::BytesIn, 10);
+                metrics.record(Metrics::Latency::Read, std::chrono::nanoseconds(1000));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    metrics.add(Metrics::Counter::QueueDepth, 3);
+    metrics.add(Metrics::Counter::QueueDepth, -1);
+    metrics.record(Metrics::Latency::Write, std::chrono::microseconds(100));
+
+    const auto snapshot = metrics.snapshot();
+    CHECK(snapshot.bytesIn == 40000);
+    CHECK(snapshot.queueDepth == 2);
+    CHECK(snapshot.readLatency.count == 4000);
+    CHECK(snapshot.readLatency.mean() == std::chrono::nanoseconds(1000));
+    CHECK(snapshot.readLatency.percentile(0.99) == std::chrono::nanoseconds(1024));
+    CHECK(snapshot.writeLatency.count == 1);
+    CHECK(snapshot.writeLatency.percentile(0.5) == std::chrono::nanoseconds(131072));
+    CHECK(Metrics().snapshot().readLatency.percentile(0.5) == std::chrono::nanoseconds(0));
+}
+
+TEST_CASE("TCP connection metrics") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    const auto metrics = std::make_shared<Metrics>();
+
+    TCPServer server(*port);
+    std::thread serverThread([&server, metrics] {
+        auto conn = server.accept();
+        conn->setMetrics(metrics);
+
+        std::vector<uint8_t> buffer(100);
+        REQUIRE(conn->readExact(buffer));
+        REQUIRE(conn->write(buffer));
+    });
+
+    TCPClientContext client;
+    auto conn = client.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+
+    const std::vector<uint8_t> message(100, 'x');
+    REQUIRE(conn->write(message));
+    std::vector<uint8_t> echo(100);
+    REQUIRE(conn->readExact(echo));
+    serverThread.join();// the server side connection is closed when the thread returns
+
+    const auto snapshot = metrics->snapshot();
+    CHECK(snapshot.bytesIn == 100);
+    CHECK(snapshot.bytesOut == 100);
+    CHECK(snapshot.readCalls >= 1);
+    CHECK(snapshot.writeCalls >= 1);
+    CHECK(snapshot.readLatency.count >= 1);
+    CHECK(snapshot.writeLatency.count >= 1);
+    CHECK(snapshot.connectionsOpened == 1);
+    CHECK(snapshot.connectionsClosed == 1);
+    CHECK(snapshot.queueDepth == 0);
+}
+
+#ifdef SIMPLE_SOCKET_WITH_WEBSOCKETS
+TEST_CASE("WebSocket server metrics") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    std::atomic_int received{0};
+    std::atomic<WebSocketConnection*> clientConnection{nullptr};
+
+    WebSocket ws(*port);
+    ws.onMessage = [&](auto, const auto&) {
+        ++received;
+    };
+    ws.start();
+
+    WebSocketClient client;
+    client.onOpen = [&](auto c) {
+        clientConnection = c;
+    };
+    client.connect("ws://127.0.0.1:" + std::to_string(*port));
+
+    for (int i = 0; i < 100 && !clientConnection; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(clientConnection.load());
+
+    for (int i = 0; i < 10; ++i) clientConnection.load()->send("hello");
+    for (int i = 0; i < 100 && received < 10; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(received == 10);
+
+    const auto snapshot = ws.metrics();
+    CHECK(snapshot.connectionsOpened == 1);
+    CHECK(snapshot.messagesIn == 10);
+    CHECK(snapshot.bytesIn > 10 * 5);// handshake and frame headers included
+
+    client.close();
+    ws.stop();
+}
+#endif
@@ -0,0 +1,93 @@
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/mqtt/MQTTBroker.hpp"
+#include "simple_socket/mqtt/MQTTClient.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include "test_util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+using simple_socket::test::waitFor;
+
+TEST_CASE("MQTT client publishing only stays connected past its keepalive") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    MQTTBroker broker(*port);
+    broker.start();
+
+    constexpr std::chrono::seconds keepAlive{1};
+
+    std::atomic_int received{0};
+    MQTTClient subscriber("127.0.0.1", *port, "subscriber", keepAlive);
+    subscriber.connect();
+    subscriber.subscribe("a/b", [&](const std::string&) { ++received; });
+    subscriber.run();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // the publisher sends all the time but never receives anything besides its PINGRESPs
+    MQTTClient publisher("127.0.0.1", *port, "publisher", keepAlive);
+    publisher.connect();
+    publisher.run();
+
+    constexpr int count = 40;
+    for (int i = 0; i < count; ++i) {
+        publisher.publish("a/b", std::to_string(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    CHECK(waitFor([&] { return received == count; }, std::chrono::seconds(2)));
+    CHECK(received == count);
+
+    publisher.close();
+    subscriber.close();
+    broker.stop();
+}
+
+TEST_CASE("MQTT client closes the connection when pings go unanswered") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+    std::unique_ptr<SimpleConnection> conn;
+    std::thread acceptor([&] {
+        conn = server.accept();
+        // CONNECT (short enough for a single byte remaining length), answered with a CONNACK and then nothing
+        uint8_t header[2];
+        if (!conn->readExact(header, sizeof(header))) return;
+        std::vector<uint8_t> connect(header[1]);
+        if (!conn->readExact(connect)) return;
+        const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+        conn->write(connack, sizeof(connack));
+    });
+
+    MQTTClient client("127.0.0.1", *port, "client", std::chrono::seconds(1));
+    client.connect();
+    acceptor.join();
+    REQUIRE(conn);
+    client.run();
+
+    const auto start = std::chrono::steady_clock::now();
+    uint8_t ping[2];
+    REQUIRE(conn->readExactFor(ping, sizeof(ping), std::chrono::seconds(2)));
+    CHECK(ping[0] == 0xC0);
+
+    // half a keepalive without a PINGRESP
+    uint8_t byte;
+    const auto result = conn->readFor(&byte, 1, std::chrono::seconds(5));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(result.status == IoStatus::Closed);
+    CHECK(elapsed >= std::chrono::milliseconds(900));
+    CHECK(elapsed < std::chrono::seconds(3));
+
+    client.close();
+    server.close();
+}
@@ -0,0 +1,200 @@
+
+#include "simple_socket/Reactor.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/UnixDomainSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include "test_util.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+namespace {
+
+    ReactorCallbacks echoCallbacks(Reactor& reactor, std::atomic_int& closed) {
+        ReactorCallbacks callbacks;
+        callbacks.onReadable = [&reactor](SimpleConnection& conn) {
+            std::vector<unsigned char> buffer(1024);
+            const auto bytesRead = conn.read(buffer);
+            if (bytesRead == SimpleConnection::WouldBlock) return;
+            if (bytesRead <= 0) {
+                reactor.remove(conn);
+                return;
+            }
+            conn.write(buffer.data(), bytesRead);
+        };
+        callbacks.onClose = [&closed](SimpleConnection&) {
+            ++closed;
+        };
+        return callbacks;
+    }
+
+    void echoRoundTrip(SimpleConnection& conn, const std::string& message) {
+        REQUIRE(conn.write(message));
+
+        std::vector<unsigned char> buffer(message.size());
+        REQUIRE(conn.readExact(buffer));
+        CHECK(std::string(buffer.begin(), buffer.end()) == message);
+    }
+
+}// namespace
+
+TEST_CASE("Reactor TCP echo") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port, 64);
+    std::atomic_int closed{0};
+
+    Reactor reactor(2);
+    server.attach(reactor, [&](SimpleConnection&) {
+        return echoCallbacks(reactor, closed);
+    });
+    reactor.start();
+
+    constexpr int numClients = 50;
+    TCPClientContext ctx;
+    std::vector<std::unique_ptr<SimpleConnection>> clients;
+    for (int i = 0; i < numClients; ++i) {
+        auto conn = ctx.connect("127.0.0.1", *port);
+        REQUIRE(conn);
+        clients.emplace_back(std::move(conn));
+    }
+
+    // several round trips per connection, all serviced by two threads
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < numClients; ++i) {
+            echoRoundTrip(*clients[i], "client " + std::to_string(i) + " round " + std::to_string(round));
+        }
+    }
+
+    CHECK(reactor.size() == numClients + 1);// + listening socket
+
+    clients.clear();
+    for (int i = 0; i < 100 && closed < numClients; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(closed == numClients);
+    CHECK(reactor.size() == 1);
+
+    reactor.stop();
+    server.close();
+}
+
+TEST_CASE("Reactor read without data") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+    TCPClientContext ctx;
+    auto client = ctx.connect("127.0.0.1", *port);
+    REQUIRE(client);
+    auto conn = server.accept();
+    REQUIRE(conn);
+
+    // watching switches the connection to non-blocking, the reactor does not need to run for that
+    Reactor reactor;
+    REQUIRE(reactor.watch(*conn, {}));
+
+    std::vector<unsigned char> buffer(16);
+    CHECK(conn->read(buffer) == SimpleConnection::WouldBlock);
+    CHECK(conn->readv({MutableBuffer{buffer.data(), 8}, MutableBuffer{buffer.data() + 8, 8}}) == SimpleConnection::WouldBlock);
+
+    REQUIRE(client->write(std::string("x")));
+    int n = SimpleConnection::WouldBlock;
+    for (int i = 0; i < 100 && n == SimpleConnection::WouldBlock; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        n = conn->read(buffer);
+    }
+    CHECK(n == 1);
+
+    // only the peer closing is reported as -1
+    client->close();
+    n = SimpleConnection::WouldBlock;
+    for (int i = 0; i < 100 && n == SimpleConnection::WouldBlock; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        n = conn->read(buffer);
+    }
+    CHECK(n == -1);
+
+    reactor.remove(*conn);
+    server.close();
+}
+
+TEST_CASE("Reactor UNIX domain echo") {
+
+#ifdef _WIN32
+    const std::string domain{"afunix_reactor_socket"};
+#else
+    const std::string domain{"/tmp/unix_reactor_socket"};
+#endif
+
+    UnixDomainServer server(domain, 16);
+    std::atomic_int closed{0};
+
+    Reactor reactor;
+    server.attach(reactor, [&](SimpleConnection&) {
+        return echoCallbacks(reactor, closed);
+    });
+    reactor.start();
+
+    UnixDomainClientContext ctx;
+    auto conn = ctx.connect(domain);
+    REQUIRE(conn);
+
+    echoRoundTrip(*conn, "Hello");
+    echoRoundTrip(*conn, "World");
+
+    reactor.stop();
+    CHECK(closed == 1);
+
+    server.close();
+}
+
+#ifdef __linux__
+TEST_CASE("Reactor sheds connections while out of descriptors") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    Reactor reactor;
+    TCPServer server(*port);
+    std::atomic_int accepted{0};
+    server.attach(reactor, [&accepted](SimpleConnection&) {
+        ++accepted;
+        return ReactorCallbacks{};
+    });
+    reactor.start();
+
+    TCPClientContext ctx;
+    auto first = ctx.connect("127.0.0.1", *port);
+    REQUIRE(first);
+    REQUIRE(simple_socket::test::waitFor([&] { return accepted == 1; }));
+
+    {
+        // the last descriptor goes to the client, leaving none to accept its connection with
+        const simple_socket::test::DescriptorLimit limit(1);
+        auto client = ctx.connect("127.0.0.1", *port);
+        REQUIRE(client);
+
+        unsigned char byte;
+        const auto result = client->readFor(&byte, 1, std::chrono::seconds(2));
+        CHECK((result.status == IoStatus::Closed || result.status == IoStatus::Error));
+        CHECK(accepted == 1);
+    }
+
+    auto last = ctx.connect("127.0.0.1", *port);
+    REQUIRE(last);
+    CHECK(simple_socket::test::waitFor([&] { return accepted == 2; }));
+
+    reactor.stop();
+    server.close();
+}
+#endif
@@ -0,0 +1,81 @@
+
+#include "simple_socket/BufferedConnection.hpp"
+#include "simple_socket/Relay.hpp"
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+namespace {
+
+    void echo(std::unique_ptr<SimpleConnection> conn) {
+
+        std::vector<uint8_t> buffer(4096);
+        int n;
+        while ((n = conn->read(buffer)) > 0) {
+            if (!conn->write(buffer.data(), n)) break;
+        }
+    }
+
+}// namespace
+
+TEST_CASE("TCP relay") {
+
+    const auto upstreamPort = getAvailablePort(8000, 9000);
+    REQUIRE(upstreamPort);
+    TCPServer upstream(*upstreamPort);
+
+    const auto proxyPort = getAvailablePort(9000, 10000);
+    REQUIRE(proxyPort);
+    TCPServer proxy(*proxyPort);
+
+    std::thread upstreamThread([&upstream] { echo(upstream.accept()); });
+
+    std::unique_ptr<Relay> relay;
+    std::thread proxyThread([&] {
+        // peek at a greeting first, whatever else was buffered must still be forwarded
+        auto conn = std::make_unique<BufferedConnection>(proxy.accept());
+        std::string greeting;
+        REQUIRE(conn->readUntil("\n", greeting));
+        CHECK(greeting == "hello\n");
+
+        TCPClientContext ctx;
+        auto upstreamConn = ctx.connect("127.0.0.1", *upstreamPort);
+        REQUIRE(upstreamConn);
+
+        relay = std::make_unique<Relay>(std::move(conn), std::move(upstreamConn));
+        relay->run();
+    });
+
+    TCPClientContext ctx;
+    const auto conn = ctx.connect("127.0.0.1", *proxyPort);
+    REQUIRE(conn);
+
+    std::vector<uint8_t> payload(4 * 1024 * 1024);
+    std::iota(payload.begin(), payload.end(), static_cast<uint8_t>(0));
+
+    std::thread writer([&] {
+        REQUIRE(conn->writev({ConstBuffer("hello\n", 6), ConstBuffer(payload)}));
+    });
+
+    std::vector<uint8_t> received(payload.size());
+    REQUIRE(conn->readExact(received));
+    CHECK(received == payload);
+    writer.join();
+
+    conn->close();
+    proxyThread.join();
+    upstreamThread.join();
+
+    CHECK(relay->bytesForwarded() == payload.size());
+    CHECK(relay->bytesReturned() == payload.size());
+
+    upstream.close();
+    proxy.close();
+}
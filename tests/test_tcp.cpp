@@ -1,7 +1,13 @@
 
+#include "simple_socket/BufferedConnection.hpp"
 #include "simple_socket/TCPSocket.hpp"
 #include "simple_socket/util/port_query.hpp"
 
+#include "test_util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -128,3 +134,567 @@ TEST_CASE("TCP readexact/write") {
     server.close();
     serverThread.join();
 }
+
+TEST_CASE("TCP writev/readv") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+
+    std::thread serverThread([&server] {
+        std::unique_ptr<SimpleConnection> conn;
+        REQUIRE_NOTHROW(conn = server.accept());
+
+        // header and body land in separate buffers
+        uint8_t header[2];
+        std::vector<uint8_t> body(5);
+        size_t received = 0;
+        while (received < sizeof(header) + body.size()) {
+            int n;
+            if (received < sizeof(header)) {
+                n = conn->readv({MutableBuffer{header + received, sizeof(header) - received},
+                                 MutableBuffer{body.data(), body.size()}});
+            } else {
+                n = conn->read(body.data() + (received - sizeof(header)), body.size() - (received - sizeof(header)));
+            }
+            REQUIRE(n > 0);
+            received += n;
+        }
+        CHECK(header[0] == 'h');
+        CHECK(header[1] == ':');
+        CHECK(std::string(body.begin(), body.end()) == "hello");
+
+        REQUIRE(conn->writev({ConstBuffer("Hello ", 6), ConstBuffer(std::string("Per")), ConstBuffer("!", 1)}));
+    });
+
+    TCPClientContext client;
+    const auto conn = client.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+
+    const std::string body = "hello";
+    REQUIRE(conn->writev({ConstBuffer("h:", 2), ConstBuffer(body)}));
+
+    const std::string expectedResponse = generateResponse(generateMessage());
+    std::vector<unsigned char> buffer(expectedResponse.size());
+    REQUIRE(conn->readExact(buffer));
+    CHECK(std::string(buffer.begin(), buffer.end()) == expectedResponse);
+
+    serverThread.join();
+    server.close();
+}
+
+TEST_CASE("TCP writev/readv with many buffers") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+    TCPClientContext client;
+    const auto conn = client.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+    const auto serverConn = server.accept();
+    REQUIRE(serverConn);
+
+    // more buffers than go into one system call
+    constexpr size_t numBuffers = 200;
+    constexpr size_t size = 10;
+    std::vector<std::vector<uint8_t>> sent(numBuffers);
+    std::vector<ConstBuffer> gather;
+    for (size_t i = 0; i < numBuffers; ++i) {
+        sent[i].assign(size, static_cast<uint8_t>(i));
+        gather.emplace_back(sent[i].data(), size);
+    }
+    REQUIRE(conn->writev(gather));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::vector<std::vector<uint8_t>> received(numBuffers, std::vector<uint8_t>(size));
+    std::vector<MutableBuffer> scatter;
+    for (auto& buffer : received) scatter.push_back({buffer.data(), buffer.size()});
+
+    // everything already arrived, so a single readv fills all buffers
+    CHECK(serverConn->readv(scatter) == static_cast<int>(numBuffers * size));
+    CHECK(received == sent);
+
+    server.close();
+}
+
+TEST_CASE("TCP read with deadline") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+
+    TCPClientContext client;
+    const auto conn = client.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+
+    auto serverConn = server.accept();
+    REQUIRE(serverConn);
+
+    std::vector<uint8_t> buffer(8);
+
+    // nothing sent yet
+    const auto t0 = std::chrono::steady_clock::now();
+    auto result = serverConn->readFor(buffer.data(), buffer.size(), std::chrono::milliseconds(50));
+    CHECK(result.status == IoStatus::Timeout);
+    CHECK(std::chrono::steady_clock::now() - t0 >= std::chrono::milliseconds(50));
+
+    // a partial message times out, but keeps what did arrive
+    REQUIRE(conn->writeFor(reinterpret_cast<const uint8_t*>("Hell"), 4, std::chrono::seconds(1)));
+    result = serverConn->readExactFor(buffer.data(), 5, std::chrono::milliseconds(100));
+    CHECK(result.status == IoStatus::Timeout);
+    CHECK(result.bytes == 4);
+
+    REQUIRE(conn->write("o"));
+    result = serverConn->readExactFor(buffer.data() + 4, 1, std::chrono::seconds(1));
+    REQUIRE(result);
+    CHECK(std::string(buffer.begin(), buffer.begin() + 5) == "Hello");
+
+    conn->close();
+    result = serverConn->readFor(buffer.data(), buffer.size(), std::chrono::seconds(1));
+    CHECK(result.status == IoStatus::Closed);
+
+    server.close();
+}
+
+TEST_CASE("TCP buffered reads") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+
+    TCPClientContext client;
+    const auto conn = client.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+
+    BufferedConnection buffered(server.accept(), 16);
+
+    // a header block followed by a length prefixed body, sent in one go
+    REQUIRE(conn->write("GET / HTTP/1.1\r\nHost: x\r\n\r\n\x05hello!"));
+
+    std::string headers;
+    REQUIRE(buffered.readUntil("\r\n\r\n", headers));
+    CHECK(headers == "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+
+    const auto prefix = buffered.peek(1);
+    REQUIRE(prefix.size() == 1);
+    CHECK(prefix[0] == 5);
+    uint8_t length;
+    REQUIRE(buffered.readExact(&length, 1));
+
+    std::vector<uint8_t> body(length);
+    REQUIRE(buffered.readExact(body));
+    CHECK(std::string(body.begin(), body.end()) == "hello");
+
+    std::string line;
+    CHECK_FALSE(buffered.readUntil("\n", line, 1));
+    CHECK(buffered.buffered() == 1);
+
+    conn->close();
+    uint8_t last[8];
+    CHECK(buffered.read(last, sizeof(last)) == 1);
+    CHECK(last[0] == '!');
+    CHECK(buffered.read(last, sizeof(last)) == -1);
+
+    server.close();
+}
+
+TEST_CASE("TCP ownership transferring writes") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+
+    TCPClientContext client;
+    const auto conn = client.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+    auto serverConn = server.accept();
+    REQUIRE(serverConn);
+
+    // not supported everywhere, the writes below must work either way
+    const bool zeroCopy = conn->enableZeroCopy();
+    INFO("zero-copy: " << zeroCopy);
+
+    constexpr size_t size = 256 * 1024;
+    constexpr int numWrites = 8;
+
+    std::thread reader([&] {
+        std::vector<uint8_t> buffer(size);
+        for (int i = 0; i < numWrites + 1; ++i) {
+            REQUIRE(serverConn->readExact(buffer));
+            CHECK(buffer.front() == static_cast<uint8_t>(i));
+            CHECK(buffer.back() == static_cast<uint8_t>(i));
+        }
+    });
+
+    std::vector<std::vector<uint8_t>> released;
+    for (int i = 0; i < numWrites; ++i) {
+        REQUIRE(conn->writeOwned(std::vector<uint8_t>(size, static_cast<uint8_t>(i)),
+                                 [&released](std::vector<uint8_t> buffer) { released.push_back(std::move(buffer)); }));
+    }
+    // a plain write may reuse its buffer right away
+    std::vector<uint8_t> last(size, static_cast<uint8_t>(numWrites));
+    REQUIRE(conn->write(last));
+    std::ranges::fill(last, 0);
+
+    conn->flush();
+    CHECK(released.size() == numWrites);
+    for (const auto& buffer : released) CHECK(buffer.size() == size);
+
+    reader.join();
+    server.close();
+}
+
+TEST_CASE("TCP server group") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServerGroup group(*port, 4);
+    CHECK(group.size() == 4);
+
+    std::mutex m;
+    std::vector<std::thread> handlers;
+    group.start([&](std::unique_ptr<SimpleConnection> conn) {
+        std::lock_guard lock(m);
+        handlers.emplace_back(socketHandler, std::move(conn));
+    });
+
+    constexpr int numClients = 32;
+    std::vector<std::thread> clients;
+    for (int i = 0; i < numClients; ++i) {
+        clients.emplace_back([port] {
+            TCPClientContext ctx;
+            const auto conn = ctx.connect("127.0.0.1", *port);
+            REQUIRE(conn);
+
+            REQUIRE(conn->write(generateMessage()));
+            const std::string expectedResponse = generateResponse(generateMessage());
+            std::vector<unsigned char> buffer(expectedResponse.size());
+            REQUIRE(conn->readExact(buffer));
+            CHECK(std::string(buffer.begin(), buffer.end()) == expectedResponse);
+        });
+    }
+    for (auto& t : clients) t.join();
+
+    group.close();
+    for (auto& t : handlers) t.join();
+    CHECK(handlers.size() == numClients);
+}
+
+TEST_CASE("TCP socket options") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    SocketOptions options;
+    options.noDelay = true;
+    options.keepAlive = true;
+    options.quickAck = true;
+    options.notSentLowWatermark = 16 * 1024;
+    options.sendBufferSize = 256 * 1024;
+    options.receiveBufferSize = 256 * 1024;
+
+    TCPServer server(*port, 1, false, options);
+    std::thread serverThread([&server] {
+        socketHandler(server.accept());
+    });
+
+    TCPClientContext client(options);
+    const auto conn = client.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+
+    REQUIRE(conn->write(generateMessage()));
+    const std::string expectedResponse = generateResponse(generateMessage());
+    std::vector<unsigned char> buffer(expectedResponse.size());
+    REQUIRE(conn->readExact(buffer));
+    CHECK(std::string(buffer.begin(), buffer.end()) == expectedResponse);
+
+    serverThread.join();
+    server.close();
+}
+
+#ifdef __linux__
+TEST_CASE("TCP transmit timestamps") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+
+    SocketOptions options;
+    options.timestamps = true;
+    options.noDelay = true;
+    TCPClientContext client(options);
+    auto connection = client.connect("127.0.0.1", *port);
+    REQUIRE(connection);
+    // through the connection wrappers as well
+    const auto conn = std::make_unique<BufferedConnection>(std::move(connection));
+    auto serverConn = server.accept();
+    REQUIRE(serverConn);
+
+    const auto before = std::chrono::system_clock::now();
+    const std::string message(1000, 'x');
+    constexpr int numWrites = 3;
+    for (int i = 0; i < numWrites; ++i) REQUIRE(conn->write(message));
+
+    std::vector<uint8_t> buffer(numWrites * message.size());
+    REQUIRE(serverConn->readExact(buffer));
+    const auto after = std::chrono::system_clock::now();
+
+    // writes that went out together share a timestamp, the last one is always reported
+    constexpr uint32_t lastByte = numWrites * 1000 - 1;
+    std::vector<TxTimestamp> sent;
+    for (int attempt = 0; attempt < 100 && (sent.empty() || sent.back().id != lastByte); ++attempt) {
+        TxTimestamp timestamps[8];
+        const auto n = conn->readTxTimestamps(timestamps);
+        sent.insert(sent.end(), timestamps, timestamps + n);
+        if (n == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(!sent.empty());
+    CHECK(sent.back().id == lastByte);
+    for (size_t i = 0; i < sent.size(); ++i) {
+        CHECK(sent[i].time >= before - std::chrono::milliseconds(10));
+        CHECK(sent[i].time <= after + std::chrono::milliseconds(10));
+        if (i > 0) CHECK(sent[i].id > sent[i - 1].id);
+    }
+
+    // not enabled on the accepting side
+    TxTimestamp timestamp;
+    REQUIRE(serverConn->write(message));
+    CHECK(serverConn->readTxTimestamps(std::span(&timestamp, 1)) == 0);
+
+    server.close();
+}
+#endif
+
+TEST_CASE("TCP connect timeout and fallback") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port);
+    std::thread serverThread([&server] {
+        socketHandler(server.accept());
+    });
+
+    TCPClientContext client;
+    client.setConnectTimeout(std::chrono::milliseconds(500));
+
+    // localhost may resolve to ::1 first, which the IPv4 only server refuses
+    const auto conn = client.connect("localhost", *port);
+    REQUIRE(conn);
+    REQUIRE(conn->write(generateMessage()));
+    const std::string expectedResponse = generateResponse(generateMessage());
+    std::vector<unsigned char> buffer(expectedResponse.size());
+    REQUIRE(conn->readExact(buffer));
+
+    serverThread.join();
+    server.close();
+
+    // unroutable address: either unreachable right away or cut short by the timeout
+    const auto t0 = std::chrono::steady_clock::now();
+    CHECK_FALSE(client.connect("10.255.255.1", *port));
+    CHECK(std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2));
+}
+
+TEST_CASE("TCP connection pool") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    TCPServer server(*port, 8);
+    std::atomic_int accepted{0};
+    std::mutex serverConnsMutex;
+    std::vector<std::unique_ptr<SimpleConnection>> serverConns;// guarded by serverConnsMutex
+    std::vector<std::thread> handlers;
+    std::thread serverThread([&] {
+        try {
+            while (true) {
+                auto conn = server.accept();
+                auto* c = conn.get();
+                {
+                    std::lock_guard lock(serverConnsMutex);
+                    serverConns.emplace_back(std::move(conn));
+                }
+                ++accepted;
+                handlers.emplace_back([c] {
+                    uint8_t byte;
+                    while (c->read(&byte, 1) == 1 && c->write(&byte, 1)) {}
+                });
+            }
+        } catch (const std::exception&) {}
+    });
+
+    TCPClientContext client;
+    client.setConnectTimeout(std::chrono::milliseconds(200));
+    PoolOptions poolOptions;
+    poolOptions.maxPerHost = 1;
+    client.setPoolOptions(poolOptions);
+
+    const auto roundTrip = [](SimpleConnection& conn) {
+        uint8_t byte = 42;
+        return conn.write(&byte, 1) && conn.readExact(&byte, 1) && byte == 42;
+    };
+
+    {
+        const auto conn = client.acquire("127.0.0.1", *port);
+        REQUIRE(conn);
+        CHECK(roundTrip(*conn));
+
+        // at the per host limit
+        CHECK_FALSE(client.acquire("127.0.0.1", *port));
+    }
+    {
+        const auto conn = client.acquire("127.0.0.1", *port);
+        REQUIRE(conn);
+        CHECK(roundTrip(*conn));
+        CHECK(accepted == 1);// reused
+        conn->close();       // not returned
+    }
+    {
+        const auto conn = client.acquire("127.0.0.1", *port);
+        REQUIRE(conn);
+        CHECK(roundTrip(*conn));
+        CHECK(accepted == 2);
+    }
+
+    // the server hangs up on the idle connection, the health check notices
+    {
+        std::lock_guard lock(serverConnsMutex);
+        serverConns.back()->close();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+        const auto conn = client.acquire("127.0.0.1", *port);
+        REQUIRE(conn);
+        CHECK(roundTrip(*conn));
+        CHECK(accepted == 3);
+    }
+
+    server.close();
+    serverThread.join();
+    for (auto& c : serverConns) c->close();
+    for (auto& t : handlers) t.join();
+}
+
+TEST_CASE("TCP accept batch") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    SocketOptions options;
+    options.deferAccept = 1;
+    TCPServer server(*port, 16, false, options);
+
+    constexpr int numClients = 8;
+    TCPClientContext client;
+    std::vector<std::unique_ptr<SimpleConnection>> clients;
+    for (int i = 0; i < numClients; ++i) {
+        auto conn = client.connect("127.0.0.1", *port);
+        REQUIRE(conn);
+        REQUIRE(conn->write(generateMessage()));
+        clients.emplace_back(std::move(conn));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // all of them are pending, one call takes them
+    auto batch = server.acceptBatch();
+    CHECK(batch.size() == numClients);
+    for (auto& conn : batch) {
+        socketHandler(std::move(conn));
+    }
+
+    // blocking accept still works on the now non-blocking listener
+    std::thread late([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto conn = client.connect("127.0.0.1", *port);
+        REQUIRE(conn);
+        REQUIRE(conn->write(generateMessage()));
+        clients.emplace_back(std::move(conn));
+    });
+    socketHandler(server.accept());
+    late.join();
+
+    // closing wakes up a waiting acceptor
+    std::thread closer([&server] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        server.close();
+    });
+    CHECK_THROWS(server.acceptBatch());
+    closer.join();
+}
+
+TEST_CASE("TCP server close with waiting acceptors") {
+
+    // close() right as the acceptors start waiting, or while they are
+    for (int round = 0; round < 20; ++round) {
+        const auto port = getAvailablePort(8000, 9000);
+        REQUIRE(port);
+        TCPServer server(*port);
+
+        std::atomic_int failed{0};
+        std::vector<std::thread> acceptors;
+        for (int i = 0; i < 4; ++i) {
+            acceptors.emplace_back([&server, &failed, i] {
+                try {
+                    if (i % 2 == 0) {
+                        (void) server.acceptBatch();
+                    } else {
+                        (void) server.accept();
+                    }
+                } catch (const std::exception&) {
+                    ++failed;
+                }
+            });
+        }
+        if (round % 2 == 1) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        server.close();
+        for (auto& t : acceptors) t.join();
+        CHECK(failed == 4);
+        CHECK_THROWS(server.accept());
+    }
+}
+
+#ifdef __linux__
+TEST_CASE("TCP accept backs off while out of descriptors") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+    TCPServer server(*port);
+    TCPClientContext ctx;
+    auto client = ctx.connect("127.0.0.1", *port);
+    REQUIRE(client);
+
+    std::atomic_bool accepted{false};
+    std::unique_ptr<SimpleConnection> conn;
+    std::thread acceptor;
+    {
+        const simple_socket::test::DescriptorLimit limit;
+        acceptor = std::thread([&] {
+            try {
+                conn = server.accept();
+            } catch (const std::exception&) {
+            }
+            accepted = true;
+        });
+        // EMFILE leaves the connection queued instead of failing the accept
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        CHECK(!accepted);
+    }
+
+    CHECK(simple_socket::test::waitFor([&] { return accepted.load(); }, std::chrono::seconds(2)));
+    acceptor.join();
+    REQUIRE(conn);
+    REQUIRE(client->write(std::string("x")));
+    unsigned char byte;
+    CHECK(conn->readExact(&byte, 1));
+
+    server.close();
+}
+#endif
@@ -0,0 +1,153 @@
+
+#include "simple_socket/TimerWheel.hpp"
+
+#ifdef SIMPLE_SOCKET_WITH_MQTT
+#include "simple_socket/TCPSocket.hpp"
+#include "simple_socket/mqtt/MQTTBroker.hpp"
+#include "simple_socket/util/port_query.hpp"
+#endif
+
+#include "test_util.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+using simple_socket::test::waitFor;
+
+TEST_CASE("Timers fire in deadline order, not before their deadline") {
+
+    TimerWheel wheel(std::chrono::milliseconds(1));
+
+    std::mutex mutex;
+    std::vector<int> order;
+    std::vector<std::chrono::milliseconds> elapsed;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const int delay : {300, 20, 600, 0, 100}) {// the longer ones start out on the second level
+        wheel.schedule(std::chrono::milliseconds(delay), [&, delay] {
+            std::lock_guard lock(mutex);
+            order.push_back(delay);
+            elapsed.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start));
+        });
+    }
+    CHECK(wheel.pending() == 5);
+
+    REQUIRE(waitFor([&] { return wheel.pending() == 0; }));
+    std::lock_guard lock(mutex);
+    CHECK(order == std::vector<int>{0, 20, 100, 300, 600});
+    for (size_t i = 0; i < order.size(); ++i) {
+        CHECK(elapsed[i] >= std::chrono::milliseconds(order[i]));
+    }
+}
+
+TEST_CASE("Timers can be cancelled and rescheduled") {
+
+    TimerWheel wheel(std::chrono::milliseconds(1));
+
+    std::atomic_int fired{0};
+    const auto cancelled = wheel.schedule(std::chrono::milliseconds(50), [&] { fired += 1; });
+    const auto moved = wheel.schedule(std::chrono::milliseconds(50), [&] { fired += 10; });
+
+    CHECK(wheel.cancel(cancelled));
+    CHECK_FALSE(wheel.cancel(cancelled));
+    CHECK(wheel.reschedule(moved, std::chrono::milliseconds(300)));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    CHECK(fired == 0);
+    REQUIRE(waitFor([&] { return fired == 10; }));
+
+    // fired timers are gone, their ids are not reused
+    CHECK_FALSE(wheel.cancel(moved));
+    CHECK_FALSE(wheel.reschedule(moved, std::chrono::milliseconds(1)));
+    const auto next = wheel.schedule(std::chrono::seconds(10), [] {});
+    CHECK(next != moved);
+    CHECK_FALSE(wheel.cancel(moved));
+    CHECK(wheel.cancel(next));
+}
+
+TEST_CASE("Cancel waits for a running callback") {
+
+    TimerWheel wheel(std::chrono::milliseconds(1));
+
+    std::atomic_bool started{false};
+    std::atomic_bool finished{false};
+    const auto timer = wheel.schedule(std::chrono::milliseconds(0), [&] {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        finished = true;
+    });
+
+    REQUIRE(waitFor([&] { return started.load(); }));
+    CHECK_FALSE(wheel.cancel(timer));
+    CHECK(finished);
+}
+
+TEST_CASE("Timer wheel handles many timers") {
+
+    TimerWheel wheel;
+
+    constexpr size_t count = 200000;
+    std::atomic_size_t fired{0};
+    std::vector<TimerWheel::TimerId> timers;
+    timers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        // spread over all levels, from seconds to days
+        timers.push_back(wheel.schedule(std::chrono::seconds(10) + std::chrono::seconds(i * 3), [&] { ++fired; }));
+    }
+    CHECK(wheel.pending() == count);
+
+    // like idle timeouts: most are pushed back by activity, some connections close
+    size_t failures = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!wheel.reschedule(timers[i], std::chrono::hours(1))) ++failures;
+        if (i % 10 != 0 && !wheel.cancel(timers[i])) ++failures;
+    }
+    CHECK(failures == 0);
+    CHECK(wheel.pending() == count / 10);
+
+    wheel.schedule(std::chrono::milliseconds(50), [&] { ++fired; });
+    CHECK(waitFor([&] { return fired == 1; }));
+    CHECK(wheel.pending() == count / 10);
+}
+
+#ifdef SIMPLE_SOCKET_WITH_MQTT
+TEST_CASE("MQTT broker disconnects clients that exceed their keepalive") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    MQTTBroker broker(*port);
+    broker.start();
+
+    TCPClientContext ctx;
+    auto conn = test::mqttConnect(ctx, *port, 'k', 1);
+
+    // pings keep the session alive past the keepalive
+    for (int i = 0; i < 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        const uint8_t ping[] = {0xC0, 0x00};
+        REQUIRE(conn->write(ping, sizeof(ping)));
+        uint8_t pong[2];
+        REQUIRE(conn->readExact(pong, sizeof(pong)));
+        CHECK(pong[0] == 0xD0);
+    }
+
+    // silence gets it closed after one and a half keepalive periods
+    const auto start = std::chrono::steady_clock::now();
+    uint8_t byte;
+    const auto result = conn->readFor(&byte, 1, std::chrono::seconds(5));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK(result.status == IoStatus::Closed);
+    CHECK(elapsed >= std::chrono::milliseconds(1400));
+    CHECK(elapsed < std::chrono::seconds(3));
+
+    broker.stop();
+}
+#endif
@@ -0,0 +1,132 @@
+
+#include "simple_socket/UDPMessageSocket.hpp"
+#include "simple_socket/util/port_query.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+using namespace simple_socket;
+
+namespace {
+
+    std::vector<uint8_t> pattern(size_t size) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i) data[i] = static_cast<uint8_t>(i * 31 + i / 251);
+        return data;
+    }
+
+}// namespace
+
+TEST_CASE("UDP messages are fragmented and reassembled") {
+
+    const auto serverPort = getAvailablePort(8000, 9000);
+    const auto clientPort = getAvailablePort(8000, 9000, {*serverPort});
+
+    REQUIRE(serverPort);
+    REQUIRE(clientPort);
+
+    UDPSocket socket1(*serverPort);
+    UDPSocket socket2(*clientPort);
+
+    // paced, so that the default socket buffers hold the fragments until the receiver gets to them
+    UDPMessageSocket sender(socket1, {.maxBytesPerSecond = 10 * 1024 * 1024});
+    UDPMessageSocket receiver(socket2);
+    const Endpoint to("127.0.0.1", *clientPort);
+
+    std::vector<uint8_t> message;
+    Endpoint from;
+
+    const auto small = pattern(100);
+    REQUIRE(sender.send(to, small));
+    REQUIRE(receiver.receive(message, from));
+    CHECK(message == small);
+    CHECK(from == Endpoint("127.0.0.1", *serverPort));
+
+    // several hundred fragments, received concurrently. UDP may still drop one on a loaded machine, which loses
+    // the message, so it is sent again a few times until one copy makes it
+    const auto large = pattern(1024 * 1024 + 17);
+    std::atomic_bool received{false};
+    std::thread reader([&] {
+        while (receiver.receive(message, from)) {
+            if (message.size() == large.size()) {
+                received = true;
+                return;
+            }
+        }
+    });
+    for (int attempt = 0; attempt < 5 && !received; ++attempt) {
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(sender.send(to, large));
+        CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(80));
+        for (int i = 0; i < 20 && !received; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    if (!received) socket2.close();
+    reader.join();
+    REQUIRE(received);
+    CHECK(message == large);
+
+    CHECK_FALSE(sender.send(to, std::vector<uint8_t>{}));
+    UDPMessageSocket limited(socket1, {.maxMessageSize = 1000});
+    CHECK_FALSE(limited.send(to, pattern(1001)));
+}
+
+TEST_CASE("UDP message reassembly drops incomplete messages") {
+
+    const auto serverPort = getAvailablePort(8000, 9000);
+    const auto clientPort = getAvailablePort(8000, 9000, {*serverPort});
+
+    REQUIRE(serverPort);
+    REQUIRE(clientPort);
+
+    UDPSocket socket1(*serverPort);
+    UDPSocket socket2(*clientPort);
+
+    UDPMessageSocket sender(socket1);
+    UDPMessageSocket receiver(socket2, {.reassemblyTimeout = std::chrono::milliseconds(50)});
+    const Endpoint to("127.0.0.1", *clientPort);
+
+    // the first of two fragments (stride 4, id 7, size 8, offset 0), the second one is "lost"
+    const std::vector<uint8_t> fragment{0x55, 0x4D, 0, 4, 0, 0, 0, 7, 0, 0, 0, 8, 0, 0, 0, 0, 'a', 'b', 'c', 'd'};
+    REQUIRE(socket1.sendTo(to, fragment));
+    // not a fragment at all
+    REQUIRE(socket1.sendTo(to, "Hello"));
+
+    const auto data = pattern(5000);
+    REQUIRE(sender.send(to, data));
+
+    std::vector<uint8_t> message;
+    Endpoint from;
+    REQUIRE(receiver.receive(message, from));
+    CHECK(message == data);
+    CHECK(receiver.dropped() == 0);
+
+    // the incomplete message is evicted once no fragment arrived for longer than the timeout
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    REQUIRE(sender.send(to, data));
+    REQUIRE(receiver.receive(message, from));
+    CHECK(message == data);
+    CHECK(receiver.dropped() == 1);
+
+    // one fragment every 10 ms: the whole message takes several timeouts, but is never idle for one
+    UDPMessageOptions options;
+    options.maxBytesPerSecond = 140 * 1000;
+    UDPMessageSocket paced(socket1, options);
+    const auto slow = pattern(30 * 1000);
+    std::atomic_bool received{false};
+    std::thread reader([&] {
+        received = receiver.receive(message, from);
+    });
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(paced.send(to, slow));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(150));
+    for (int i = 0; i < 40 && !received; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if (!received) socket2.close();
+    reader.join();
+    REQUIRE(received);
+    CHECK(message == slow);
+    CHECK(receiver.dropped() == 1);
+}
@@ -0,0 +1,89 @@
+#ifndef SIMPLE_SOCKET_TEST_UTIL_HPP
+#define SIMPLE_SOCKET_TEST_UTIL_HPP
+
+#include "simple_socket/TCPSocket.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace simple_socket::test {
+
+    // Polls (sleeping does not allocate) until the condition holds or the timeout expires.
+    template<class Condition>
+    bool waitFor(Condition condition, std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // Raw MQTT 3.1.1 session for tests that need to control the bytes on the wire (or stop reading),
+    // which MQTTClient does not allow.
+    inline std::unique_ptr<SimpleConnection> mqttConnect(TCPClientContext& ctx, uint16_t port, char clientId, uint16_t keepAliveSeconds = 60) {
+        auto conn = ctx.connect("127.0.0.1", port);
+        REQUIRE(conn);
+        const uint8_t packet[] = {0x10, 13, 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02,
+                                  static_cast<uint8_t>(keepAliveSeconds >> 8), static_cast<uint8_t>(keepAliveSeconds & 0xFF),
+                                  0x00, 0x01, static_cast<uint8_t>(clientId)};
+        REQUIRE(conn->write(packet, sizeof(packet)));
+        uint8_t connack[4];
+        REQUIRE(conn->readExact(connack, sizeof(connack)));
+        return conn;
+    }
+
+    // QoS 0 subscription, waits for the SUBACK.
+    inline void mqttSubscribe(SimpleConnection& conn, const std::string& topic = "a/b") {
+        REQUIRE(topic.size() < 120);
+        std::vector<uint8_t> packet{0x82, static_cast<uint8_t>(5 + topic.size()), 0x00, 0x01, 0x00, static_cast<uint8_t>(topic.size())};
+        packet.insert(packet.end(), topic.begin(), topic.end());
+        packet.push_back(0x00);
+        REQUIRE(conn.write(packet));
+        uint8_t suback[5];
+        REQUIRE(conn.readExact(suback, sizeof(suback)));
+    }
+
+#ifdef __linux__
+    // Lowers the soft descriptor limit so that opening more than `available` further descriptors fails with EMFILE,
+    // restores it when destroyed.
+    class DescriptorLimit {
+    public:
+        explicit DescriptorLimit(int available = 0) {
+            REQUIRE(getrlimit(RLIMIT_NOFILE, &original_) == 0);
+            // new descriptors get the lowest free number, any at or above the limit is refused
+            const int lowest = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+            REQUIRE(lowest >= 0);
+            ::close(lowest);
+            rlimit limited = original_;
+            limited.rlim_cur = lowest + available;
+            REQUIRE(setrlimit(RLIMIT_NOFILE, &limited) == 0);
+        }
+
+        DescriptorLimit(const DescriptorLimit&) = delete;
+        DescriptorLimit& operator=(const DescriptorLimit&) = delete;
+
+        ~DescriptorLimit() {
+            setrlimit(RLIMIT_NOFILE, &original_);
+        }
+
+    private:
+        rlimit original_{};
+    };
+#endif
+
+}// namespace simple_socket::test
+
+#endif//SIMPLE_SOCKET_TEST_UTIL_HPP
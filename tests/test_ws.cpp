@@ -1,10 +1,15 @@
 
 #include "../include/simple_socket/ws/WebSocket.hpp"
+#include "simple_socket/TCPSocket.hpp"
 #include "simple_socket/util/port_query.hpp"
 
+#include "test_util.hpp"
+
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <string>
 #include <thread>
 
 #include <catch2/catch_test_macros.hpp>
@@ -92,3 +97,68 @@ TEST_CASE("test Websocket") {
     CHECK(servermsg == "Hello from client!");
     CHECK(clientmsg == "Hello from server!");
 }
+
+TEST_CASE("Websocket pings keep a quiet connection open") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    std::atomic_bool serverClose{false};
+    std::atomic_bool clientOpen{false};
+
+    WebSocket ws(*port);
+    ws.setKeepAlive(std::chrono::milliseconds(100), std::chrono::milliseconds(500));
+    ws.onClose = [&](auto) { serverClose = true; };
+    ws.start();
+
+    WebSocketClient client;
+    client.onOpen = [&](auto) { clientOpen = true; };
+    client.connect("ws://127.0.0.1:" + std::to_string(*port));
+    REQUIRE(test::waitFor([&] { return clientOpen.load(); }));
+
+    // neither side sends anything, the client's pongs are the only traffic
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    CHECK_FALSE(serverClose);
+    CHECK(ws.metrics().messagesIn >= 5);
+
+    client.close();
+    ws.stop();
+}
+
+TEST_CASE("Websocket closes a peer that stopped answering pings") {
+
+    const auto port = getAvailablePort(8000, 9000);
+    REQUIRE(port);
+
+    std::atomic_bool serverClose{false};
+
+    WebSocket ws(*port);
+    ws.setKeepAlive(std::chrono::milliseconds(100), std::chrono::milliseconds(500));
+    ws.onClose = [&](auto) { serverClose = true; };
+    ws.start();
+
+    // completes the upgrade and then never reads or answers again
+    TCPClientContext ctx;
+    auto conn = ctx.connect("127.0.0.1", *port);
+    REQUIRE(conn);
+    const std::string request = "GET / HTTP/1.1\r\n"
+                                "Host: 127.0.0.1\r\n"
+                                "Upgrade: websocket\r\n"
+                                "Connection: Upgrade\r\n"
+                                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                                "Sec-WebSocket-Version: 13\r\n\r\n";
+    REQUIRE(conn->write(request));
+    std::string response;
+    uint8_t byte;
+    while (response.find("\r\n\r\n") == std::string::npos && conn->readExact(&byte, 1)) {
+        response += static_cast<char>(byte);
+    }
+    REQUIRE(response.starts_with("HTTP/1.1 101"));
+
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(test::waitFor([&] { return serverClose.load(); }, std::chrono::seconds(3)));
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(400));
+
+    conn->close();
+    ws.stop();
+}